@@ -0,0 +1,92 @@
+// Helpers shared by the benchmark drivers.
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
+#include <string>
+
+#include "data_structure.hpp"
+
+// k x k cells, one random triangle per cell
+inline std::vector<Polygon> triangleGrid(int k, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> u(0.1, 0.9);
+    std::vector<Polygon> polygons;
+    for (int i = 0; i < k; i++) {
+        for (int j = 0; j < k; j++) {
+            Polygon p;
+            p.addVertex(i + u(rng) * 0.4, j + u(rng) * 0.4);
+            p.addVertex(i + 0.5 + u(rng) * 0.4, j + u(rng) * 0.4);
+            p.addVertex(i + 0.3 + u(rng) * 0.4, j + 0.5 + u(rng) * 0.4);
+            polygons.push_back(p);
+        }
+    }
+    return polygons;
+}
+
+template <typename F>
+double bestOf(int runs, F f) {
+    double best = 1e30;
+    for (int r = 0; r < runs; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+    }
+    return best;
+}
+
+// Latency distribution of one kernel, in microseconds per call
+struct Percentiles {
+    size_t samples;
+    double min, p50, p90, p99, max;
+};
+
+inline Percentiles percentiles(std::vector<double> samples) {
+    Percentiles p = {samples.size(), 0, 0, 0, 0, 0};
+    if (samples.empty()) return p;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1))]; };
+    p.min = samples.front();
+    p.p50 = at(0.5);
+    p.p90 = at(0.9);
+    p.p99 = at(0.99);
+    p.max = samples.back();
+    return p;
+}
+
+// Run f warmup times untimed, then reps timed samples. Each call of f runs
+// batch calls of the kernel, so kernels far below the clock's resolution
+// are timed over a batch and reported per call.
+template <typename F>
+Percentiles sampleKernel(int warmup, int reps, size_t batch, F f) {
+    for (int r = 0; r < warmup; r++) f();
+    std::vector<double> samples(reps);
+    for (int r = 0; r < reps; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        samples[r] = std::chrono::duration<double, std::micro>(t1 - t0).count() / batch;
+    }
+    return percentiles(samples);
+}
+
+inline void printKernelHeader() {
+    std::cout << std::left << std::setw(36) << "kernel (us per call)" << std::right
+              << std::setw(9) << "samples" << std::setw(11) << "min" << std::setw(11) << "p50"
+              << std::setw(11) << "p90" << std::setw(11) << "p99" << std::setw(11) << "max"
+              << std::endl;
+}
+
+inline void printKernel(const std::string& name, const Percentiles& p) {
+    std::cout << std::left << std::setw(36) << name << std::right << std::setw(9) << p.samples
+              << std::fixed << std::setprecision(3)
+              << std::setw(11) << p.min << std::setw(11) << p.p50 << std::setw(11) << p.p90
+              << std::setw(11) << p.p99 << std::setw(11) << p.max
+              << std::defaultfloat << std::endl;
+}
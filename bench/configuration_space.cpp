@@ -0,0 +1,79 @@
+// The configuration-space pipeline on a generated scene, with 1, 2, 4, ... up
+// to the hardware thread count growing the obstacles.
+//
+//   make bench_configuration_space
+//   ./bench_configuration_space [edges] [max threads] [robot size] [seed]
+//
+// Obstacles sit in unit cells at least 0.1 apart, so robots wider than that
+// make grown obstacles overlap and the union stage merge them. Every run
+// builds into the same ConfigurationSpace, so all but the first reuse its
+// buffers; the grown edges have to match the single-threaded run.
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+
+#include "data_structure.hpp"
+#include "configuration_space.hpp"
+#include "scene_generator.hpp"
+
+using namespace std;
+
+static bool sameEdges(const vector<Segment>& a, const vector<Segment>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!a[i].p1.equals(b[i].p1) || !a[i].p2.equals(b[i].p2)
+            || a[i].polygonIndex != b[i].polygonIndex) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    SceneParameters parameters;
+    parameters.edges = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t maxThreads = argc > 2 ? strtoul(argv[2], NULL, 10) : thread::hardware_concurrency();
+    double size = argc > 3 ? atof(argv[3]) : 0.05;
+    parameters.seed = argc > 4 ? strtoul(argv[4], NULL, 10) : 1;
+    parameters.queries = 0;
+    if (maxThreads == 0) maxThreads = 1;
+
+    // An L-shaped robot, size across
+    Scene scene = generateScene(parameters);
+    Polygon robot;
+    robot.addVertex(-size / 2, -size / 2);
+    robot.addVertex(size / 2, -size / 2);
+    robot.addVertex(size / 2, -size / 6);
+    robot.addVertex(-size / 6, -size / 6);
+    robot.addVertex(-size / 6, size / 2);
+    robot.addVertex(-size / 2, size / 2);
+
+    ConfigurationSpace reference;
+    buildConfigurationSpace(reference, robot, scene.obstacles, 1);
+    cout << "obstacles: " << scene.obstacles.size() << ", convex sums: " << reference.grown.size()
+         << ", after union: " << reference.obstacles.size() << ", edges: " << reference.edges.size()
+         << ", free trapezoids: " << reference.freeSpace.trapezoids.size()
+         << ", roadmap nodes: " << reference.roadMap.nodeCount() << endl;
+    cout << "threads  grow ms  union ms  build ms  interior ms  roadmap ms  total ms" << endl;
+
+    ConfigurationSpace space;
+    bool ok = true;
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        buildConfigurationSpace(space, robot, scene.obstacles, threads);
+        const PipelineStats& s = space.stats;
+        cout << threads << "\t " << s.grow * 1e3 << "\t  " << s.unite * 1e3 << "\t    "
+             << s.build * 1e3 << "\t      " << s.removeInterior * 1e3 << "\t\t  " << s.roadMap * 1e3
+             << "\t      " << (s.grow + s.unite + s.build + s.removeInterior + s.roadMap) * 1e3 << endl;
+        if (!sameEdges(space.edges, reference.edges)
+            || space.roadMap.nodeCount() != reference.roadMap.nodeCount()) {
+            cout << "mismatch with " << threads << " threads" << endl;
+            ok = false;
+        }
+    }
+
+    space.freeSpace.cleanup();
+    reference.freeSpace.cleanup();
+    return ok ? 0 : 1;
+}
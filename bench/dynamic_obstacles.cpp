@@ -0,0 +1,120 @@
+// Obstacle churn: removeObstacle / insertObstacle plus updateRoadMap against
+// rebuilding the free space and roadmap from scratch after every change.
+//
+//   make bench_dynamic_obstacles
+//   ./bench_dynamic_obstacles [grid size] [updates] [check queries]
+//
+// Each update toggles a random triangle of the grid. Once the search
+// structure gets deeper than the build's limit the map is rebuilt; those
+// rebuilds are part of the churn time. At the end the updated map has to
+// answer path queries the same way as a fresh build of the same scene.
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+#include "data_structure.hpp"
+#include "trapezoidal_map.hpp"
+#include "compute_free_space.hpp"
+#include "compute_path.hpp"
+#include "bench_common.hpp"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    int k = argc > 1 ? atoi(argv[1]) : 40;
+    size_t updates = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000;
+    size_t m = argc > 3 ? strtoul(argv[3], NULL, 10) : 2000;
+
+    // A quarter of the triangles start out missing. The corner ones stay, so
+    // the bounding box of the scene never changes.
+    vector<Polygon> all = triangleGrid(k, 7);
+    vector<char> present(all.size(), 1);
+    for (size_t i = 1; i + 1 < all.size(); i += 4) present[i] = 0;
+    auto scene = [&]() {
+        vector<Polygon> polygons;
+        for (size_t i = 0; i < all.size(); i++) {
+            if (present[i]) polygons.push_back(all[i]);
+        }
+        return polygons;
+    };
+
+    TrapezoidalMap map = FreeSpaceComputer::COMPUTEFREESPACE(scene());
+    RoadMap roadMap = PathComputer::buildRoadMap(map);
+
+    double tRebuild = bestOf(3, [&]() {
+        TrapezoidalMap fresh = FreeSpaceComputer::COMPUTEFREESPACE(scene());
+        RoadMap freshRoadMap = PathComputer::buildRoadMap(fresh);
+        fresh.cleanup();
+    });
+
+    mt19937 rng(1);
+    MapUpdate update;
+    double tInsert = 0, tRemove = 0, tDeep = 0;
+    size_t inserts = 0, removes = 0, rebuilds = 0, failed = 0;
+    int polygonIndex = static_cast<int>(all.size());
+    for (size_t u = 0; u < updates; u++) {
+        size_t i = 1 + rng() % (all.size() - 2);
+        auto t0 = chrono::steady_clock::now();
+        bool ok = present[i] ? FreeSpaceComputer::removeObstacle(map, all[i], update)
+                             : FreeSpaceComputer::insertObstacle(map, all[i], polygonIndex++, update);
+        if (!ok) {
+            failed++;
+            continue;
+        }
+        PathComputer::updateRoadMap(roadMap, map, update);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        if (present[i]) {
+            tRemove += seconds;
+            removes++;
+        } else {
+            tInsert += seconds;
+            inserts++;
+        }
+        present[i] = !present[i];
+
+        if (map.stats.maxDepth > map.stats.depthLimit) {
+            t0 = chrono::steady_clock::now();
+            map.cleanup();
+            map = FreeSpaceComputer::COMPUTEFREESPACE(scene());
+            roadMap = PathComputer::buildRoadMap(map);
+            tDeep += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+            rebuilds++;
+        }
+    }
+
+    // The updated map against a fresh build of the final scene
+    TrapezoidalMap fresh = FreeSpaceComputer::COMPUTEFREESPACE(scene());
+    RoadMap freshRoadMap = PathComputer::buildRoadMap(fresh);
+    uniform_real_distribution<double> coord(0, k);
+    SearchScratch scratch;
+    vector<Point> path, freshPath;
+    size_t mismatches = 0, invalid = 0;
+    for (size_t q = 0; q < m; q++) {
+        Point a(coord(rng), coord(rng)), b(coord(rng), coord(rng));
+        PathStatus status = PathComputer::queryTautPath(map, roadMap, a, b, scratch, path);
+        PathStatus freshStatus = PathComputer::queryTautPath(fresh, freshRoadMap, a, b, scratch, freshPath);
+        if (status != freshStatus) mismatches++;
+        if (status == PATH_FOUND && !PathComputer::isValidPath(fresh, path)) invalid++;
+    }
+    if (map.trapezoids.size() != fresh.trapezoids.size()) mismatches++;
+
+    size_t done = inserts + removes;
+    double tChurn = tInsert + tRemove + tDeep;
+    cout << "obstacles: " << all.size() << ", free trapezoids: " << map.trapezoids.size()
+         << ", updates: " << done << " (" << failed << " refused)" << endl;
+    cout << "full rebuild          " << tRebuild * 1e3 << " ms" << endl;
+    cout << "insertObstacle        " << tInsert / inserts * 1e6 << " us (incl. roadmap patch)" << endl;
+    cout << "removeObstacle        " << tRemove / removes * 1e6 << " us (incl. roadmap patch)" << endl;
+    cout << "depth rebuilds        " << rebuilds << ", " << tDeep * 1e3 << " ms in total" << endl;
+    cout << "churn per update      " << tChurn / done * 1e6 << " us, "
+         << tRebuild / (tChurn / done) << "x faster than rebuilding" << endl;
+    cout << "DAG depth " << map.stats.maxDepth << " (limit " << map.stats.depthLimit << ")" << endl;
+    cout << "mismatches: " << mismatches << ", invalid paths: " << invalid << endl;
+
+    map.cleanup();
+    fresh.cleanup();
+    return mismatches == 0 && invalid == 0 ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+// Each kernel of the pipeline timed on its own, with warm-up runs and the
+// spread of many repetitions rather than a single best time.
+//
+//   make bench_kernels
+//   ./bench_kernels [grid size] [repetitions]
+//
+// Point location, segment walks and road map searches are timed over
+// batches of calls; segment insertions one call at a time, split by whether
+// the segment stays in one trapezoid or crosses several.
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <algorithm>
+
+#include "data_structure.hpp"
+#include "trapezoidal_map.hpp"
+#include "compute_free_space.hpp"
+#include "compute_path.hpp"
+#include "minkowski_sum.hpp"
+#include "bench_common.hpp"
+
+using namespace std;
+
+// Convex, counter-clockwise, n vertices around the origin
+static Polygon convexPolygon(size_t n, mt19937& rng) {
+    uniform_real_distribution<double> jitter(-0.3, 0.3);
+    Polygon p;
+    for (size_t i = 0; i < n; i++) {
+        double a = 2 * M_PI * (i + jitter(rng)) / n;
+        p.addVertex(cos(a), sin(a));
+    }
+    return p;
+}
+
+int main(int argc, char** argv) {
+    int k = argc > 1 ? atoi(argv[1]) : 30;
+    int reps = argc > 2 ? atoi(argv[2]) : 200;
+
+    vector<Polygon> polygons = triangleGrid(k, 7);
+    vector<Segment> edges = FreeSpaceComputer::extractEdges(polygons);
+    TrapezoidalMap map = BuildTrapezoidalMap(edges);
+
+    mt19937 rng(1);
+    uniform_real_distribution<double> coord(0, k);
+    uniform_real_distribution<double> step(-1, 1);
+    const size_t batch = 1000;
+
+    cout << "grid " << k << "x" << k << ", " << edges.size() << " segments, "
+         << map.trapezoids.size() << " trapezoids, " << reps << " repetitions" << endl;
+    printKernelHeader();
+
+    vector<Point> points(batch);
+    for (Point& p : points) p = Point(coord(rng), coord(rng));
+    size_t sink = 0;
+    printKernel("queryTrapezoidMap", sampleKernel(reps / 10, reps, batch, [&]() {
+        for (const Point& p : points) sink += queryTrapezoidMap(map.root, p)->trapezoid != NULL;
+    }));
+
+    // The walk assumes the segment crosses no segment of the map. Triangles
+    // stay below j + 0.9 in row j, so segments inside the band up to j + 1
+    // pass between rows; they span up to three columns.
+    uniform_real_distribution<double> band(0.91, 0.99);
+    uniform_int_distribution<int> row(0, k - 1);
+    vector<Segment> probes(batch);
+    for (Segment& s : probes) {
+        double x = coord(rng);
+        int j = row(rng);
+        s = Segment(Point(x, j + band(rng)), Point(min<double>(x + 3 * fabs(step(rng)), k), j + band(rng)));
+    }
+    vector<Trapezoid*> crossed;
+    printKernel("findIntersectedTrapezoids", sampleKernel(reps / 10, reps, batch, [&]() {
+        for (const Segment& s : probes) {
+            crossed.clear();
+            findIntersectedTrapezoids(map.root, s, crossed);
+            sink += crossed.size();
+        }
+    }));
+
+    // Insertions need a map without the segment: every other triangle is held
+    // out of the build and inserted afterwards, one build per repetition
+    {
+        vector<Polygon> base, held;
+        for (size_t i = 0; i < polygons.size(); i++) {
+            bool corner = (i == 0 || i + 1 == polygons.size());
+            (i % 2 == 1 && !corner ? held : base).push_back(polygons[i]);
+        }
+        vector<Segment> baseEdges = FreeSpaceComputer::extractEdges(base);
+        vector<Segment> heldEdges = FreeSpaceComputer::extractEdges(held);
+        vector<double> single, across;
+        int builds = max(2, reps / 50);
+        for (int b = 0; b < builds; b++) {
+            TrapezoidalMap partial = BuildTrapezoidalMap(baseEdges, b + 1);
+            shuffle(heldEdges.begin(), heldEdges.end(), rng);
+            vector<Trapezoid*> intersected;
+            for (const Segment& edge : heldEdges) {
+                Segment* seg = partial.newSegment(edge);
+                intersected.clear();
+                findIntersectedTrapezoids(partial.root, *seg, intersected);
+                if (intersected.empty()) continue;
+                auto t0 = chrono::steady_clock::now();
+                if (intersected.size() == 1) {
+                    insertInSingleTrapezoid(partial, intersected[0], seg);
+                } else {
+                    insertAcrossMultipleTrapezoids(partial, intersected, seg);
+                }
+                double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+                // The first build only warms up
+                if (b > 0) (intersected.size() == 1 ? single : across).push_back(us);
+            }
+            partial.cleanup();
+        }
+        printKernel("insertInSingleTrapezoid", percentiles(single));
+        printKernel("insertAcrossMultipleTrapezoids", percentiles(across));
+    }
+
+    for (size_t n : {8, 64, 512}) {
+        Polygon obstacle = convexPolygon(n, rng);
+        Polygon robot = convexPolygon(6, rng);
+        Polygon sum;
+        size_t calls = max<size_t>(1, 8192 / n);
+        printKernel("MINKOWSKISUM " + to_string(n) + " + 6 vertices",
+                    sampleKernel(reps / 10, reps, calls, [&]() {
+            for (size_t c = 0; c < calls; c++) sum = MinkowskiSum::MINKOWSKISUM(obstacle, robot);
+            sink += sum.vertices.size();
+        }));
+    }
+
+    // Comb with teeth-many notches: decomposes into one piece per tooth
+    for (size_t teeth : {1, 16, 256}) {
+        Polygon comb;
+        comb.addVertex(0, 0);
+        for (size_t t = 0; t < teeth; t++) {
+            comb.addVertex(t, 3);
+            comb.addVertex(t + 0.5, 3);
+            comb.addVertex(t + 0.5, 1);
+            comb.addVertex(t + 1.0, 1);
+        }
+        comb.addVertex(teeth, 0);
+        Polygon robot = convexPolygon(6, rng);
+        vector<Polygon> sums;
+        printKernel("MINKOWSKISUMNONCONVEX " + to_string(comb.vertices.size()) + " + 6",
+                    sampleKernel(reps / 10, reps, 1, [&]() {
+            sums = MinkowskiSum::MINKOWSKISUMNONCONVEX(comb, robot, 1);
+            sink += sums.size();
+        }));
+    }
+
+    FreeSpaceComputer::removeInteriorTrapezoids(map);
+    int roadMapReps = max(5, reps / 20);
+    printKernel("buildRoadMap", sampleKernel(1, roadMapReps, 1, [&]() {
+        RoadMap roadMap = PathComputer::buildRoadMap(map);
+        sink += roadMap.nodeCount();
+    }));
+
+    RoadMap roadMap = PathComputer::buildRoadMap(map);
+    uniform_int_distribution<uint32_t> node(0, static_cast<uint32_t>(roadMap.nodeCount() - 1));
+    vector<pair<uint32_t, uint32_t>> pairs(100);
+    for (auto& q : pairs) q = make_pair(node(rng), node(rng));
+    SearchScratch scratch;
+    printKernel("breadthFirstSearch", sampleKernel(reps / 10, reps, pairs.size(), [&]() {
+        for (const auto& q : pairs) {
+            sink += PathComputer::breadthFirstSearch(roadMap, q.first, q.second, scratch).size();
+        }
+    }));
+
+    // Keeps the timed loops from being optimised away
+    if (sink == 42) cout << endl;
+    map.cleanup();
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Orientation slices for a turning robot on a generated scene: build time
+// and query latency with 36 and 72 slices.
+//
+//   make bench_orientation_slices
+//   ./bench_orientation_slices [edges] [queries] [robot length] [seed]
+//
+// The robot is a rectangle a third as wide as it is long, turning about a
+// point near its back, like a forklift about its rear axle. Queries go
+// between random poses; every path found is checked step by step: a move
+// has to stay in the free space of its slice, and a turn has to start and
+// end in free space of the slices turned between.
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+#include "data_structure.hpp"
+#include "orientation_slices.hpp"
+#include "scene_generator.hpp"
+
+using namespace std;
+
+static bool isFree(const OrientationSlices& space, double angle, const Point& p) {
+    const TrapezoidalMap& map = space.slices[space.sliceFor(angle)].freeSpace;
+    return map.contains(PathComputer::findTrapezoidContainingPoint(map, p));
+}
+
+static bool isValidPosePath(const OrientationSlices& space, const vector<Pose>& path) {
+    for (size_t i = 0; i + 1 < path.size(); i++) {
+        const Pose& a = path[i];
+        const Pose& b = path[i + 1];
+        if (a.angle == b.angle) {
+            vector<Point> move = {a.position, b.position};
+            if (!PathComputer::isValidPath(space.slices[space.sliceFor(a.angle)].freeSpace, move)) return false;
+        } else if (!a.position.equals(b.position)
+                   || !isFree(space, a.angle, a.position) || !isFree(space, b.angle, b.position)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    SceneParameters parameters;
+    parameters.edges = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000;
+    size_t m = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000;
+    double length = argc > 3 ? atof(argv[3]) : 0.3;
+    parameters.seed = argc > 4 ? strtoul(argv[4], NULL, 10) : 1;
+    parameters.queries = 0;
+
+    Scene scene = generateScene(parameters);
+    double width = length / 3;
+    Polygon robot;
+    robot.addVertex(-length / 6, -width / 2);
+    robot.addVertex(length * 5 / 6, -width / 2);
+    robot.addVertex(length * 5 / 6, width / 2);
+    robot.addVertex(-length / 6, width / 2);
+
+    double extent = 0;
+    for (const Polygon& polygon : scene.obstacles) {
+        for (const Point& v : polygon.vertices) extent = max(extent, max(v.x, v.y));
+    }
+    uniform_real_distribution<double> coord(0, extent);
+    uniform_real_distribution<double> heading(0, 2 * M_PI);
+    mt19937 rng(parameters.seed);
+    vector<Pose> starts, goals;
+    for (size_t q = 0; q < m; q++) {
+        starts.push_back(Pose(Point(coord(rng), coord(rng)), heading(rng)));
+        goals.push_back(Pose(Point(coord(rng), coord(rng)), heading(rng)));
+    }
+
+    cout << "obstacles: " << scene.obstacles.size() << ", robot " << length << " x " << width << endl;
+    cout << "slices  build ms  links ms  nodes    links    query us  p99 us  found  invalid" << endl;
+
+    bool ok = true;
+    size_t counts[2] = {36, 72};
+    for (size_t K : counts) {
+        OrientationSlices space;
+        buildOrientationSlices(space, robot, scene.obstacles, K);
+        const OrientationStats& s = space.stats;
+
+        SearchScratch scratch;
+        vector<Pose> path;
+        vector<double> times;
+        size_t found = 0, invalid = 0;
+        for (size_t q = 0; q < m; q++) {
+            auto t0 = chrono::steady_clock::now();
+            PathStatus status = queryOrientationPath(space, starts[q], goals[q], scratch, path);
+            times.push_back(chrono::duration<double>(chrono::steady_clock::now() - t0).count());
+            if (status != PATH_FOUND) continue;
+            found++;
+            if (!isValidPosePath(space, path)) invalid++;
+        }
+        sort(times.begin(), times.end());
+        double mean = 0;
+        for (double t : times) mean += t;
+        mean /= max<size_t>(1, m);
+
+        cout << K << "\t" << (s.decompose + s.slices + s.link + s.landmarks) * 1e3 << "\t  " << s.link * 1e3
+             << "\t    " << space.graph.nodeCount() << "\t   " << space.linkCount()
+             << "\t    " << mean * 1e6 << "\t  " << (m ? times[m * 99 / 100] * 1e6 : 0)
+             << "\t  " << found << "\t " << invalid << endl;
+        if (invalid) ok = false;
+
+        for (ConfigurationSpace& slice : space.slices) slice.freeSpace.cleanup();
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+// Query throughput of QueryPool against a shared free-space map, for 1 up to
+// the hardware thread count.
+//
+//   make bench_parallel_queries
+//   ./bench_parallel_queries [grid size] [point queries] [path queries] [max threads]
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <thread>
+#include <cstdlib>
+
+#include "data_structure.hpp"
+#include "trapezoidal_map.hpp"
+#include "compute_free_space.hpp"
+#include "compute_path.hpp"
+#include "frozen_map.hpp"
+#include "query_pool.hpp"
+#include "bench_common.hpp"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    int k = argc > 1 ? atoi(argv[1]) : 20;
+    size_t n = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+    size_t m = argc > 3 ? strtoul(argv[3], NULL, 10) : 2000;
+    size_t maxThreads = argc > 4 ? strtoul(argv[4], NULL, 10) : thread::hardware_concurrency();
+    if (maxThreads == 0) maxThreads = 1;
+
+    TrapezoidalMap map = FreeSpaceComputer::COMPUTEFREESPACE(triangleGrid(k, 7));
+    RoadMap roadMap = PathComputer::buildRoadMap(map);
+    FrozenSearchStructure fs = freezeSearchStructure(map);
+
+    mt19937 rng(1);
+    uniform_real_distribution<double> u(0, k);
+    vector<Point> points(n);
+    vector<double> xs(n), ys(n);
+    for (size_t i = 0; i < n; i++) {
+        xs[i] = u(rng);
+        ys[i] = u(rng);
+        points[i] = Point(xs[i], ys[i]);
+    }
+    vector<PathQuery> queries(m);
+    for (size_t i = 0; i < m; i++) {
+        queries[i].start = Point(u(rng), u(rng));
+        queries[i].goal = Point(u(rng), u(rng));
+    }
+
+    // Single-threaded reference answers
+    vector<Trapezoid*> expectedTraps(n);
+    for (size_t i = 0; i < n; i++) {
+        expectedTraps[i] = queryTrapezoidMap(map.root, points[i])->trapezoid;
+    }
+    vector<PathResult> expectedPaths(m);
+    {
+        SearchScratch scratch;
+        for (size_t i = 0; i < m; i++) {
+            expectedPaths[i].status = PathComputer::queryPath(map, roadMap, queries[i].start,
+                                                              queries[i].goal, scratch,
+                                                              expectedPaths[i].path);
+        }
+    }
+    // Every path the roadmap produced must pass the validator
+    vector<vector<Point>> foundPaths;
+    for (const PathResult& r : expectedPaths) {
+        if (r.status == PATH_FOUND) foundPaths.push_back(r.path);
+    }
+
+    cout << "trapezoids: " << map.trapezoids.size() << ", roadmap nodes: " << roadMap.nodeCount()
+         << ", point queries: " << n << ", path queries: " << m << endl;
+    cout << "threads  locate(DAG) M/s  locate(frozen) M/s  paths k/s  validate k/s" << endl;
+
+    size_t mismatches = 0;
+    for (size_t t = 1; t <= maxThreads; t *= 2) {
+        QueryPool pool(t);
+        vector<Trapezoid*> dagOut, frozenOut(n);
+        vector<PathResult> pathOut;
+        vector<uint8_t> valid;
+
+        double tDag = bestOf(3, [&]() { pool.locate(map, points, dagOut); });
+        double tFrozen = bestOf(3, [&]() {
+            pool.locate(fs, xs.data(), ys.data(), n, frozenOut.data());
+        });
+        double tPaths = bestOf(3, [&]() { pool.computePaths(map, roadMap, queries, pathOut); });
+        double tValid = bestOf(3, [&]() { pool.validatePaths(map, foundPaths, valid); });
+
+        for (size_t i = 0; i < n; i++) {
+            if (dagOut[i] != expectedTraps[i] || frozenOut[i] != expectedTraps[i]) mismatches++;
+        }
+        for (size_t i = 0; i < m; i++) {
+            if (pathOut[i].status != expectedPaths[i].status ||
+                pathOut[i].path.size() != expectedPaths[i].path.size()) mismatches++;
+        }
+        for (uint8_t v : valid) {
+            if (!v) mismatches++;
+        }
+
+        cout << t << "        " << n / tDag / 1e6 << "             " << n / tFrozen / 1e6
+             << "             " << m / tPaths / 1e3
+             << "       " << foundPaths.size() / tValid / 1e3 << endl;
+    }
+    cout << "mismatches: " << mismatches << endl;
+
+    map.cleanup();
+    return mismatches == 0 ? 0 : 1;
+}
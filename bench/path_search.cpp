@@ -0,0 +1,115 @@
+// Roadmap search: breadth-first vs A* vs ALT on the same queries. Reports
+// nodes expanded, latency and the Euclidean length of the roadmap path.
+//
+//   make bench_path_search
+//   ./bench_path_search [grid size] [queries] [landmarks] [table file]
+//
+// With a table file the landmark table is loaded from it if it fits the
+// roadmap, and built and saved there otherwise.
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include "data_structure.hpp"
+#include "trapezoidal_map.hpp"
+#include "compute_free_space.hpp"
+#include "compute_path.hpp"
+#include "landmarks.hpp"
+#include "bench_common.hpp"
+
+using namespace std;
+
+static double pathLength(const vector<Point>& path) {
+    double length = 0;
+    for (size_t i = 1; i < path.size(); i++) {
+        length += hypot(path[i].x - path[i - 1].x, path[i].y - path[i - 1].y);
+    }
+    return length;
+}
+
+struct SearchTotals {
+    double seconds = 0;
+    double expanded = 0;
+    double length = 0;
+};
+
+int main(int argc, char** argv) {
+    int k = argc > 1 ? atoi(argv[1]) : 60;
+    size_t m = argc > 2 ? strtoul(argv[2], NULL, 10) : 500;
+    size_t landmarkCount = argc > 3 ? strtoul(argv[3], NULL, 10) : DEFAULT_LANDMARK_COUNT;
+    const char* tableFile = argc > 4 ? argv[4] : NULL;
+
+    TrapezoidalMap map = FreeSpaceComputer::COMPUTEFREESPACE(triangleGrid(k, 7));
+    RoadMap roadMap = PathComputer::buildRoadMap(map);
+
+    LandmarkTable landmarks;
+    auto t0 = chrono::steady_clock::now();
+    bool loaded = tableFile && loadLandmarkTable(landmarks, tableFile) && landmarks.matches(roadMap);
+    if (!loaded) {
+        landmarks = buildLandmarkTable(roadMap, landmarkCount);
+        if (tableFile) saveLandmarkTable(landmarks, tableFile);
+    }
+    double tableSeconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    // Queries between random free trapezoids, so every one has a path
+    mt19937 rng(1);
+    uniform_int_distribution<size_t> pick(0, map.trapezoids.size() - 1);
+    vector<pair<uint32_t, uint32_t>> queries(m);
+    for (size_t i = 0; i < m; i++) {
+        queries[i].first = roadMap.getNodeForTrapezoid(map.trapezoids[pick(rng)]);
+        queries[i].second = roadMap.getNodeForTrapezoid(map.trapezoids[pick(rng)]);
+    }
+
+    SearchScratch scratch;
+    SearchTotals bfs, astar, alt;
+    size_t longer = 0, mismatched = 0;
+    for (size_t i = 0; i < m; i++) {
+        uint32_t s = queries[i].first, g = queries[i].second;
+
+        t0 = chrono::steady_clock::now();
+        vector<Point> a = PathComputer::breadthFirstSearch(roadMap, s, g, scratch);
+        auto t1 = chrono::steady_clock::now();
+        bfs.seconds += chrono::duration<double>(t1 - t0).count();
+        bfs.expanded += scratch.expanded;
+        bfs.length += pathLength(a);
+
+        t0 = chrono::steady_clock::now();
+        vector<Point> b = PathComputer::aStarSearch(roadMap, s, g, scratch);
+        t1 = chrono::steady_clock::now();
+        astar.seconds += chrono::duration<double>(t1 - t0).count();
+        astar.expanded += scratch.expanded;
+        astar.length += pathLength(b);
+
+        t0 = chrono::steady_clock::now();
+        vector<Point> c = PathComputer::altSearch(roadMap, landmarks, s, g, scratch);
+        t1 = chrono::steady_clock::now();
+        alt.seconds += chrono::duration<double>(t1 - t0).count();
+        alt.expanded += scratch.expanded;
+        alt.length += pathLength(c);
+
+        if (a.empty() != b.empty() || pathLength(b) > pathLength(a) + 1e-9) longer++;
+        // Ties may be broken differently, but both are shortest paths
+        if (b.empty() != c.empty() || fabs(pathLength(b) - pathLength(c)) > 1e-9) mismatched++;
+    }
+
+    cout << "trapezoids: " << map.trapezoids.size() << ", roadmap nodes: " << roadMap.nodeCount()
+         << ", edges: " << roadMap.edgeCount() << ", queries: " << m << endl;
+    cout << "landmarks: " << landmarks.count() << (loaded ? ", loaded in " : ", built in ")
+         << tableSeconds << " s" << endl;
+    cout << "search  expanded/query  us/query  mean length" << endl;
+    cout << "BFS     " << bfs.expanded / m << "  " << bfs.seconds / m * 1e6
+         << "  " << bfs.length / m << endl;
+    cout << "A*      " << astar.expanded / m << "  " << astar.seconds / m * 1e6
+         << "  " << astar.length / m << endl;
+    cout << "ALT     " << alt.expanded / m << "  " << alt.seconds / m * 1e6
+         << "  " << alt.length / m << endl;
+    cout << "A* paths longer than BFS: " << longer << endl;
+    cout << "ALT paths not as short as A*: " << mismatched << endl;
+
+    map.cleanup();
+    return longer == 0 && mismatched == 0 ? 0 : 1;
+}
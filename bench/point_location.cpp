@@ -0,0 +1,77 @@
+// Point-location throughput: pointer DAG vs frozen structure vs batch API.
+//
+//   make bench_point_location
+//   ./bench_point_location [grid size] [queries]
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+
+#include "data_structure.hpp"
+#include "trapezoidal_map.hpp"
+#include "compute_free_space.hpp"
+#include "frozen_map.hpp"
+#include "bench_common.hpp"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    int k = argc > 1 ? atoi(argv[1]) : 30;
+    size_t n = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+
+    vector<Segment> edges = FreeSpaceComputer::extractEdges(triangleGrid(k, 7));
+
+    TrapezoidalMap map = BuildTrapezoidalMap(edges);
+
+    FrozenSearchStructure fs = freezeSearchStructure(map);
+
+    mt19937 rng(1);
+    uniform_real_distribution<double> u(0, k);
+    vector<double> xs(n), ys(n);
+    for (size_t i = 0; i < n; i++) {
+        xs[i] = u(rng);
+        ys[i] = u(rng);
+    }
+
+    vector<Trapezoid*> dagOut(n), frozenOut(n), batchOut(n);
+
+    double tDag = bestOf(3, [&]() {
+        for (size_t i = 0; i < n; i++) {
+            dagOut[i] = queryTrapezoidMap(map.root, Point(xs[i], ys[i]))->trapezoid;
+        }
+    });
+    double tFrozen = bestOf(3, [&]() {
+        for (size_t i = 0; i < n; i++) {
+            frozenOut[i] = queryFrozenStructure(fs, Point(xs[i], ys[i]));
+        }
+    });
+    double tBatch = bestOf(3, [&]() {
+        queryFrozenBatch(fs, xs.data(), ys.data(), n, batchOut.data());
+    });
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (dagOut[i] != frozenOut[i] || dagOut[i] != batchOut[i]) mismatches++;
+    }
+
+#if defined(__AVX2__)
+    const char* lanes = "AVX2";
+#elif defined(__SSE2__)
+    const char* lanes = "SSE2";
+#else
+    const char* lanes = "scalar lanes";
+#endif
+
+    size_t frozenBytes = fs.xNodes.size() * sizeof(FrozenXNode) + fs.yNodes.size() * sizeof(FrozenYNode);
+    cout << "edges: " << edges.size() << ", DAG nodes: " << fs.nodeCount()
+         << ", frozen records: " << frozenBytes / 1024 << " KiB, queries: " << n << endl;
+    cout << "queryTrapezoidMap     " << n / tDag / 1e6 << " M points/s" << endl;
+    cout << "queryFrozenStructure  " << n / tFrozen / 1e6 << " M points/s" << endl;
+    cout << "queryFrozenBatch      " << n / tBatch / 1e6 << " M points/s (" << lanes << ")" << endl;
+    cout << "mismatches: " << mismatches << endl;
+
+    map.cleanup();
+    return mismatches == 0 ? 0 : 1;
+}
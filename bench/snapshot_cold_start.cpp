@@ -0,0 +1,97 @@
+// Start-up cost: building the free space and roadmap from the obstacles
+// against opening a snapshot of them written by saveMapSnapshot.
+//
+//   make bench_snapshot_cold_start
+//   ./bench_snapshot_cold_start [grid size] [queries] [snapshot file]
+//
+// The open is timed together with the first query, which pulls the pages
+// it touches in from the page cache. Every query is then answered from the
+// snapshot and from the built map, and the results have to agree.
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+
+#include "data_structure.hpp"
+#include "compute_free_space.hpp"
+#include "compute_path.hpp"
+#include "map_snapshot.hpp"
+#include "bench_common.hpp"
+
+using namespace std;
+
+static bool samePath(const vector<Point>& a, const vector<Point>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!a[i].equals(b[i])) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int k = argc > 1 ? atoi(argv[1]) : 100;
+    size_t m = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000;
+    const char* file = argc > 3 ? argv[3] : "map.snapshot";
+
+    vector<Polygon> polygons = triangleGrid(k, 7);
+    TrapezoidalMap map;
+    RoadMap roadMap;
+    double tBuild = bestOf(1, [&]() {
+        map = FreeSpaceComputer::COMPUTEFREESPACE(polygons);
+        roadMap = PathComputer::buildRoadMap(map);
+    });
+
+    auto t0 = chrono::steady_clock::now();
+    if (!saveMapSnapshot(map, roadMap, file)) return 1;
+    double tSave = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    uniform_real_distribution<double> coord(0, k);
+    mt19937 rng(1);
+    vector<Point> starts, goals;
+    for (size_t q = 0; q < m; q++) {
+        starts.push_back(Point(coord(rng), coord(rng)));
+        goals.push_back(Point(coord(rng), coord(rng)));
+    }
+
+    SearchScratch scratch;
+    vector<Point> path, builtPath;
+    MapSnapshot snapshot;
+    t0 = chrono::steady_clock::now();
+    if (!openMapSnapshot(snapshot, file)) return 1;
+    querySnapshotPath(snapshot, starts[0], goals[0], scratch, path, SEARCH_ASTAR);
+    double tOpen = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    size_t mismatches = 0, found = 0;
+    double tSnapshot = 0, tBuilt = 0;
+    for (size_t q = 0; q < m; q++) {
+        t0 = chrono::steady_clock::now();
+        PathStatus status = querySnapshotPath(snapshot, starts[q], goals[q], scratch, path,
+                                              SEARCH_ASTAR);
+        auto t1 = chrono::steady_clock::now();
+        PathStatus builtStatus = PathComputer::queryPath(map, roadMap, starts[q], goals[q],
+                                                         scratch, builtPath, SEARCH_ASTAR);
+        auto t2 = chrono::steady_clock::now();
+        tSnapshot += chrono::duration<double>(t1 - t0).count();
+        tBuilt += chrono::duration<double>(t2 - t1).count();
+        if (status != builtStatus || !samePath(path, builtPath)) mismatches++;
+        if (status == PATH_FOUND) found++;
+    }
+
+    cout << "obstacles: " << polygons.size() << ", trapezoids: " << snapshot.trapezoidCount
+         << ", roadmap nodes: " << snapshot.roadMap.nodeCount
+         << ", snapshot: " << snapshot.mappingSize / 1024 << " KiB" << endl;
+    cout << "build map + roadmap   " << tBuild * 1e3 << " ms" << endl;
+    cout << "saveMapSnapshot       " << tSave * 1e3 << " ms" << endl;
+    cout << "open + first query    " << tOpen * 1e3 << " ms, "
+         << tBuild / tOpen << "x faster than building" << endl;
+    cout << "A* query, snapshot    " << tSnapshot / m * 1e6 << " us" << endl;
+    cout << "A* query, built map   " << tBuilt / m * 1e6 << " us" << endl;
+    cout << "paths found: " << found << "/" << m << ", mismatches: " << mismatches << endl;
+
+    closeMapSnapshot(snapshot);
+    map.cleanup();
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+/*-------------------------------------------------------------------------------\
+| arena.hpp                                                                      |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| Region allocator for the map structures. Objects are carved out of large       |
+| blocks and are never freed one by one; the whole region is released at once.   |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+template <typename T>
+class Arena {
+    // Objects are dropped without running destructors on release()
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "Arena only holds trivially destructible types");
+
+public:
+    explicit Arena(size_t blockSize = 1024)
+        : blockSize(blockSize), used(blockSize), count(0) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Arena(Arena&& other) noexcept
+        : blocks(std::move(other.blocks)), blockSize(other.blockSize),
+          used(other.used), count(other.count) {
+        other.blocks.clear();
+        other.used = other.blockSize;
+        other.count = 0;
+    }
+
+    Arena& operator=(Arena&& other) noexcept {
+        if (this != &other) {
+            release();
+            blocks = std::move(other.blocks);
+            blockSize = other.blockSize;
+            used = other.used;
+            count = other.count;
+            other.blocks.clear();
+            other.used = other.blockSize;
+            other.count = 0;
+        }
+        return *this;
+    }
+
+    ~Arena() { release(); }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        if (used == blockSize) {
+            blocks.push_back(static_cast<T*>(::operator new(sizeof(T) * blockSize)));
+            used = 0;
+        }
+        T* slot = blocks.back() + used++;
+        count++;
+        return new (slot) T(std::forward<Args>(args)...);
+    }
+
+    // Free every block in one go. All pointers handed out become invalid.
+    void release() {
+        for (T* block : blocks) {
+            ::operator delete(block);
+        }
+        blocks.clear();
+        used = blockSize;
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+
+private:
+    std::vector<T*> blocks;
+    size_t blockSize;
+    size_t used;
+    size_t count;
+};
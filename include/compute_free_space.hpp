@@ -4,12 +4,42 @@
 #include "trapezoidal_map.hpp"
 #include <vector>
 
+// Trapezoids an obstacle insertion or removal took out of the map and put in
+struct MapUpdate {
+    std::vector<Trapezoid*> removed;    // split or merged, no longer listed
+    std::vector<Trapezoid*> added;      // new free trapezoids, listed in the map
+};
+
 class FreeSpaceComputer {
 public:
-    static TrapezoidalMap COMPUTEFREESPACE(const std::vector<Polygon>& S);
+    static TrapezoidalMap COMPUTEFREESPACE(const std::vector<Polygon>& S,
+                                           unsigned seed = DEFAULT_BUILD_SEED);
     static std::vector<Segment> extractEdges(const std::vector<Polygon>& polygons);
+    // The edges of one polygon (at least 3 vertices, either orientation)
+    // into out[0 .. vertices - 1], each marked with the side the polygon
+    // lies on
+    static void extractEdges(const Polygon& polygon, int polygonIndex, Segment* out);
     static bool isTrapezoidInsideObstacle(Trapezoid* trap);
-    static void removeInteriorTrapezoids(TrapezoidalMap& map, 
-                                        const std::vector<Polygon>& polygons);
+    static void removeInteriorTrapezoids(TrapezoidalMap& map);
+    // Add one obstacle to a map built by COMPUTEFREESPACE without rebuilding
+    // it: the edges go in through the usual insertion steps and the
+    // trapezoids that end up inside are dropped, so the cost follows the
+    // polygon and the trapezoids it crosses. polygonIndex must differ from
+    // every obstacle already in the map. The polygon has to lie inside the
+    // map's bounding box and clear of the other obstacles; if it does not,
+    // returns false with the map untouched and the caller rebuilds.
+    // Frozen copies of the search structure must be frozen again afterwards.
+    static bool insertObstacle(TrapezoidalMap& map, const Polygon& polygon,
+                               int polygonIndex, MapUpdate& update);
+    // Take out an obstacle added by COMPUTEFREESPACE or insertObstacle,
+    // merging the trapezoids around it; the cost follows the polygon and
+    // the trapezoids along its edges. Returns false with the map untouched
+    // if the polygon's edges are not in the map (or, for input breaking the
+    // usual general-position rules, possibly half way through, after which
+    // the map has to be rebuilt). Updates deepen the search
+    // structure locally; rebuild once map.stats.maxDepth passes
+    // map.stats.depthLimit.
+    static bool removeObstacle(TrapezoidalMap& map, const Polygon& polygon,
+                               MapUpdate& update);
 };
 
@@ -3,44 +3,117 @@
 #include "data_structure.hpp"
 #include "trapezoidal_map.hpp"
 #include "compute_free_space.hpp"
+#include "indexed_heap.hpp"
 #include <vector>
-#include <queue>
-#include <unordered_map>
-#include <unordered_set>
+#include <cstdint>
 
-struct RoadMapNode {
-    Point position;
-    std::vector<RoadMapNode*> neighbors;
-    Trapezoid* trapezoid;
-    
-    RoadMapNode(const Point& p, Trapezoid* trap = nullptr) 
-        : position(p), trapezoid(trap) {}
+static const uint32_t ROADMAP_NONE = 0xFFFFFFFFu;
+
+struct LandmarkTable;
+
+// The arrays of a roadmap as plain pointers, so the searches can run over a
+// RoadMap or over one mapped from a snapshot file (map_snapshot.hpp) alike
+struct RoadMapView {
+    size_t nodeCount;
+    const Point* positions;
+    const uint32_t* rowBegin;
+    const uint32_t* rowEnd;
+    const uint32_t* neighbors;
+    const double* lengths;
+    const uint32_t* component;
 };
 
+// Roadmap in adjacency-array form. Node i sits at positions[i]; its
+// neighbours are neighbors[rowBegin[i] .. rowEnd[i]) and lengths[e] is the
+// length of edge e. buildRoadMap lays the rows out back to back (plain CSR,
+// centers first); updateRoadMap moves a row that grows to the end of the
+// arrays and hands the ids of dropped nodes out again, so after updates the
+// arrays hold unused gaps until the next compaction.
+// nodeTrapezoid[i] is the trapezoid center node i stands for, NULL for wall
+// crossings and dropped nodes. component[i] labels the connected region of
+// free space node i lies in, so two nodes are mutually reachable iff their
+// labels are equal; dropped nodes are labelled ROADMAP_NONE. Labels stay
+// below componentCount, though after updates not every one is in use.
 class RoadMap {
 public:
-    std::vector<RoadMapNode*> nodes;
-    std::unordered_map<Trapezoid*, RoadMapNode*> trapToNode;
+    std::vector<Point> positions;
+    std::vector<uint32_t> rowBegin;
+    std::vector<uint32_t> rowEnd;
+    std::vector<uint32_t> neighbors;
+    std::vector<double> lengths;            // parallel to neighbors
+    std::vector<Trapezoid*> nodeTrapezoid;  // center node -> trapezoid
+    std::vector<uint32_t> component;        // node -> 0 .. componentCount - 1
+    uint32_t componentCount;
+    std::vector<uint32_t> freeNodes;        // dropped ids, reused first
+    size_t unusedEdges;                     // entries of neighbors no row covers
     
-    ~RoadMap() {
-        for (RoadMapNode* node : nodes) {
-            delete node;
-        }
+    RoadMap() : componentCount(0), unusedEdges(0) {}
+    
+    // Node ids run from 0 to nodeCount() - 1, dropped ones included
+    size_t nodeCount() const { return positions.size(); }
+    size_t edgeCount() const { return (neighbors.size() - unusedEdges) / 2; }
+    
+    bool connected(uint32_t a, uint32_t b) const { return component[a] == component[b]; }
+    
+    RoadMapView view() const {
+        RoadMapView v = {nodeCount(), positions.data(), rowBegin.data(), rowEnd.data(),
+                         neighbors.data(), lengths.data(), component.data()};
+        return v;
     }
     
-    void addNode(RoadMapNode* node) {
-        nodes.push_back(node);
-        if (node->trapezoid) {
-            trapToNode[node->trapezoid] = node;
+    // Center node of a trapezoid listed in the map the roadmap was built from
+    uint32_t getNodeForTrapezoid(const Trapezoid* trap) const {
+        if (!trap || trap->roadNode < 0 || static_cast<size_t>(trap->roadNode) >= nodeTrapezoid.size() ||
+            nodeTrapezoid[trap->roadNode] != trap) {
+            return ROADMAP_NONE;
         }
+        return static_cast<uint32_t>(trap->roadNode);
     }
+};
+
+// Reusable query context. The arrays are indexed by roadmap node id and
+// sized once per roadmap; each search bumps the generation, which forgets
+// every mark of the previous search in O(1). Once warmed up, queries
+// through the same scratch allocate nothing. Concurrent searches each
+// need their own.
+struct SearchScratch {
+    std::vector<uint32_t> parent;           // valid where stamp == generation
+    std::vector<uint32_t> stamp;            // last generation that reached the node
+    uint32_t generation;
+    std::vector<uint32_t> frontier;         // BFS queue
+    std::vector<Trapezoid*> corridor;       // trapezoids along a taut path query
+    std::vector<Point> funnel;              // pullTaut work buffer
+    std::vector<double> cost;               // A*/ALT: best known distance from start
+    IndexedHeap open;                       // A*/ALT: open set keyed by cost + heuristic
+    size_t expanded;                        // nodes expanded (settled) by the last search
+    
+    SearchScratch() : generation(0), expanded(0) {}
+    
+    // Size the arrays for a roadmap of nodeCount nodes and start a new search
+    void begin(size_t nodeCount);
     
-    RoadMapNode* getNodeForTrapezoid(Trapezoid* trap) {
-        auto it = trapToNode.find(trap);
-        return (it != trapToNode.end()) ? it->second : nullptr;
+    bool reached(uint32_t node) const { return stamp[node] == generation; }
+    void reach(uint32_t node, uint32_t from) {
+        stamp[node] = generation;
+        parent[node] = from;
     }
 };
 
+enum SearchAlgorithm {
+    SEARCH_BFS,         // fewest roadmap hops
+    SEARCH_ASTAR,       // shortest Euclidean length along the roadmap
+    SEARCH_ALT          // same paths as SEARCH_ASTAR, guided by a LandmarkTable
+};
+
+enum PathStatus {
+    PATH_FOUND,
+    PATH_START_BLOCKED,
+    PATH_GOAL_BLOCKED,
+    PATH_NO_ROADMAP_NODE,
+    PATH_DISCONNECTED,      // start and goal lie in different free-space regions
+    PATH_NOT_FOUND
+};
+
 class PathComputer {
 public:
     static std::vector<Point> COMPUTEPATH(TrapezoidalMap& freeSpaceMap, 
@@ -48,11 +121,108 @@ public:
                                          const Point& pstart, 
                                          const Point& pgoal);
     
+    // COMPUTEPATH variant that returns the geometrically shortest roadmap path
+    static std::vector<Point> COMPUTESHORTESTPATH(TrapezoidalMap& freeSpaceMap, 
+                                                 RoadMap& roadMap,
+                                                 const Point& pstart, 
+                                                 const Point& pgoal);
+    
+    // Taut path through the trapezoids of the shortest roadmap path; see
+    // queryTautPath
+    static std::vector<Point> COMPUTETAUTPATH(TrapezoidalMap& freeSpaceMap, 
+                                             RoadMap& roadMap,
+                                             const Point& pstart, 
+                                             const Point& pgoal);
+    
+    // Silent COMPUTEPATH. Only reads the map and the roadmap, so any number
+    // of threads may call it at once as long as each passes its own scratch.
+    // SEARCH_ALT needs a table built for roadMap (check matches() once after
+    // loading one) and falls back to SEARCH_ASTAR when landmarks is NULL.
+    static PathStatus queryPath(const TrapezoidalMap& freeSpaceMap,
+                                const RoadMap& roadMap,
+                                const Point& pstart,
+                                const Point& pgoal,
+                                SearchScratch& scratch,
+                                std::vector<Point>& path,
+                                SearchAlgorithm algorithm = SEARCH_BFS,
+                                const LandmarkTable* landmarks = NULL);
+    
+    // Search half of queryPath, for callers that located pstart and pgoal
+    // themselves: nu_start and nu_goal are the center nodes of their
+    // trapezoids in roadMap
+    static PathStatus queryRoadMapPath(const RoadMapView& roadMap,
+                                       uint32_t nu_start,
+                                       uint32_t nu_goal,
+                                       const Point& pstart,
+                                       const Point& pgoal,
+                                       SearchScratch& scratch,
+                                       std::vector<Point>& path,
+                                       SearchAlgorithm algorithm = SEARCH_BFS,
+                                       const LandmarkTable* landmarks = NULL);
+    
+    // queryPath followed by pullTaut over the trapezoids the roadmap path
+    // passes through: the waypoints are the obstacle corners the path bends
+    // around, plus pstart and pgoal
+    static PathStatus queryTautPath(const TrapezoidalMap& freeSpaceMap,
+                                    const RoadMap& roadMap,
+                                    const Point& pstart,
+                                    const Point& pgoal,
+                                    SearchScratch& scratch,
+                                    std::vector<Point>& path,
+                                    SearchAlgorithm algorithm = SEARCH_ASTAR,
+                                    const LandmarkTable* landmarks = NULL);
+    
+    // Funnel (string-pulling) pass over a corridor of trapezoids, each sharing
+    // a piece of vertical wall with the next; pstart must lie in the first
+    // and pgoal in the last. Writes the shortest polyline inside the corridor
+    // to path in time linear in its length. funnel is work space.
+    static void pullTaut(const std::vector<Trapezoid*>& corridor,
+                         const Point& pstart,
+                         const Point& pgoal,
+                         std::vector<Point>& funnel,
+                         std::vector<Point>& path);
+    
     static RoadMap buildRoadMap(TrapezoidalMap& freeSpaceMap);
-    static std::vector<Point> breadthFirstSearch(RoadMapNode* start, RoadMapNode* goal);
-    static Trapezoid* findTrapezoidContainingPoint(TrapezoidalMap& map, const Point& p);
+    // Patch a roadmap built over freeSpaceMap after insertObstacle or
+    // removeObstacle: drops the nodes of the trapezoids update removed, adds
+    // centers and wall crossings for the ones it added, in time proportional
+    // to the update. Regions a removal joins, or an insertion touching other
+    // obstacles splits, are relabelled by a flood fill over them. Landmark
+    // tables built before no longer match and need rebuilding.
+    static void updateRoadMap(RoadMap& roadMap, const TrapezoidalMap& freeSpaceMap,
+                              const MapUpdate& update);
+    static std::vector<Point> breadthFirstSearch(const RoadMap& roadMap,
+                                                 uint32_t start, uint32_t goal);
+    static std::vector<Point> breadthFirstSearch(const RoadMap& roadMap,
+                                                 uint32_t start, uint32_t goal,
+                                                 SearchScratch& scratch);
+    // A* with edge lengths as costs and straight-line distance to the goal
+    // as the heuristic. Roadmap paths run through the center of every slab
+    // they cross and are often tens of times longer than the straight line,
+    // so the heuristic prunes little: on the triangle grids A* expands about
+    // as many nodes as plain Dijkstra and as breadth-first search, at several
+    // times the cost per node for the heap. Use it for shorter paths, not
+    // faster queries; altSearch is the fast variant.
+    static std::vector<Point> aStarSearch(const RoadMap& roadMap,
+                                          uint32_t start, uint32_t goal,
+                                          SearchScratch& scratch);
+    // A* whose heuristic also takes the landmark bounds; landmarks must have
+    // been built for roadMap
+    static std::vector<Point> altSearch(const RoadMap& roadMap,
+                                        const LandmarkTable& landmarks,
+                                        uint32_t start, uint32_t goal,
+                                        SearchScratch& scratch);
+    static Trapezoid* findTrapezoidContainingPoint(const TrapezoidalMap& map, const Point& p);
     static Point getTrapezoidCenter(Trapezoid* trap);
-    static bool isValidPath(const std::vector<Point>& path, 
-                           const std::vector<Polygon>& obstacles);
-    static int countTotalEdges(RoadMap& roadMap);
+    // True if every segment of path stays in free space (touching obstacle
+    // boundaries is allowed). Walks the map along each segment from
+    // trapezoid to right neighbour, so a segment costs O(trapezoids crossed).
+    static bool isValidPath(const TrapezoidalMap& freeSpaceMap,
+                            const std::vector<Point>& path);
+    // isValidPath for each of paths; valid[i] is 1 or 0. Returns the number
+    // of valid paths.
+    static size_t validatePaths(const TrapezoidalMap& freeSpaceMap,
+                                const std::vector<std::vector<Point>>& paths,
+                                std::vector<uint8_t>& valid);
+    static int countTotalEdges(const RoadMap& roadMap);
 };
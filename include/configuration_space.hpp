@@ -0,0 +1,66 @@
+/*-------------------------------------------------------------------------------\
+| configuration_space.hpp                                                        |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| The whole planning pipeline for a translating polygonal robot in one call:    |
+| every obstacle is grown by the reflected robot (Minkowski sum), overlapping   |
+| grown obstacles are merged, the result becomes the free-space map and the     |
+| roadmap is built over it. Growth and merging run on all cores.                |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "data_structure.hpp"
+#include "trapezoidal_map.hpp"
+#include "compute_path.hpp"
+
+struct PipelineStats {
+    size_t threads;             // threads the growth ran on
+    double grow;                // seconds per stage
+    double unite;
+    double build;
+    double removeInterior;
+    double roadMap;
+
+    PipelineStats() : threads(0), grow(0), unite(0), build(0), removeInterior(0), roadMap(0) {}
+};
+
+// Result of buildConfigurationSpace. Keep one around and build into it again
+// for the next scene: the sum and edge buffers keep their capacity.
+struct ConfigurationSpace {
+    std::vector<Polygon> grown;         // convex obstacle pieces grown by convex robot pieces
+    std::vector<Polygon> obstacles;     // their union, disjoint
+    std::vector<Segment> edges;         // its boundaries, as handed to the map
+    TrapezoidalMap freeSpace;
+    RoadMap roadMap;
+    PipelineStats stats;
+};
+
+// Configuration space of robot among obstacles. The robot is given around
+// its reference point, which is what the roadmap plans for. Concave robots
+// and obstacles are split into convex pieces, every pair of pieces is
+// summed, and the sums are merged by unionPolygons, so obstacles may be
+// close enough for their grown versions to overlap. threads == 0 uses one
+// per hardware thread.
+void buildConfigurationSpace(ConfigurationSpace& space,
+                             const Polygon& robot,
+                             const std::vector<Polygon>& obstacles,
+                             size_t threads = 0,
+                             unsigned seed = DEFAULT_BUILD_SEED);
+
+// The two halves of buildConfigurationSpace, for callers that grow the same
+// obstacles by several robots (orientation_slices.hpp): the convex pieces of
+// the obstacles are found once, and the space of a robot given as convex
+// counter-clockwise pieces around its reference point is built from them.
+void convexObstaclePieces(std::vector<Polygon>& pieces,
+                          const std::vector<Polygon>& obstacles,
+                          size_t threads = 0);
+void buildConfigurationSpace(ConfigurationSpace& space,
+                             const std::vector<Polygon>& robotPieces,
+                             const std::vector<Polygon>& obstaclePieces,
+                             size_t threads = 0,
+                             unsigned seed = DEFAULT_BUILD_SEED);
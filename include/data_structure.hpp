@@ -10,6 +10,8 @@
 
 #include <vector>
 #include <cstdio>
+#include <cmath>
+#include <utility>
 
 struct Point {
     double x, y;
@@ -38,11 +40,12 @@ struct Edge {
 struct Segment {
     Point p1, p2;
     int polygonIndex;
-    Segment() : p1(0), p2(0), polygonIndex(-1) {
+    bool polygonBelow;      // the obstacle lies below (right of a vertical edge)
+    Segment() : p1(0), p2(0), polygonIndex(-1), polygonBelow(false) {
         normalize();
     }
     Segment(const Point& p1, const Point& p2) 
-        : p1(p1), p2(p2), polygonIndex(-1) {
+        : p1(p1), p2(p2), polygonIndex(-1), polygonBelow(false) {
             normalize();
         }
     void normalize() {
@@ -71,10 +74,18 @@ struct Trapezoid {
     
     struct Node* node;
     
+    int slot;       // position in TrapezoidalMap::trapezoids, -1 when not listed
+    int roadNode;   // center node in the roadmap built over the map, -1 if none
+    
     Trapezoid() : top(NULL), bottom(NULL), 
                   upperLeft(NULL), lowerLeft(NULL),
                   upperRight(NULL), lowerRight(NULL),
-                  node(NULL) {}
+                  node(NULL), slot(-1), roadNode(-1) {}
+    
+    // Height of the top and bottom over x, finite even on the zero-width
+    // trapezoids that run along vertical edges
+    double topAt(double x) const;
+    double bottomAt(double x) const;
 };
 
 enum NodeType {
@@ -96,7 +107,9 @@ struct Node {
     Node* below;
     Node* parent;
     
+    int depth;      // longest path from the root
+    
     Node() : segment(NULL), trapezoid(NULL),
              left(NULL), right(NULL), 
-             above(NULL), below(NULL), parent(NULL) {}
+             above(NULL), below(NULL), parent(NULL), depth(0) {}
 };
@@ -0,0 +1,77 @@
+/*-------------------------------------------------------------------------------\
+| frozen_map.hpp                                                                 |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| Read-only, array based copy of a trapezoidal map's search structure. x-nodes  |
+| and y-nodes sit in arrays of records sized to their keys and refer to their   |
+| children by tagged 32-bit index; leaves are folded into those references.     |
+| Point location is a loop over two contiguous arrays instead of a pointer      |
+| chase.                                                                        |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "data_structure.hpp"
+#include "trapezoidal_map.hpp"
+
+static const uint32_t FROZEN_NONE = 0xFFFFFFFFu;
+
+// A reference to a node is its index in the array of its kind, tagged in the
+// top two bits. Leaves have no record: their reference carries the trapezoid
+// index itself. FROZEN_NONE carries the fourth tag.
+static const uint32_t FROZEN_X_NODE = 0u << 30;
+static const uint32_t FROZEN_Y_NODE = 1u << 30;
+static const uint32_t FROZEN_LEAF = 2u << 30;
+static const uint32_t FROZEN_INDEX = (1u << 30) - 1;
+
+// 24 bytes: the key point and the left and right child
+struct FrozenXNode {
+    double x, y;
+    uint32_t child[2];
+};
+
+// 40 bytes: the segment's left endpoint (a, b) and direction (c, d), and the
+// child above and below it
+struct FrozenYNode {
+    double a, b, c, d;
+    uint32_t child[2];
+};
+
+struct FrozenSearchStructure {
+    std::vector<FrozenXNode> xNodes;
+    std::vector<FrozenYNode> yNodes;
+    std::vector<Trapezoid*> trapezoids;     // payload of the leaves
+    uint32_t root;                          // FROZEN_NONE if the map is empty
+
+    FrozenSearchStructure() : root(FROZEN_NONE) {}
+    size_t nodeCount() const { return xNodes.size() + yNodes.size() + trapezoids.size(); }
+};
+
+// Compile the DAG of a finished map. The map must not be modified afterwards;
+// freeze it again after inserting or removing segments.
+FrozenSearchStructure freezeSearchStructure(const TrapezoidalMap& map);
+
+// Index (into trapezoids) of the trapezoid containing p, FROZEN_NONE if empty
+uint32_t queryFrozenIndex(const FrozenSearchStructure& fs, const Point& p);
+
+// queryFrozenIndex over node arrays kept elsewhere, e.g. mapped from a
+// snapshot file (map_snapshot.hpp), starting at the reference root
+uint32_t queryFrozenNodes(const FrozenXNode* xNodes, const FrozenYNode* yNodes, uint32_t root,
+                          const Point& p);
+
+// Query trapezoid containing point
+Trapezoid* queryFrozenStructure(const FrozenSearchStructure& fs, const Point& p);
+
+// Locate count points given as separate x and y arrays. Several queries walk
+// the structure together, with the node tests evaluated in SIMD lanes when the
+// target supports AVX2 or SSE2. Results match queryFrozenIndex point by point.
+void queryFrozenIndexBatch(const FrozenSearchStructure& fs, const double* xs,
+                           const double* ys, size_t count, uint32_t* out);
+
+// Batch version of queryFrozenStructure; out[i] is NULL where nothing is found
+void queryFrozenBatch(const FrozenSearchStructure& fs, const double* xs,
+                      const double* ys, size_t count, Trapezoid** out);
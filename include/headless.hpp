@@ -0,0 +1,22 @@
+/*-------------------------------------------------------------------------------\
+| headless.hpp                                                                   |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| Command-line mode without SDL: plans the queries of a scene file (see         |
+| scene_io.hpp) and prints one result line per query plus the stage timings,    |
+| or measures how each stage scales over generated scenes.                      |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+//   main run <scene> [bfs|astar|alt|taut] [--paths]
+//   main convert <scene> <binary scene>
+//   main bench [max edges] [csv|json] [queries] [seed]
+//
+// bench sweeps generated scenes (scene_generator.hpp) of 10, 30, 100, ...
+// edges up to max edges and writes the time of each pipeline stage per size.
+//
+// argv is main's. Returns the process exit code: 0 once the scene was read
+// and planned, whatever the individual queries returned.
+int headless_main(int argc, char** argv);
@@ -0,0 +1,106 @@
+/*-------------------------------------------------------------------------------\
+| indexed_heap.hpp                                                               |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| 4-ary min-heap over node ids 0..n-1 with decrease-key. Every id remembers      |
+| where it sits in the heap, or that it was popped already. The heap does not   |
+| know which ids were pushed since the last clear(); the caller tracks that     |
+| (see SearchScratch), so clearing is O(1).                                      |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+class IndexedHeap {
+public:
+    static constexpr uint32_t CLOSED = 0xFFFFFFFFu;
+
+    // Make room for ids 0..n-1
+    void resize(size_t n) {
+        if (position.size() != n) position.resize(n);
+    }
+
+    bool empty() const { return items.empty(); }
+    size_t size() const { return items.size(); }
+
+    // Only meaningful for ids pushed since the last clear()
+    bool closed(uint32_t id) const { return position[id] == CLOSED; }
+
+    double topKey() const { return items[0].key; }
+
+    void push(uint32_t id, double key) {
+        items.push_back(Item{key, id});
+        siftUp(items.size() - 1);
+    }
+
+    // id must be queued and key no larger than its current one
+    void decreaseKey(uint32_t id, double key) {
+        size_t i = position[id];
+        items[i].key = key;
+        siftUp(i);
+    }
+
+    // Removes the smallest item and marks its id closed
+    uint32_t pop() {
+        uint32_t id = items[0].id;
+        position[id] = CLOSED;
+        Item last = items.back();
+        items.pop_back();
+        if (!items.empty()) {
+            items[0] = last;
+            position[last.id] = 0;
+            siftDown(0);
+        }
+        return id;
+    }
+
+    void clear() { items.clear(); }
+
+private:
+    struct Item {
+        double key;
+        uint32_t id;
+    };
+
+    static constexpr size_t ARITY = 4;
+
+    void siftUp(size_t i) {
+        Item item = items[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / ARITY;
+            if (!(item.key < items[parent].key)) break;
+            items[i] = items[parent];
+            position[items[i].id] = static_cast<uint32_t>(i);
+            i = parent;
+        }
+        items[i] = item;
+        position[item.id] = static_cast<uint32_t>(i);
+    }
+
+    void siftDown(size_t i) {
+        Item item = items[i];
+        size_t n = items.size();
+        for (;;) {
+            size_t first = i * ARITY + 1;
+            if (first >= n) break;
+            size_t last = first + ARITY < n ? first + ARITY : n;
+            size_t best = first;
+            for (size_t c = first + 1; c < last; c++) {
+                if (items[c].key < items[best].key) best = c;
+            }
+            if (!(items[best].key < item.key)) break;
+            items[i] = items[best];
+            position[items[i].id] = static_cast<uint32_t>(i);
+            i = best;
+        }
+        items[i] = item;
+        position[item.id] = static_cast<uint32_t>(i);
+    }
+
+    std::vector<Item> items;
+    std::vector<uint32_t> position;     // heap index or CLOSED
+};
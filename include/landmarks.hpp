@@ -0,0 +1,49 @@
+/*-------------------------------------------------------------------------------\
+| landmarks.hpp                                                                  |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| Landmark distance tables for ALT search (A*, landmarks, triangle inequality). |
+| Built once per roadmap: for K landmark nodes the exact roadmap distance from  |
+| every node is stored, and |d(L, goal) - d(L, v)| bounds the remaining cost   |
+| from v far more tightly than the straight line does around long obstacles.    |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "compute_path.hpp"
+
+static const size_t DEFAULT_LANDMARK_COUNT = 8;
+
+struct LandmarkTable {
+    uint64_t roadMapFingerprint;        // roadmap the distances belong to
+    uint32_t nodeCount;
+    std::vector<uint32_t> landmarks;
+    std::vector<double> distances;      // distances[node * count() + k], INFINITY if unreachable
+
+    LandmarkTable() : roadMapFingerprint(0), nodeCount(0) {}
+
+    size_t count() const { return landmarks.size(); }
+    const double* row(uint32_t node) const { return &distances[static_cast<size_t>(node) * count()]; }
+
+    // True if the table was built for this roadmap (same nodes and edges)
+    bool matches(const RoadMap& roadMap) const;
+};
+
+// Hash of the roadmap's nodes, edges and lengths
+uint64_t fingerprintRoadMap(const RoadMap& roadMap);
+
+// Picks up to count landmarks in the largest connected component by
+// farthest-point selection, each as far along the roadmap from the ones
+// before as possible, and runs one Dijkstra from each. O(count * E log V).
+LandmarkTable buildLandmarkTable(const RoadMap& roadMap, size_t count = DEFAULT_LANDMARK_COUNT);
+
+// Binary dump of a table, for reuse across runs on the same scene. load
+// returns false (leaving table untouched) if the file is missing or malformed;
+// check matches() before using it with a roadmap.
+bool saveLandmarkTable(const LandmarkTable& table, const char* filename);
+bool loadLandmarkTable(LandmarkTable& table, const char* filename);
@@ -0,0 +1,116 @@
+/*-------------------------------------------------------------------------------\
+| map_snapshot.hpp                                                               |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| Binary snapshot of a built free-space map and its roadmap. Every record has a |
+| fixed layout and refers to others by 32-bit index, never by pointer, so the   |
+| file is mmap'ed as is and point location and path queries read the mapped    |
+| pages directly. Opening one costs a few system calls instead of a rebuild.    |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "data_structure.hpp"
+#include "trapezoidal_map.hpp"
+#include "frozen_map.hpp"
+#include "compute_path.hpp"
+
+// File layout: a SnapshotHeader at offset 0, then one section per array,
+// each starting on an 8-byte boundary. Integers and doubles are stored in the
+// writer's byte order; a file from a machine of the other order is refused.
+struct SnapshotSection {
+    uint64_t offset;            // from the start of the file
+    uint64_t count;             // elements, not bytes
+};
+
+struct SnapshotSegment {
+    double x1, y1, x2, y2;      // left and right endpoint
+    int32_t polygonIndex;
+    uint32_t unused;
+};
+
+static const uint32_t SNAPSHOT_FREE = 1;   // listed in the map, i.e. free space
+
+struct SnapshotTrapezoid {
+    double leftX, leftY, rightX, rightY;
+    uint32_t top, bottom;                   // segment indices
+    uint32_t upperLeft, lowerLeft;          // trapezoid indices, FROZEN_NONE if none
+    uint32_t upperRight, lowerRight;
+    uint32_t roadNode;                      // center node, ROADMAP_NONE if none
+    uint32_t flags;                         // SNAPSHOT_FREE
+};
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t componentCount;
+    uint64_t fileSize;
+    uint32_t root;                      // tagged reference, as in FrozenSearchStructure
+    uint32_t unused;
+    SnapshotSection xNodes;             // FrozenXNode
+    SnapshotSection yNodes;             // FrozenYNode
+    SnapshotSection trapezoids;         // SnapshotTrapezoid
+    SnapshotSection segments;           // SnapshotSegment
+    SnapshotSection positions;          // Point, one per roadmap node
+    SnapshotSection rowBegin;           // uint32_t, as in RoadMap
+    SnapshotSection rowEnd;
+    SnapshotSection neighbors;
+    SnapshotSection lengths;            // double
+    SnapshotSection component;          // uint32_t
+    SnapshotSection nodeTrapezoid;      // uint32_t trapezoid index, FROZEN_NONE for crossings
+};
+
+// An open snapshot. The pointers lead into the mapping and stay valid until
+// closeMapSnapshot or destruction; nothing is copied out of the file.
+struct MapSnapshot {
+    const FrozenXNode* xNodes;
+    const FrozenYNode* yNodes;
+    uint32_t root;
+    const SnapshotTrapezoid* trapezoids;
+    size_t trapezoidCount;
+    const SnapshotSegment* segments;
+    size_t segmentCount;
+    RoadMapView roadMap;
+    const uint32_t* nodeTrapezoid;
+    uint32_t componentCount;
+
+    void* mapping;
+    size_t mappingSize;
+
+    MapSnapshot();
+    ~MapSnapshot();
+    MapSnapshot(const MapSnapshot&) = delete;
+    MapSnapshot& operator=(const MapSnapshot&) = delete;
+
+    bool isOpen() const { return mapping != NULL; }
+};
+
+// Write map and the roadmap built over it to filename. The map may have been
+// updated in place before; its search structure is frozen on the way out.
+bool saveMapSnapshot(const TrapezoidalMap& map, const RoadMap& roadMap, const char* filename);
+
+// Map filename read-only. Checks the header and that every section lies
+// inside the file, but does not walk the records: a file that passes is
+// trusted to have been written by saveMapSnapshot. Returns false (leaving
+// snapshot closed) if the file is missing or malformed.
+bool openMapSnapshot(MapSnapshot& snapshot, const char* filename);
+void closeMapSnapshot(MapSnapshot& snapshot);
+
+// Index of the trapezoid containing p, FROZEN_NONE if the snapshot is empty
+uint32_t locateInSnapshot(const MapSnapshot& snapshot, const Point& p);
+
+// PathComputer::queryPath answered from the snapshot. Read-only, so threads
+// may share a snapshot as long as each passes its own scratch.
+PathStatus querySnapshotPath(const MapSnapshot& snapshot,
+                             const Point& pstart,
+                             const Point& pgoal,
+                             SearchScratch& scratch,
+                             std::vector<Point>& path,
+                             SearchAlgorithm algorithm = SEARCH_BFS,
+                             const LandmarkTable* landmarks = NULL);
@@ -7,6 +7,24 @@
 
 class MinkowskiSum {
 public:
+    // Edge merge of two convex polygons in counter-clockwise order, O(n + m)
     static Polygon MINKOWSKISUM(const Polygon& P, const Polygon& R);
+    // MINKOWSKISUM without the traces, written to out so that its storage is
+    // reused across calls; for pipelines that sum many obstacles
+    static void MINKOWSKISUM(const Polygon& P, const Polygon& R, Polygon& out);
     static void normalizePolygon(Polygon& poly);
+    
+    // Split a simple polygon into convex pieces, counter-clockwise: ear
+    // clipping, then Hertel-Mehlhorn (drop every diagonal whose two sides
+    // still form a convex polygon together). At most four times the minimum
+    // number of pieces; O(n^2). A convex P comes back as the only piece.
+    static std::vector<Polygon> convexDecomposition(const Polygon& P);
+    
+    // Minkowski sum of a simple, possibly concave P with a convex R: P is
+    // decomposed and every piece merged with R by MINKOWSKISUM, across up to
+    // threads threads (0 = one per hardware thread) when there are enough
+    // pieces to pay for them. The result is the union of the returned convex
+    // polygons, which overlap where the pieces met.
+    static std::vector<Polygon> MINKOWSKISUMNONCONVEX(const Polygon& P, const Polygon& R,
+                                                      size_t threads = 0);
 };
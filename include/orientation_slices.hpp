@@ -0,0 +1,107 @@
+/*-------------------------------------------------------------------------------\
+| orientation_slices.hpp                                                         |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| Planning for a robot that turns as well as moves. Headings are cut into K     |
+| slices; each slice is a configuration space for the region the robot sweeps   |
+| while turning within it, so a point free in a slice is free at every heading  |
+| the slice stands for. The slices share the convex pieces of the obstacles and |
+| are built in parallel. Their roadmaps are joined into one layered graph by    |
+| links between neighbouring slices wherever a trapezoid center of one lies in  |
+| the free space of the other: there the robot can turn on the spot from one    |
+| slice to the next.                                                            |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "data_structure.hpp"
+#include "configuration_space.hpp"
+#include "compute_path.hpp"
+#include "landmarks.hpp"
+
+// Position of the robot's reference point and its heading in radians,
+// counter-clockwise from the heading the robot polygon is given in
+struct Pose {
+    Point position;
+    double angle;
+
+    Pose() : angle(0) {}
+    Pose(const Point& position, double angle) : position(position), angle(angle) {}
+};
+
+struct OrientationStats {
+    size_t threads;             // threads the slices were built on
+    double decompose;           // seconds per stage
+    double slices;
+    double link;
+    double landmarks;
+
+    OrientationStats() : threads(0), decompose(0), slices(0), link(0), landmarks(0) {}
+};
+
+// Result of buildOrientationSlices. Slice k stands for the headings within
+// half a slice width of angles[k] = 2 pi k / K.
+//
+// graph is the layered graph, a roadmap in its own right over the trapezoid
+// centers: node nodeBase[k] + i is center node i of slices[k].roadMap. Its
+// edges inside a slice go from center to center through the wall crossing
+// between them, which is node crossing[e] of the slice's roadmap for the
+// edge at graph.neighbors[e]. The other edges are links to centers of the
+// neighbouring slices (K - 1 and 0 included), one per pair of centers that
+// lie in each other's free space, where crossing is ROADMAP_NONE. A link is
+// a turn on the spot at one end and a straight move inside one trapezoid to
+// the other; turnsFirst, also parallel to graph.neighbors, says whether the
+// turn comes first, at the node's own position, or last. Its length is the
+// move plus reach times the angle turned, the distance the farthest robot
+// vertex travels. graph.component labels the connected parts of the layered
+// graph, and landmarks is an ALT table built over it.
+struct OrientationSlices {
+    std::vector<double> angles;
+    std::vector<ConfigurationSpace> slices;
+    std::vector<uint32_t> nodeBase;         // K + 1 entries
+    RoadMap graph;
+    std::vector<uint8_t> turnsFirst;
+    std::vector<uint32_t> crossing;
+    LandmarkTable landmarks;
+    double reach;                           // farthest robot vertex from the reference point
+    OrientationStats stats;
+
+    OrientationSlices() : reach(0) {}
+
+    size_t sliceCount() const { return slices.size(); }
+    size_t linkCount() const;
+    // Slice whose headings include angle (any real number)
+    size_t sliceFor(double angle) const;
+    // Slice a layered graph node belongs to
+    size_t sliceOf(uint32_t node) const;
+};
+
+// sliceCount slices (at least 3) of the configuration space of robot among
+// obstacles; see buildConfigurationSpace for what robot and obstacles may
+// be. The obstacles are decomposed once, then every slice grows them by the
+// swept robot, on its own thread out of threads (0: one per hardware
+// thread). The links are found in parallel as well; the landmark table,
+// which keeps queries from spreading through every slice, is built last.
+void buildOrientationSlices(OrientationSlices& space,
+                            const Polygon& robot,
+                            const std::vector<Polygon>& obstacles,
+                            size_t sliceCount = 72,
+                            size_t threads = 0,
+                            unsigned seed = DEFAULT_BUILD_SEED);
+
+// Shortest path through the layered graph, found by ALT search. path runs
+// from start to goal; between consecutive poses the robot either moves in a
+// straight line or turns on the spot by less than a slice width, the short
+// way round. Start and goal are blocked unless free in the slices of their
+// headings. Only reads space, so concurrent queries each pass their own
+// scratch.
+PathStatus queryOrientationPath(const OrientationSlices& space,
+                                const Pose& start,
+                                const Pose& goal,
+                                SearchScratch& scratch,
+                                std::vector<Pose>& path);
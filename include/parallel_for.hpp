@@ -0,0 +1,46 @@
+/*-------------------------------------------------------------------------------\
+| parallel_for.hpp                                                               |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| A loop over [0, count) whose chunks threads take in turn off an atomic        |
+| counter, so chunks that take longer than others even out. The one way the     |
+| library spreads work over threads: the non-convex Minkowski sum, the polygon  |
+| union, and the pipelines that grow obstacles and build orientation slices all |
+| go through it.                                                                |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+
+// A thread count as parallelFor takes it (0: one per hardware thread),
+// capped at limit; for callers whose small inputs are not worth the threads
+inline size_t threadLimit(size_t threads, size_t limit) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(threads, limit));
+}
+
+// body(begin, end) over [0, count) in chunks handed out to up to threads
+// threads, the calling one included (0: one per hardware thread). Returns
+// the number of threads used.
+template <typename Body>
+size_t parallelFor(size_t count, size_t threads, size_t chunk, const Body& body) {
+    threads = threadLimit(threads, (count + chunk - 1) / chunk);
+
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk)) {
+            body(begin, std::min(count, begin + chunk));
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) workers.emplace_back(work);
+    work();
+    for (std::thread& w : workers) w.join();
+    return threads;
+}
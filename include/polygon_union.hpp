@@ -0,0 +1,28 @@
+/*-------------------------------------------------------------------------------\
+| polygon_union.hpp                                                              |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| Union of overlapping obstacles into disjoint boundaries. The trapezoidal map  |
+| needs edges that do not cross, and interior trapezoids are recognised by the  |
+| side of each edge its polygon lies on, which only means something for         |
+| boundaries that do not overlap, so grown obstacles have to be merged before   |
+| their edges are extracted.                                                    |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "data_structure.hpp"
+
+// Outer boundaries of the union of simple polygons, counter-clockwise, none
+// overlapping or containing another. A sweep over the bounding boxes groups
+// the polygons that may meet; a polygon alone in its group is copied as it
+// is. In every other group a sweep over the edges finds where they cross,
+// the edges are split there, and the pieces with the outside of every
+// polygon on their right are chained into boundaries. Holes in the union are
+// filled in: free space enclosed by obstacles cannot be reached from outside.
+// Groups are merged on up to threads threads (0: one per hardware thread).
+std::vector<Polygon> unionPolygons(const std::vector<Polygon>& polygons, size_t threads = 0);
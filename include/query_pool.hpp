@@ -0,0 +1,93 @@
+/*-------------------------------------------------------------------------------\
+| query_pool.hpp                                                                 |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| Worker pool that answers batches of point-location and path queries against   |
+| one shared map and roadmap.                                                    |
+|                                                                                |
+| Thread safety: queries only read the TrapezoidalMap, FrozenSearchStructure    |
+| and RoadMap they are given. Any number of batches may share them, but none of |
+| them may be modified (segments inserted, trapezoids removed, roadmap rebuilt, |
+| cleanup()) while a batch is running. Each worker owns its search scratch, so  |
+| nothing is locked on the query path. A pool runs one batch at a time, so      |
+| submit batches from a single thread.                                           |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+#include "data_structure.hpp"
+#include "trapezoidal_map.hpp"
+#include "frozen_map.hpp"
+#include "compute_path.hpp"
+
+struct PathQuery {
+    Point start;
+    Point goal;
+};
+
+struct PathResult {
+    PathStatus status;
+    std::vector<Point> path;
+    size_t settled;         // roadmap nodes the search expanded
+};
+
+class QueryPool {
+public:
+    // threads == 0 picks one worker per hardware thread
+    explicit QueryPool(size_t threads = 0);
+    ~QueryPool();
+
+    QueryPool(const QueryPool&) = delete;
+    QueryPool& operator=(const QueryPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // out[i] is the trapezoid containing points[i]
+    void locate(const TrapezoidalMap& map, const std::vector<Point>& points,
+                std::vector<Trapezoid*>& out);
+
+    // Same over a frozen structure; every worker runs the batch API on its share
+    void locate(const FrozenSearchStructure& fs, const double* xs, const double* ys,
+                size_t count, Trapezoid** out);
+
+    // out[i] answers queries[i] as PathComputer::queryPath would
+    void computePaths(const TrapezoidalMap& freeSpaceMap, const RoadMap& roadMap,
+                      const std::vector<PathQuery>& queries, std::vector<PathResult>& out,
+                      SearchAlgorithm algorithm = SEARCH_BFS,
+                      const LandmarkTable* landmarks = NULL);
+
+    // valid[i] = PathComputer::isValidPath(freeSpaceMap, paths[i])
+    void validatePaths(const TrapezoidalMap& freeSpaceMap,
+                       const std::vector<std::vector<Point>>& paths,
+                       std::vector<uint8_t>& valid);
+
+private:
+    typedef std::function<void(size_t worker, size_t begin, size_t end)> Job;
+
+    // Split [0, count) into chunks of the given size and hand them out to the
+    // workers until none are left. Blocks until the whole range is done.
+    void run(size_t count, size_t chunk, const Job& job);
+    void workerLoop(size_t worker);
+
+    std::vector<std::thread> workers;
+    std::vector<SearchScratch> scratch;     // one per worker
+
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const Job* job;
+    size_t jobCount;
+    size_t jobChunk;
+    std::atomic<size_t> nextBegin;
+    size_t generation;
+    size_t active;
+    bool stopping;
+};
@@ -0,0 +1,30 @@
+/*-------------------------------------------------------------------------------\
+| scene_generator.hpp                                                            |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| Random scenes of any size for measuring the pipeline. Obstacles sit one per   |
+| cell of a square grid, so they never overlap or touch, and are either convex  |
+| or star-shaped concave polygons. The same size and seed give the same scene   |
+| on every platform: only mt19937 output is used, no library distributions.     |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <cstddef>
+
+#include "scene_io.hpp"
+
+struct SceneParameters {
+    size_t edges;               // stop once the obstacles have at least this many
+    size_t queries;             // random start/goal pairs over the scene
+    double concaveFraction;     // share of obstacles that are concave
+    unsigned seed;
+
+    SceneParameters() : edges(1000), queries(100), concaveFraction(0.3), seed(1) {}
+};
+
+// Cells are 1 x 1 and the grid is as close to square as the obstacle count
+// allows; queries are drawn uniformly over the whole grid, so some of their
+// ends fall inside obstacles
+Scene generateScene(const SceneParameters& parameters);
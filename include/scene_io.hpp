@@ -0,0 +1,37 @@
+/*-------------------------------------------------------------------------------\
+| scene_io.hpp                                                                   |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| Obstacle polygons and start/goal queries read from a file, so scenes can be   |
+| planned without recompiling. The file is mapped and parsed in place: numbers  |
+| are converted straight from the mapped text or copied from the binary form.   |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+
+#include "data_structure.hpp"
+
+// Query i runs from starts[i] to goals[i]
+struct Scene {
+    std::vector<Polygon> obstacles;
+    std::vector<Point> starts;
+    std::vector<Point> goals;
+};
+
+// Text form, one record per line; '#' starts a comment:
+//
+//   polygon x1 y1 x2 y2 x3 y3 ...
+//   query sx sy gx gy
+//
+// Binary form (native byte order): "TMSC", uint32 version, uint32 polygon
+// count, uint32 query count, then per polygon a uint32 vertex count and its
+// x y pairs as doubles, then sx sy gx gy per query.
+//
+// loadScene tells the two apart by the magic. Returns false (leaving scene
+// untouched) if the file is missing or malformed, including coordinates that
+// are not finite; the first error found is traced with its line number.
+bool loadScene(Scene& scene, const char* filename);
+bool saveSceneBinary(const Scene& scene, const char* filename);
@@ -64,4 +64,4 @@ void drawDAG(SDL_Renderer* renderer, TTF_Font* font, Node* root,
 void drawLegend(SDL_Renderer* renderer, TTF_Font* font);
 void drawPath(SDL_Renderer* renderer, const std::vector<Point>& path, Uint8 r, Uint8 g, Uint8 b, bool rightSide = false);
 
-void drawRoadMap(SDL_Renderer* renderer, RoadMap& roadMap, bool rightSide = false);
+void drawRoadMap(SDL_Renderer* renderer, const RoadMap& roadMap, bool rightSide = false);
@@ -0,0 +1,135 @@
+/*-------------------------------------------------------------------------------\
+| trace.hpp                                                                      |
++--------------------------------------------------------------------------------+
+| CS302_Analysis_and_Design_of_Algorithms                                        |
++--------------------------------------------------------------------------------+
+| Diagnostics for every module. Trace points above TRACE_COMPILE_LEVEL compile   |
+| to nothing, arguments included. Enabled ones are formatted into a fixed-size   |
+| record and pushed onto a lock-free ring buffer; trace::flush() hands the       |
+| buffered records to the runtime sink (stdout/stderr by default).               |
+|                                                                                |
+|   static const char TRACE_MODULE[] = "my_module";                              |
+|   TRACE_DEBUG("Inserting segment " << i << " at " << p.x);                     |
+\-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#define TRACE_LEVEL_OFF   0
+#define TRACE_LEVEL_ERROR 1
+#define TRACE_LEVEL_WARN  2
+#define TRACE_LEVEL_INFO  3
+#define TRACE_LEVEL_DEBUG 4
+
+// Build with -DTRACE_COMPILE_LEVEL=4 to keep the per-segment debug traces
+#ifndef TRACE_COMPILE_LEVEL
+#define TRACE_COMPILE_LEVEL TRACE_LEVEL_INFO
+#endif
+
+static const size_t TRACE_MESSAGE_SIZE = 232;
+
+struct TraceRecord {
+    int level;
+    const char* module;         // string literal of the emitting file
+    uint64_t timestampNs;       // steady clock
+    uint32_t length;
+    char text[TRACE_MESSAGE_SIZE];
+};
+
+// Called by flush(), one record at a time and never concurrently
+typedef void (*TraceSink)(const TraceRecord& record);
+
+namespace trace {
+
+extern std::atomic<int> runtimeLevel;
+
+inline bool enabled(int level) {
+    return level <= runtimeLevel.load(std::memory_order_relaxed);
+}
+
+// Runtime filter on top of the compile-time one; TRACE_LEVEL_WARN unless set
+void setLevel(int level);
+int level();
+
+// NULL discards records. Flushes what is buffered to the old sink first.
+void setSink(TraceSink sink);
+void stdoutSink(const TraceRecord& record);
+
+// Push one record. Never blocks; when the buffer is full and cannot be
+// drained right away the record is dropped and counted.
+void write(int level, const char* module, const char* text, size_t length);
+
+// Drain the buffer into the sink. Returns immediately if another thread is
+// already draining. Also runs at exit.
+void flush();
+
+size_t dropped();
+
+}  // namespace trace
+
+// Formats one trace record on the stack; committed by the destructor
+class TraceLine {
+public:
+    TraceLine(int level, const char* module) : level(level), module(module), length(0) {}
+    ~TraceLine() { trace::write(level, module, text, length); }
+
+    TraceLine(const TraceLine&) = delete;
+    TraceLine& operator=(const TraceLine&) = delete;
+
+    TraceLine& operator<<(const char* s);
+    TraceLine& operator<<(const std::string& s) { return *this << s.c_str(); }
+    TraceLine& operator<<(char c);
+    TraceLine& operator<<(bool b) { return *this << (b ? '1' : '0'); }
+    TraceLine& operator<<(int v) { return *this << static_cast<long long>(v); }
+    TraceLine& operator<<(long v) { return *this << static_cast<long long>(v); }
+    TraceLine& operator<<(long long v);
+    TraceLine& operator<<(unsigned v) { return *this << static_cast<unsigned long long>(v); }
+    TraceLine& operator<<(unsigned long v) { return *this << static_cast<unsigned long long>(v); }
+    TraceLine& operator<<(unsigned long long v);
+    TraceLine& operator<<(double v);
+    TraceLine& operator<<(const void* p);
+
+private:
+    int level;
+    const char* module;
+    size_t length;
+    char text[TRACE_MESSAGE_SIZE];
+};
+
+#define TRACE_AT(lvl, msg)                                      \
+    do {                                                        \
+        if (trace::enabled(lvl)) {                              \
+            TraceLine traceLine_(lvl, TRACE_MODULE);            \
+            traceLine_ << msg;                                  \
+        }                                                       \
+    } while (0)
+
+#define TRACE_DISABLED(msg) do {} while (0)
+
+#if TRACE_COMPILE_LEVEL >= TRACE_LEVEL_ERROR
+#define TRACE_ERROR(msg) TRACE_AT(TRACE_LEVEL_ERROR, msg)
+#else
+#define TRACE_ERROR(msg) TRACE_DISABLED(msg)
+#endif
+
+#if TRACE_COMPILE_LEVEL >= TRACE_LEVEL_WARN
+#define TRACE_WARN(msg) TRACE_AT(TRACE_LEVEL_WARN, msg)
+#else
+#define TRACE_WARN(msg) TRACE_DISABLED(msg)
+#endif
+
+#if TRACE_COMPILE_LEVEL >= TRACE_LEVEL_INFO
+#define TRACE_INFO(msg) TRACE_AT(TRACE_LEVEL_INFO, msg)
+#else
+#define TRACE_INFO(msg) TRACE_DISABLED(msg)
+#endif
+
+#if TRACE_COMPILE_LEVEL >= TRACE_LEVEL_DEBUG
+#define TRACE_DEBUG(msg) TRACE_AT(TRACE_LEVEL_DEBUG, msg)
+#else
+#define TRACE_DEBUG(msg) TRACE_DISABLED(msg)
+#endif
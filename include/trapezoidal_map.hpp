@@ -8,23 +8,62 @@
 #include <cmath>
 
 #include "data_structure.hpp"
+#include "arena.hpp"
 
 using namespace std;
 
+// Seed used when the caller does not pick one, so builds are reproducible
+const unsigned DEFAULT_BUILD_SEED = 1;
+// Rebuild when the DAG gets deeper than this multiple of ln(n)
+const double DEFAULT_DEPTH_FACTOR = 8.0;
+// Give up re-shuffling after this many builds and keep the last one
+const int MAX_BUILD_ATTEMPTS = 8;
+
+struct BuildStats {
+    unsigned seed;      // seed passed to BuildTrapezoidalMap
+    int attempts;       // number of insertion orders tried
+    int maxDepth;       // deepest leaf of the DAG
+    double avgDepth;    // mean leaf depth over the map's trapezoids
+    int depthLimit;     // depth that triggers a rebuild
+    
+    BuildStats() : seed(0), attempts(0), maxDepth(0), avgDepth(0), depthLimit(0) {}
+};
+
 struct TrapezoidalMap {
     vector<Trapezoid*> trapezoids;
     Node* root;
     vector<Segment*> segments;
+
+    // Every trapezoid, DAG node and segment of the map lives in these regions
+    Arena<Trapezoid> trapezoidArena;
+    Arena<Node> nodeArena;
+    Arena<Segment> segmentArena;
+    
+    BuildStats stats;
     
     TrapezoidalMap() : root(NULL) {};
+    Trapezoid* newTrapezoid();
+    Node* newNode();
+    Segment* newSegment(const Segment& s);
     void addTrapezoid(Trapezoid* t);
+    // O(1): the last trapezoid is moved into t's slot
     void removeTrapezoid(Trapezoid* t);
+    // Drop every trapezoid matching pred in one linear pass, keeping the
+    // order of the rest. Returns the number removed.
+    size_t removeTrapezoidsIf(bool (*pred)(Trapezoid*));
+    bool contains(const Trapezoid* t) const;
     void cleanup();
 };
 
 // Query trapezoid containing point
 Node* queryTrapezoidMap(Node* n, const Point& p);
 
+// Locate the trapezoid a segment starts in. Same as queryTrapezoidMap on the
+// left endpoint, except when that endpoint lies on a y-node segment (shared
+// polygon vertex): then the slopes decide which side the segment is on. A
+// segment lying along a y-node segment goes below it, or above if asked to.
+Node* locateSegmentStart(Node* n, const Segment& seg, bool collinearAbove = false);
+
 // Find all trapezoids intersected by a segment
 void findIntersectedTrapezoids(Node* root, const Segment& seg, 
                                vector<Trapezoid*>& result);
@@ -38,9 +77,26 @@ void insertAcrossMultipleTrapezoids(TrapezoidalMap& map,
                                     const vector<Trapezoid*>& intersected,
                                     Segment* seg);
 
-TrapezoidalMap BuildTrapezoidalMap(vector<Segment>& S);
+// The segment of the map with the same endpoints as seg, or NULL
+Segment* findSegment(Node* root, const Segment& seg);
+
+// Undo the insertion of seg. The trapezoids above and below it are merged
+// slab by slab, and so are those on both sides of an endpoint no other
+// segment uses any more; the DAG leaves of the old trapezoids turn into
+// x-node trees over the new ones. Costs O(trapezoids along seg). Appends
+// the old trapezoids to removed; returns false, changing nothing, if the map
+// around seg is not as expected. seg stays allocated until cleanup().
+// Every deletion deepens the DAG a little around seg, so long sequences of
+// updates should rebuild the map once stats.maxDepth passes stats.depthLimit.
+bool deleteSegment(TrapezoidalMap& map, Segment* seg, vector<Trapezoid*>& removed);
+
+// Randomized incremental construction. Segments are inserted in an order
+// shuffled from seed; if the DAG grows deeper than depthFactor * ln(n) the
+// map is rebuilt from a fresh shuffle.
+TrapezoidalMap BuildTrapezoidalMap(vector<Segment>& S,
+                                   unsigned seed = DEFAULT_BUILD_SEED,
+                                   double depthFactor = DEFAULT_DEPTH_FACTOR);
 
-void deleteSearchStructure(Node* node);
 void validateTrapezoid(Trapezoid* t);
 void validateSearchStructure(Node* node);
 void validateDAGStructure(Node* node, int depth = 0);
@@ -1,27 +1,32 @@
 #include "compute_free_space.hpp"
+#include "compute_path.hpp"
+#include "trace.hpp"
 #include <iostream>
 #include <cmath>
 #include <set>
+#include <algorithm>
 
 using namespace std;
 
-TrapezoidalMap FreeSpaceComputer::COMPUTEFREESPACE(const vector<Polygon>& S) {
-    cout << "=== COMPUTEFREESPACE Algorithm ===" << endl;
-    cout << "Input: " << S.size() << " polygons (obstacles)" << endl;
+static const char TRACE_MODULE[] = "compute_free_space";
+
+TrapezoidalMap FreeSpaceComputer::COMPUTEFREESPACE(const vector<Polygon>& S, unsigned seed) {
+    TRACE_INFO("=== COMPUTEFREESPACE Algorithm ===");
+    TRACE_INFO("Input: " << S.size() << " polygons (obstacles)");
     
     // Step 1: Extract all edges from obstacles
     vector<Segment> E = extractEdges(S);
-    cout << "Extracted " << E.size() << " edges from polygons" << endl;
+    TRACE_INFO("Extracted " << E.size() << " edges from polygons");
     
     // Step 2: Build trapezoidal decomposition
-    cout << "Building trapezoidal map..." << endl;
-    TrapezoidalMap T = BuildTrapezoidalMap(E);
-    cout << "Trapezoidal map built with " << T.trapezoids.size() << " trapezoids" << endl;
+    TRACE_INFO("Building trapezoidal map...");
+    TrapezoidalMap T = BuildTrapezoidalMap(E, seed);
+    TRACE_INFO("Trapezoidal map built with " << T.trapezoids.size() << " trapezoids");
     
     // Step 3: Remove trapezoids that are inside obstacles
-    cout << "Identifying and removing interior trapezoids..." << endl;
-    removeInteriorTrapezoids(T, S);
-    cout << "Free space computed. Remaining trapezoids: " << T.trapezoids.size() << endl;
+    TRACE_INFO("Identifying and removing interior trapezoids...");
+    removeInteriorTrapezoids(T);
+    TRACE_INFO("Free space computed. Remaining trapezoids: " << T.trapezoids.size());
     
     return T;
 }
@@ -33,45 +38,216 @@ vector<Segment> FreeSpaceComputer::extractEdges(const vector<Polygon>& polygons)
         const Polygon& poly = polygons[polyIdx];
         
         if (poly.vertices.size() < 3) {
-            cerr << "Warning: Polygon with less than 3 vertices skipped" << endl;
+            TRACE_WARN("Polygon with less than 3 vertices skipped");
             continue;
         }
 
-        for (size_t i = 0; i < poly.vertices.size(); i++) {
-            size_t next = (i + 1) % poly.vertices.size();
-            Segment edge(poly.vertices[i], poly.vertices[next]);
-            edge.polygonIndex = polyIdx;
-            edges.push_back(edge);
-        }
+        size_t first = edges.size();
+        edges.resize(first + poly.vertices.size());
+        extractEdges(poly, static_cast<int>(polyIdx), &edges[first]);
     }
     
     return edges;
 }
 
+// Edges are stored left to right, which loses the direction they had around
+// the polygon; the interior lies left of a counter-clockwise edge, so the
+// orientation and whether the edge was turned around tell the side
+void FreeSpaceComputer::extractEdges(const Polygon& polygon, int polygonIndex, Segment* out) {
+    const vector<Point>& v = polygon.vertices;
+    size_t n = v.size();
+    double area = 0;
+    for (size_t i = 0; i < n; i++) {
+        const Point& a = v[i];
+        const Point& b = v[(i + 1) % n];
+        area += a.x * b.y - b.x * a.y;
+    }
+    bool counterClockwise = area > 0;
+    
+    for (size_t i = 0; i < n; i++) {
+        const Point& a = v[i];
+        const Point& b = v[(i + 1) % n];
+        Segment& edge = out[i];
+        edge = Segment(a, b);
+        edge.polygonIndex = polygonIndex;
+        edge.polygonBelow = counterClockwise == (b < a);
+    }
+}
+
+// Inside an obstacle if it lies on the obstacle side of both its top and
+// its bottom. Both belonging to one polygon is not enough: the free notch of
+// a concave obstacle is bounded by two of its edges as well.
 bool FreeSpaceComputer::isTrapezoidInsideObstacle(Trapezoid* trap) {
-    if (!trap) {
+    if (!trap || !trap->top || !trap->bottom) {
         return false;
     }
-    // A trapezoid is inside an obstacle if BOTH its top and bottom edges belong to the SAME obstacle
-    int topPolyIndex = (trap->top && trap->top->polygonIndex != -1) 
-                       ? trap->top->polygonIndex : -1;
-    int bottomPolyIndex = (trap->bottom && trap->bottom->polygonIndex != -1) 
-                          ? trap->bottom->polygonIndex : -1;
-    if (topPolyIndex != -1 && bottomPolyIndex != -1 && topPolyIndex == bottomPolyIndex) {
-        return true;
+    return trap->top->polygonIndex != -1 && trap->top->polygonBelow
+        && trap->bottom->polygonIndex != -1 && !trap->bottom->polygonBelow;
+}
+
+void FreeSpaceComputer::removeInteriorTrapezoids(TrapezoidalMap& map) {
+    // One linear pass; removing them one at a time would shift the list each time
+    map.removeTrapezoidsIf(isTrapezoidInsideObstacle);
+}
+
+// Even-odd rule; p must not lie on the boundary
+static bool pointInPolygon(const Polygon& polygon, const Point& p) {
+    bool inside = false;
+    size_t n = polygon.vertices.size();
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        const Point& a = polygon.vertices[i];
+        const Point& b = polygon.vertices[j];
+        if ((a.y > p.y) != (b.y > p.y) &&
+            p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// Trapezoids at the leaves below n: what now covers the area n's trapezoid
+// used to cover
+static void collectLeaves(const Node* n, vector<Trapezoid*>& leaves) {
+    if (n->type == LEAF_NODE) {
+        leaves.push_back(n->trapezoid);
+    } else if (n->type == X_NODE) {
+        collectLeaves(n->left, leaves);
+        collectLeaves(n->right, leaves);
+    } else {
+        collectLeaves(n->above, leaves);
+        collectLeaves(n->below, leaves);
     }
-    return false;
 }
 
-void FreeSpaceComputer::removeInteriorTrapezoids(TrapezoidalMap& map, const vector<Polygon>& polygons) {
-    vector<Trapezoid*> toRemove;
-    int trapIndex = 0;
-    for (Trapezoid* trap : map.trapezoids) {
-        if (isTrapezoidInsideObstacle(trap)) {
-            toRemove.push_back(trap);
+// Whatever the update replaced is now covered by the leaves below the DAG
+// nodes of the removed trapezoids. Those lying inside an obstacle are
+// dropped as in removeInteriorTrapezoids, the rest go to update.added.
+static void collectAdded(TrapezoidalMap& map, MapUpdate& update) {
+    vector<Trapezoid*> leaves;
+    for (Trapezoid* trap : update.removed) {
+        collectLeaves(trap->node, leaves);
+    }
+    sort(leaves.begin(), leaves.end());
+    leaves.erase(unique(leaves.begin(), leaves.end()), leaves.end());
+    for (Trapezoid* trap : leaves) {
+        if (!map.contains(trap)) continue;
+        if (FreeSpaceComputer::isTrapezoidInsideObstacle(trap)) {
+            map.removeTrapezoid(trap);
+        } else {
+            update.added.push_back(trap);
         }
     }
-    for (Trapezoid* trap : toRemove) {
-        map.removeTrapezoid(trap);
+}
+
+bool FreeSpaceComputer::insertObstacle(TrapezoidalMap& map, const Polygon& polygon,
+                                       int polygonIndex, MapUpdate& update) {
+    update.removed.clear();
+    update.added.clear();
+    
+    size_t k = polygon.vertices.size();
+    if (k < 3) {
+        TRACE_WARN("Polygon with less than 3 vertices skipped");
+        return false;
+    }
+    if (!map.root || map.segments.size() < 2) {
+        TRACE_WARN("Cannot insert an obstacle into an empty map");
+        return false;
     }
+    
+    // The first two segments of a map are the top and bottom of its bounding box
+    const Segment* topBound = map.segments[0];
+    const Segment* bottomBound = map.segments[1];
+    for (const Point& v : polygon.vertices) {
+        if (!(v.x > topBound->p1.x && v.x < topBound->p2.x &&
+              v.y > bottomBound->p1.y && v.y < topBound->p1.y)) {
+            TRACE_WARN("Obstacle leaves the bounding box of the map");
+            return false;
+        }
+    }
+    
+    // The boundary has to run through free space only...
+    vector<Point> boundary(polygon.vertices);
+    boundary.push_back(polygon.vertices[0]);
+    if (!PathComputer::isValidPath(map, boundary)) {
+        TRACE_WARN("Obstacle overlaps an existing one");
+        return false;
+    }
+    
+    // ...and must not enclose another obstacle. The topmost obstacle inside
+    // it bounds one of the trapezoids the boundary passes through from
+    // below, so testing the obstacle edges of those trapezoids is enough.
+    vector<Segment> edges = extractEdges(vector<Polygon>(1, polygon));
+    vector<Trapezoid*> intersected;
+    for (const Segment& edge : edges) {
+        intersected.clear();
+        findIntersectedTrapezoids(map.root, edge, intersected);
+        for (Trapezoid* trap : intersected) {
+            double x = 0.5 * (trap->leftp.x + trap->rightp.x);
+            for (const Segment* side : {trap->top, trap->bottom}) {
+                if (side->polygonIndex != -1 && pointInPolygon(polygon, Point(x, side->yAt(x)))) {
+                    TRACE_WARN("Obstacle encloses an existing one");
+                    return false;
+                }
+            }
+        }
+    }
+    
+    // Same steps as one round of the randomized build
+    for (Segment& edge : edges) {
+        edge.polygonIndex = polygonIndex;
+        Segment* seg = map.newSegment(edge);
+        intersected.clear();
+        findIntersectedTrapezoids(map.root, *seg, intersected);
+        if (intersected.empty()) {
+            TRACE_WARN("Segment doesn't intersect any trapezoids");
+            continue;
+        }
+        if (intersected.size() == 1) {
+            insertInSingleTrapezoid(map, intersected[0], seg);
+        } else {
+            insertAcrossMultipleTrapezoids(map, intersected, seg);
+        }
+        update.removed.insert(update.removed.end(), intersected.begin(), intersected.end());
+    }
+    
+    collectAdded(map, update);
+    
+    TRACE_DEBUG("Inserted obstacle " << polygonIndex << " with " << k << " edges: "
+                << update.removed.size() << " trapezoids split, "
+                << update.added.size() << " free ones added");
+    return true;
+}
+
+bool FreeSpaceComputer::removeObstacle(TrapezoidalMap& map, const Polygon& polygon,
+                                       MapUpdate& update) {
+    update.removed.clear();
+    update.added.clear();
+    if (!map.root) return false;
+    
+    // Find every edge before touching anything
+    vector<Segment> edges = extractEdges(vector<Polygon>(1, polygon));
+    vector<Segment*> segments;
+    for (const Segment& edge : edges) {
+        Segment* seg = findSegment(map.root, edge);
+        if (!seg || seg->polygonIndex == -1 ||
+            (!segments.empty() && seg->polygonIndex != segments[0]->polygonIndex)) {
+            TRACE_WARN("Obstacle to remove is not in the map");
+            return false;
+        }
+        segments.push_back(seg);
+    }
+    
+    for (Segment* seg : segments) {
+        if (!deleteSegment(map, seg, update.removed)) {
+            TRACE_ERROR("Removing obstacle " << seg->polygonIndex
+                        << " failed half way; the map has to be rebuilt");
+            return false;
+        }
+    }
+    collectAdded(map, update);
+    
+    TRACE_DEBUG("Removed obstacle " << segments[0]->polygonIndex << " with "
+                << segments.size() << " edges: " << update.removed.size()
+                << " trapezoids merged into " << update.added.size());
+    return true;
 }
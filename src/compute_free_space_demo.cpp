@@ -9,6 +9,9 @@
 #include "trapezoidal_map.hpp"
 #include "compute_free_space.hpp"
 #include "sdl_layer.hpp"
+#include "trace.hpp"
+
+static const char TRACE_MODULE[] = "compute_free_space_demo";
 
 
 void compute_free_space_demo() {
@@ -38,13 +41,13 @@ void compute_free_space_demo() {
     triangle3.addVertex(92, 25);
     polygons.push_back(triangle3);
 
-    std::cout << "Computing free space..." << std::endl;
+    TRACE_INFO("Computing free space...");
     TrapezoidalMap freeSpaceMap = FreeSpaceComputer::COMPUTEFREESPACE(polygons);
-    std::cout << "Free space computed. Found " << freeSpaceMap.trapezoids.size() << " free trapezoids." << std::endl;
+    TRACE_INFO("Free space computed. Found " << freeSpaceMap.trapezoids.size() << " free trapezoids.");
 
     std::vector<Segment> allEdges = FreeSpaceComputer::extractEdges(polygons);
     TrapezoidalMap originalMap = BuildTrapezoidalMap(allEdges);
-    std::cout << "Original map has " << originalMap.trapezoids.size() << " trapezoids." << std::endl;
+    TRACE_INFO("Original map has " << originalMap.trapezoids.size() << " trapezoids.");
 
     bool running = true;
     SDL_Event event;
@@ -60,7 +63,7 @@ void compute_free_space_demo() {
             if (event.type == SDL_KEYDOWN) {
                 if (event.key.keysym.sym == SDLK_SPACE) {
                     showOriginalMap = !showOriginalMap;
-                    std::cout << (showOriginalMap ? "Showing original map" : "Showing free space") << std::endl;
+                    TRACE_INFO((showOriginalMap ? "Showing original map" : "Showing free space"));
                 }
             }
             if (event.type == SDL_MOUSEBUTTONDOWN) {
@@ -70,14 +73,14 @@ void compute_free_space_demo() {
                     SDL_Point mousePos = {mouseX, mouseY};
                     Point worldPos = screenToWorld(mousePos);
                     
-                    std::cout << "Querying map at (" << worldPos.x << ", " << worldPos.y << ")" << std::endl;
+                    TRACE_INFO("Querying map at (" << worldPos.x << ", " << worldPos.y << ")");
 
                     TrapezoidalMap& currentMap = showOriginalMap ? originalMap : freeSpaceMap;
                     Node* leaf = queryTrapezoidMap(currentMap.root, worldPos);
                     if (leaf && leaf->type == LEAF_NODE) {
                         highlightedTrap = leaf->trapezoid;
                         highlightedNode = leaf;
-                        std::cout << "Found trapezoid at leaf node." << std::endl;
+                        TRACE_INFO("Found trapezoid at leaf node.");
                     } else {
                         highlightedTrap = NULL;
                         highlightedNode = NULL;
@@ -136,9 +139,10 @@ void compute_free_space_demo() {
         }
         
         SDL_RenderPresent(renderer);
+        trace::flush();
     }
 
-    std::cout << "Cleaning up..." << std::endl;
+    TRACE_INFO("Cleaning up...");
     if (font) TTF_CloseFont(font);
     originalMap.cleanup();
     freeSpaceMap.cleanup();
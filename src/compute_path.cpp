@@ -1,210 +1,994 @@
 #include "compute_path.hpp"
+#include "landmarks.hpp"
+#include "trace.hpp"
 #include <iostream>
-#include <queue>
-#include <unordered_set>
 #include <set>
 #include <cmath>
 #include <algorithm>
-#include <map>
 
 using namespace std;
 
+static const char TRACE_MODULE[] = "compute_path";
 
 Point PathComputer::getTrapezoidCenter(Trapezoid* trap) {
     if (!trap) return Point(0, 0);
     
     double centerX = (trap->leftp.x + trap->rightp.x) / 2.0;
     
-    double topY = trap->top->yAt(centerX);
-    double bottomY = trap->bottom->yAt(centerX);
+    double topY = trap->topAt(centerX);
+    double bottomY = trap->bottomAt(centerX);
     double centerY = (topY + bottomY) / 2.0;
     
     return Point(centerX, centerY);
 }
 
-Trapezoid* PathComputer::findTrapezoidContainingPoint(TrapezoidalMap& map, const Point& p) {
+Trapezoid* PathComputer::findTrapezoidContainingPoint(const TrapezoidalMap& map, const Point& p) {
     Node* leaf = queryTrapezoidMap(map.root, p);
-    return leaf->trapezoid;
+    return leaf ? leaf->trapezoid : NULL;
 }
 
-vector<Point> PathComputer::COMPUTEPATH(TrapezoidalMap& freeSpaceMap, 
-                                       RoadMap& roadMap,
-                                       const Point& pstart, 
-                                       const Point& pgoal) {
-    Trapezoid* delta_start = findTrapezoidContainingPoint(freeSpaceMap, pstart);
-    Trapezoid* delta_goal = findTrapezoidContainingPoint(freeSpaceMap, pgoal);
+void SearchScratch::begin(size_t nodeCount) {
+    if (stamp.size() != nodeCount) {
+        stamp.assign(nodeCount, 0);
+        parent.resize(nodeCount);
+        cost.resize(nodeCount);
+        generation = 0;
+    }
+    // After a wrap, stamps left from 2^32 searches ago would look current
+    if (++generation == 0) {
+        fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+    open.resize(nodeCount);
+    open.clear();
+    frontier.clear();
+    expanded = 0;
+}
+
+// The search cores leave their result as parent links in the scratch; the
+// callers decide where the points go
+static bool breadthFirstCore(const RoadMapView& roadMap, uint32_t start, uint32_t goal,
+                             SearchScratch& scratch) {
+    size_t n = roadMap.nodeCount;
+    scratch.begin(n);
+    if (start >= n || goal >= n) return false;
+    
+    if (roadMap.component[start] != roadMap.component[goal]) return false;
+    
+    scratch.reach(start, start);
+    if (start == goal) return true;
     
-    if (!delta_start || !delta_goal) {
-        string message = !delta_start ? "Start position is in forbidden space" : 
-                         "Goal position is in forbidden space";
-        cout << "ERROR: " << message << endl;
-        return {};
+    // FIFO read from head; the stamps double as the visited set
+    vector<uint32_t>& q = scratch.frontier;
+    const uint32_t* rowBegin = roadMap.rowBegin;
+    const uint32_t* rowEnd = roadMap.rowEnd;
+    const uint32_t* neighbors = roadMap.neighbors;
+    
+    q.push_back(start);
+    for (size_t head = 0; head < q.size(); head++) {
+        uint32_t current = q[head];
+        scratch.expanded++;
+        for (uint32_t e = rowBegin[current]; e < rowEnd[current]; e++) {
+            uint32_t neighbor = neighbors[e];
+            if (scratch.reached(neighbor)) continue;
+            scratch.reach(neighbor, current);
+            if (neighbor == goal) return true;
+            q.push_back(neighbor);
+        }
     }
+    return false;
+}
+
+// Straight-line distance never overestimates a roadmap path and obeys the
+// triangle inequality, so a node's cost is final once it is popped
+struct EuclideanHeuristic {
+    const Point* positions;
+    Point target;
+    
+    double operator()(uint32_t v) const {
+        double dx = positions[v].x - target.x;
+        double dy = positions[v].y - target.y;
+        return sqrt(dx * dx + dy * dy);
+    }
+};
+
+// d(v, goal) >= |d(L, goal) - d(L, v)| for every landmark L. Each bound is
+// consistent on its own, and so is the maximum over them and the straight line.
+struct LandmarkHeuristic {
+    EuclideanHeuristic euclidean;
+    const double* distances;
+    const double* goalRow;
+    size_t count;
+    
+    double operator()(uint32_t v) const {
+        double best = euclidean(v);
+        const double* row = distances + static_cast<size_t>(v) * count;
+        for (size_t k = 0; k < count; k++) {
+            if (row[k] == INFINITY || goalRow[k] == INFINITY) continue;
+            double bound = fabs(goalRow[k] - row[k]);
+            if (bound > best) best = bound;
+        }
+        return best;
+    }
+};
+
+template <typename Heuristic>
+static bool aStarCore(const RoadMapView& roadMap, uint32_t start, uint32_t goal,
+                      SearchScratch& scratch, const Heuristic& heuristic) {
+    scratch.reach(start, start);
+    if (start == goal) return true;
+    
+    vector<double>& cost = scratch.cost;
+    IndexedHeap& open = scratch.open;
     
-    cout << "Found start trapezoid and goal trapezoid" << endl;
+    const uint32_t* rowBegin = roadMap.rowBegin;
+    const uint32_t* rowEnd = roadMap.rowEnd;
+    const uint32_t* neighbors = roadMap.neighbors;
+    const double* lengths = roadMap.lengths;
     
-    RoadMapNode* nu_start = roadMap.getNodeForTrapezoid(delta_start);
-    RoadMapNode* nu_goal = roadMap.getNodeForTrapezoid(delta_goal);
+    cost[start] = 0;
+    open.push(start, heuristic(start));
     
-    if (!nu_start || !nu_goal) {
-        cout << "ERROR: Could not find roadmap nodes for trapezoids" << endl;
-        return {};
+    while (!open.empty()) {
+        uint32_t current = open.pop();
+        scratch.expanded++;
+        if (current == goal) return true;
+        
+        for (uint32_t e = rowBegin[current]; e < rowEnd[current]; e++) {
+            uint32_t neighbor = neighbors[e];
+            double g = cost[current] + lengths[e];
+            if (!scratch.reached(neighbor)) {
+                scratch.reach(neighbor, current);
+                cost[neighbor] = g;
+                open.push(neighbor, g + heuristic(neighbor));
+            } else if (!open.closed(neighbor) && g < cost[neighbor]) {
+                scratch.parent[neighbor] = current;
+                cost[neighbor] = g;
+                open.decreaseKey(neighbor, g + heuristic(neighbor));
+            }
+        }
     }
+    return false;
+}
+
+// A* with the straight-line heuristic, or ALT when landmarks is given
+static bool shortestPathCore(const RoadMapView& roadMap, uint32_t start, uint32_t goal,
+                             SearchScratch& scratch, const LandmarkTable* landmarks) {
+    size_t n = roadMap.nodeCount;
+    scratch.begin(n);
+    if (start >= n || goal >= n) return false;
     
-    cout << "Found roadmap nodes: start at (" << nu_start->position.x << ", " 
-         << nu_start->position.y << "), goal at (" << nu_goal->position.x << ", " 
-         << nu_goal->position.y << ")" << endl;
+    if (roadMap.component[start] != roadMap.component[goal]) return false;
     
-    vector<Point> roadmapPath = breadthFirstSearch(nu_start, nu_goal);
+    EuclideanHeuristic euclidean = {roadMap.positions, roadMap.positions[goal]};
+    if (!landmarks || landmarks->count() == 0) {
+        return aStarCore(roadMap, start, goal, scratch, euclidean);
+    }
     
-    if (roadmapPath.empty()) {
-        cout << "No path found in roadmap" << endl;
-        return {};
+    LandmarkHeuristic alt = {euclidean, landmarks->distances.data(),
+                             landmarks->row(goal), landmarks->count()};
+    return aStarCore(roadMap, start, goal, scratch, alt);
+}
+
+// Append the roadmap points from start to goal, skipping repeats of the
+// previous point. Writes into the caller's buffer so nothing is allocated
+// once it has grown large enough.
+static void appendRoadmapPath(const RoadMapView& roadMap, const SearchScratch& scratch,
+                              uint32_t start, uint32_t goal, vector<Point>& path) {
+    size_t first = path.size();
+    for (uint32_t node = goal; ; node = scratch.parent[node]) {
+        path.push_back(roadMap.positions[node]);
+        if (node == start) break;
     }
+    reverse(path.begin() + first, path.end());
     
-    vector<Point> finalPath;
+    auto from = path.begin() + (first > 0 ? first - 1 : first);
+    path.erase(unique(from, path.end(),
+                      [](const Point& a, const Point& b) { return a.equals(b); }),
+               path.end());
+}
+
+// Roadmap search between two located center nodes. On PATH_FOUND the parent
+// links in scratch lead from nu_goal back to nu_start.
+static PathStatus searchNodes(const RoadMapView& roadMap,
+                              uint32_t nu_start,
+                              uint32_t nu_goal,
+                              SearchScratch& scratch,
+                              SearchAlgorithm algorithm,
+                              const LandmarkTable* landmarks) {
+    scratch.expanded = 0;
     
-    finalPath.push_back(pstart);
+    if (nu_start == ROADMAP_NONE || nu_goal == ROADMAP_NONE) return PATH_NO_ROADMAP_NODE;
+    if (nu_start >= roadMap.nodeCount || nu_goal >= roadMap.nodeCount) return PATH_NO_ROADMAP_NODE;
+    if (roadMap.component[nu_start] != roadMap.component[nu_goal]) return PATH_DISCONNECTED;
     
-    for (size_t i = 0; i < roadmapPath.size(); i++) {
-        if (finalPath.empty() || !finalPath.back().equals(roadmapPath[i])) {
-            finalPath.push_back(roadmapPath[i]);
+    bool found;
+    if (algorithm == SEARCH_BFS) {
+        found = breadthFirstCore(roadMap, nu_start, nu_goal, scratch);
+    } else {
+        // Only the cheap size check here; matches() hashes the whole roadmap
+        if (algorithm != SEARCH_ALT || (landmarks && landmarks->nodeCount != roadMap.nodeCount)) {
+            landmarks = NULL;
         }
+        found = shortestPathCore(roadMap, nu_start, nu_goal, scratch, landmarks);
     }
     
-    if (finalPath.empty() || !finalPath.back().equals(pgoal)) {
-        finalPath.push_back(pgoal);
-    }
+    return found ? PATH_FOUND : PATH_NOT_FOUND;
+}
+
+// Locate start and goal and find their roadmap nodes. Returns PATH_FOUND
+// when both lie in free space, the blocked status otherwise.
+static PathStatus locateEndpoints(const TrapezoidalMap& freeSpaceMap,
+                                  const RoadMap& roadMap,
+                                  const Point& pstart,
+                                  const Point& pgoal,
+                                  uint32_t& nu_start,
+                                  uint32_t& nu_goal) {
+    Trapezoid* delta_start = PathComputer::findTrapezoidContainingPoint(freeSpaceMap, pstart);
+    Trapezoid* delta_goal = PathComputer::findTrapezoidContainingPoint(freeSpaceMap, pgoal);
     
-    cout << "Path found with " << finalPath.size() << " points" << endl;
-    return finalPath;
+    // Interior trapezoids stay in the DAG but are no longer listed in the map
+    if (!freeSpaceMap.contains(delta_start)) return PATH_START_BLOCKED;
+    if (!freeSpaceMap.contains(delta_goal)) return PATH_GOAL_BLOCKED;
+    
+    nu_start = roadMap.getNodeForTrapezoid(delta_start);
+    nu_goal = roadMap.getNodeForTrapezoid(delta_goal);
+    return PATH_FOUND;
 }
 
-RoadMap PathComputer::buildRoadMap(TrapezoidalMap& freeSpaceMap) {
-    RoadMap roadMap;
+// Point location plus roadmap search shared by the query functions
+static PathStatus searchRoadMap(const TrapezoidalMap& freeSpaceMap,
+                                const RoadMap& roadMap,
+                                const Point& pstart,
+                                const Point& pgoal,
+                                SearchScratch& scratch,
+                                SearchAlgorithm algorithm,
+                                const LandmarkTable* landmarks,
+                                uint32_t& nu_start,
+                                uint32_t& nu_goal) {
+    scratch.expanded = 0;
+    
+    PathStatus status = locateEndpoints(freeSpaceMap, roadMap, pstart, pgoal, nu_start, nu_goal);
+    if (status != PATH_FOUND) return status;
+    
+    return searchNodes(roadMap.view(), nu_start, nu_goal, scratch, algorithm, landmarks);
+}
 
-    unordered_map<Trapezoid*, RoadMapNode*> trapCenter;
-    map<tuple<double, double, double>, RoadMapNode*> verticalEdgeNodes; 
+PathStatus PathComputer::queryPath(const TrapezoidalMap& freeSpaceMap,
+                                   const RoadMap& roadMap,
+                                   const Point& pstart,
+                                   const Point& pgoal,
+                                   SearchScratch& scratch,
+                                   vector<Point>& path,
+                                   SearchAlgorithm algorithm,
+                                   const LandmarkTable* landmarks) {
+    path.clear();
+    scratch.expanded = 0;
+    
+    uint32_t nu_start, nu_goal;
+    PathStatus status = locateEndpoints(freeSpaceMap, roadMap, pstart, pgoal, nu_start, nu_goal);
+    if (status != PATH_FOUND) return status;
+    
+    return queryRoadMapPath(roadMap.view(), nu_start, nu_goal, pstart, pgoal,
+                            scratch, path, algorithm, landmarks);
+}
 
-    // 1. Create center nodes for each trapezoid
-    for (Trapezoid* trap : freeSpaceMap.trapezoids) {
-        Point c = getTrapezoidCenter(trap);
-        auto* node = new RoadMapNode(c, trap);
-        roadMap.addNode(node);
-        trapCenter[trap] = node;
+PathStatus PathComputer::queryRoadMapPath(const RoadMapView& roadMap,
+                                          uint32_t nu_start,
+                                          uint32_t nu_goal,
+                                          const Point& pstart,
+                                          const Point& pgoal,
+                                          SearchScratch& scratch,
+                                          vector<Point>& path,
+                                          SearchAlgorithm algorithm,
+                                          const LandmarkTable* landmarks) {
+    path.clear();
+    
+    PathStatus status = searchNodes(roadMap, nu_start, nu_goal, scratch, algorithm, landmarks);
+    if (status != PATH_FOUND) return status;
+    
+    path.push_back(pstart);
+    appendRoadmapPath(roadMap, scratch, nu_start, nu_goal, path);
+    
+    if (!path.back().equals(pgoal)) {
+        path.push_back(pgoal);
     }
+    
+    return PATH_FOUND;
+}
 
-    // 2. Create vertical edge nodes
-    for (Trapezoid* trap : freeSpaceMap.trapezoids) {
-        for (bool rightSide : {false, true}) {
-            double x = rightSide ? trap->rightp.x : trap->leftp.x;
-            if (isinf(x)) continue;
-            Trapezoid* upper = rightSide ? trap->upperRight : trap->upperLeft;
-            Trapezoid* lower = rightSide ? trap->lowerRight : trap->lowerLeft;
-            double topY = trap->top->yAt(x);
-            double bottomY = trap->bottom->yAt(x);
-
-            // upper part
-            if (upper) {
-                double uy1 = max(bottomY, upper->bottom->yAt(x));
-                double uy2 = min(topY, upper->top->yAt(x));
-                if (uy1 < uy2) {
-                    auto key = make_tuple(x, uy1, uy2);
-                    if (!verticalEdgeNodes[key]) {
-                        Point mid(x, 0.5 * (uy1 + uy2));
-                        auto* vNode = new RoadMapNode(mid, nullptr);
-                        verticalEdgeNodes[key] = vNode;
-                        roadMap.addNode(vNode);
-                    }
-                }
+PathStatus PathComputer::queryTautPath(const TrapezoidalMap& freeSpaceMap,
+                                       const RoadMap& roadMap,
+                                       const Point& pstart,
+                                       const Point& pgoal,
+                                       SearchScratch& scratch,
+                                       vector<Point>& path,
+                                       SearchAlgorithm algorithm,
+                                       const LandmarkTable* landmarks) {
+    path.clear();
+    
+    uint32_t nu_start, nu_goal;
+    PathStatus status = searchRoadMap(freeSpaceMap, roadMap, pstart, pgoal, scratch,
+                                      algorithm, landmarks, nu_start, nu_goal);
+    if (status != PATH_FOUND) return status;
+    
+    // Only center nodes name a trapezoid; the crossing nodes in between only
+    // say which wall was used, and adjacent trapezoids share exactly one
+    // piece of wall
+    vector<Trapezoid*>& corridor = scratch.corridor;
+    corridor.clear();
+    for (uint32_t node = nu_goal; ; node = scratch.parent[node]) {
+        Trapezoid* trap = roadMap.nodeTrapezoid[node];
+        if (trap) corridor.push_back(trap);
+        if (node == nu_start) break;
+    }
+    reverse(corridor.begin(), corridor.end());
+    
+    pullTaut(corridor, pstart, pgoal, scratch.funnel, path);
+    return PATH_FOUND;
+}
+
+// Twice the signed area of abc; positive when c is left of a->b
+static inline double triArea2(const Point& a, const Point& b, const Point& c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// The piece of wall between adjacent trapezoids a and b, with its ends
+// named as seen by someone walking from a into b
+static void portalBetween(const Trapezoid* a, const Trapezoid* b, Point& left, Point& right) {
+    bool rightward = (a->upperRight == b || a->lowerRight == b);
+    double x = rightward ? a->rightp.x : a->leftp.x;
+    double y1 = max(a->bottomAt(x), b->bottomAt(x));
+    double y2 = min(a->topAt(x), b->topAt(x));
+    left = Point(x, rightward ? y2 : y1);
+    right = Point(x, rightward ? y1 : y2);
+}
+
+void PathComputer::pullTaut(const vector<Trapezoid*>& corridor,
+                            const Point& pstart,
+                            const Point& pgoal,
+                            vector<Point>& funnel,
+                            vector<Point>& path) {
+    path.clear();
+    path.push_back(pstart);
+    if (corridor.empty()) {
+        path.push_back(pgoal);
+        return;
+    }
+    
+    // The funnel is a deque around the apex: the left chain runs from
+    // funnel[apex] down to its tip at funnel[head], the right chain up to
+    // funnel[tail]. Every portal end is pushed and popped at most once and
+    // each side grows by at most one per portal, which bounds the buffer.
+    size_t sideCapacity = corridor.size() + 1;
+    funnel.resize(2 * sideCapacity + 1);
+    size_t apex = sideCapacity, head = apex, tail = apex;
+    funnel[apex] = pstart;
+    
+    auto addLeft = [&](const Point& p) {
+        // Left vertices that p can be seen past are no longer corners
+        while (head < apex && triArea2(funnel[head + 1], funnel[head], p) <= 0) head++;
+        if (head == apex) {
+            // p crosses the right chain: its corners up to p's tangent are final
+            while (apex < tail && triArea2(funnel[apex], funnel[apex + 1], p) < 0) {
+                path.push_back(funnel[++apex]);
+            }
+            head = apex;
+        }
+        funnel[--head] = p;
+    };
+    auto addRight = [&](const Point& p) {
+        while (tail > apex && triArea2(funnel[tail - 1], funnel[tail], p) >= 0) tail--;
+        if (tail == apex) {
+            while (apex > head && triArea2(funnel[apex], funnel[apex - 1], p) > 0) {
+                path.push_back(funnel[--apex]);
             }
+            tail = apex;
+        }
+        funnel[++tail] = p;
+    };
+    
+    Point left, right;
+    for (size_t i = 0; i + 1 < corridor.size(); i++) {
+        portalBetween(corridor[i], corridor[i + 1], left, right);
+        addLeft(left);
+        addRight(right);
+    }
+    addLeft(pgoal);
+    addRight(pgoal);
+    
+    // The right chain now ends at the goal
+    for (size_t i = apex + 1; i <= tail; i++) {
+        path.push_back(funnel[i]);
+    }
+}
 
-            // lower part
-            if (lower) {
-                double ly1 = max(lower->bottom->yAt(x), bottomY);
-                double ly2 = min(lower->top->yAt(x), topY);
-                if (ly1 < ly2) {
-                    auto key = make_tuple(x, ly1, ly2);
-                    if (!verticalEdgeNodes[key]) {
-                        Point mid(x, 0.5 * (ly1 + ly2));
-                        auto* vNode = new RoadMapNode(mid, nullptr);
-                        verticalEdgeNodes[key] = vNode;
-                        roadMap.addNode(vNode);
-                    }
+static void reportPathStatus(PathStatus status, [[maybe_unused]] const vector<Point>& finalPath) {
+    switch (status) {
+    case PATH_START_BLOCKED:
+        TRACE_ERROR("Start position is in forbidden space");
+        break;
+    case PATH_GOAL_BLOCKED:
+        TRACE_ERROR("Goal position is in forbidden space");
+        break;
+    case PATH_NO_ROADMAP_NODE:
+        TRACE_ERROR("Could not find roadmap nodes for trapezoids");
+        break;
+    case PATH_DISCONNECTED:
+        TRACE_INFO("Start and goal are in different regions of free space");
+        break;
+    case PATH_NOT_FOUND:
+        TRACE_INFO("No path found in roadmap");
+        break;
+    case PATH_FOUND:
+        TRACE_INFO("Path found with " << finalPath.size() << " points");
+        break;
+    }
+}
+
+vector<Point> PathComputer::COMPUTEPATH(TrapezoidalMap& freeSpaceMap, 
+                                       RoadMap& roadMap,
+                                       const Point& pstart, 
+                                       const Point& pgoal) {
+    SearchScratch scratch;
+    vector<Point> finalPath;
+    PathStatus status = queryPath(freeSpaceMap, roadMap, pstart, pgoal, scratch, finalPath);
+    reportPathStatus(status, finalPath);
+    return finalPath;
+}
+
+vector<Point> PathComputer::COMPUTESHORTESTPATH(TrapezoidalMap& freeSpaceMap, 
+                                               RoadMap& roadMap,
+                                               const Point& pstart, 
+                                               const Point& pgoal) {
+    SearchScratch scratch;
+    vector<Point> finalPath;
+    PathStatus status = queryPath(freeSpaceMap, roadMap, pstart, pgoal, scratch, finalPath,
+                                  SEARCH_ASTAR);
+    reportPathStatus(status, finalPath);
+    return finalPath;
+}
+
+vector<Point> PathComputer::COMPUTETAUTPATH(TrapezoidalMap& freeSpaceMap, 
+                                           RoadMap& roadMap,
+                                           const Point& pstart, 
+                                           const Point& pgoal) {
+    SearchScratch scratch;
+    vector<Point> finalPath;
+    PathStatus status = queryTautPath(freeSpaceMap, roadMap, pstart, pgoal, scratch, finalPath);
+    reportPathStatus(status, finalPath);
+    return finalPath;
+}
+
+// Flood fill over the adjacency arrays, O(V + E). Labels follow the order of the
+// lowest node in each component.
+static void labelComponents(RoadMap& roadMap) {
+    size_t n = roadMap.nodeCount();
+    roadMap.component.assign(n, ROADMAP_NONE);
+    roadMap.componentCount = 0;
+    
+    vector<uint32_t> stack;
+    for (uint32_t root = 0; root < n; root++) {
+        if (roadMap.component[root] != ROADMAP_NONE) continue;
+        uint32_t label = roadMap.componentCount++;
+        roadMap.component[root] = label;
+        stack.push_back(root);
+        while (!stack.empty()) {
+            uint32_t v = stack.back();
+            stack.pop_back();
+            for (uint32_t e = roadMap.rowBegin[v]; e < roadMap.rowEnd[v]; e++) {
+                uint32_t w = roadMap.neighbors[e];
+                if (roadMap.component[w] == ROADMAP_NONE) {
+                    roadMap.component[w] = label;
+                    stack.push_back(w);
                 }
             }
         }
     }
+}
+
+// Middle of the piece of vertical wall between left and its right
+// neighbour right; false if they only touch at a point
+static bool wallCrossing(const Trapezoid* left, const Trapezoid* right, Point& crossing) {
+    double x = left->rightp.x;
+    if (isinf(x)) return false;
+    double y1 = max(left->bottomAt(x), right->bottomAt(x));
+    double y2 = min(left->topAt(x), right->topAt(x));
+    if (!(y1 < y2)) return false;
+    crossing = Point(x, 0.5 * (y1 + y2));
+    return true;
+}
+
+RoadMap PathComputer::buildRoadMap(TrapezoidalMap& freeSpaceMap) {
+    RoadMap roadMap;
+    size_t trapCount = freeSpaceMap.trapezoids.size();
+
+    // 1. Create center nodes for each trapezoid, in list order, so a
+    // trapezoid's slot is also the index of its center node
+    roadMap.positions.reserve(trapCount * 3);
+    roadMap.nodeTrapezoid.reserve(trapCount * 3);
+    for (size_t i = 0; i < trapCount; i++) {
+        Trapezoid* trap = freeSpaceMap.trapezoids[i];
+        roadMap.positions.push_back(getTrapezoidCenter(trap));
+        roadMap.nodeTrapezoid.push_back(trap);
+        trap->roadNode = static_cast<int>(i);
+    }
 
-    // 3. Connect trapezoid centers to corresponding vertical boundary nodes
+    // 2. Two trapezoids that share a piece of vertical wall are always
+    // left/right neighbours, so walking every trapezoid's right neighbours
+    // visits each wall crossing exactly once. Put a node in the middle of
+    // the shared piece; it links the two centers.
+    vector<pair<uint32_t, uint32_t>> crossingEnds;
+    vector<uint32_t> degree(trapCount, 0);
     for (Trapezoid* trap : freeSpaceMap.trapezoids) {
-        RoadMapNode* center = trapCenter[trap];
-        for (bool rightSide : {false, true}) {
-            double x = rightSide ? trap->rightp.x : trap->leftp.x;
-            if (isinf(x)) continue;
-            double y1 = trap->bottom->yAt(x);
-            double y2 = trap->top->yAt(x);
-
-            for (auto& [key, node] : verticalEdgeNodes) {
-                auto [vx, vy1, vy2] = key;
-                if (fabs(vx - x) < 1e-9 &&
-                    vy1 >= y1 - 1e-9 && vy2 <= y2 + 1e-9) {
-                    center->neighbors.push_back(node);
-                    node->neighbors.push_back(center);
-                }
-            }
+        // A single right neighbour is stored in both slots
+        Trapezoid* lower = (trap->lowerRight != trap->upperRight) ? trap->lowerRight : NULL;
+        for (Trapezoid* next : {trap->upperRight, lower}) {
+            Point crossing;
+            if (!freeSpaceMap.contains(next) || !wallCrossing(trap, next, crossing)) continue;
+
+            roadMap.positions.push_back(crossing);
+            roadMap.nodeTrapezoid.push_back(NULL);
+            crossingEnds.push_back(make_pair(static_cast<uint32_t>(trap->slot),
+                                             static_cast<uint32_t>(next->slot)));
+            degree[trap->slot]++;
+            degree[next->slot]++;
         }
     }
 
-    cout << "Built roadmap with " << roadMap.nodes.size() << " nodes and "
-         << countTotalEdges(roadMap) << " edges" << endl;
+    // 3. Lay the adjacency out row by row. Crossing c is node trapCount + c
+    // and always has exactly the two centers as neighbours.
+    size_t nodeCount = roadMap.positions.size();
+    roadMap.rowBegin.resize(nodeCount);
+    roadMap.rowEnd.resize(nodeCount);
+    uint32_t next = 0;
+    for (size_t i = 0; i < trapCount; i++) {
+        roadMap.rowBegin[i] = roadMap.rowEnd[i] = next;
+        next += degree[i];
+    }
+    for (size_t c = 0; c < crossingEnds.size(); c++) {
+        roadMap.rowBegin[trapCount + c] = roadMap.rowEnd[trapCount + c] = next;
+        next += 2;
+    }
+    roadMap.neighbors.resize(next);
+
+    for (size_t c = 0; c < crossingEnds.size(); c++) {
+        uint32_t crossing = static_cast<uint32_t>(trapCount + c);
+        uint32_t a = crossingEnds[c].first;
+        uint32_t b = crossingEnds[c].second;
+        roadMap.neighbors[roadMap.rowEnd[a]++] = crossing;
+        roadMap.neighbors[roadMap.rowEnd[b]++] = crossing;
+        roadMap.neighbors[roadMap.rowEnd[crossing]++] = a;
+        roadMap.neighbors[roadMap.rowEnd[crossing]++] = b;
+    }
+
+    roadMap.lengths.resize(roadMap.neighbors.size());
+    for (size_t i = 0; i < nodeCount; i++) {
+        const Point& p = roadMap.positions[i];
+        for (uint32_t e = roadMap.rowBegin[i]; e < roadMap.rowEnd[i]; e++) {
+            const Point& q = roadMap.positions[roadMap.neighbors[e]];
+            roadMap.lengths[e] = hypot(q.x - p.x, q.y - p.y);
+        }
+    }
+
+    labelComponents(roadMap);
+    
+    TRACE_INFO("Built roadmap with " << nodeCount << " nodes, "
+               << countTotalEdges(roadMap) << " edges and "
+               << roadMap.componentCount << " components");
 
     return roadMap;
 }
 
-int PathComputer::countTotalEdges(RoadMap& roadMap) {
-    int totalEdges = 0;
-    for (RoadMapNode* node : roadMap.nodes) {
-        totalEdges += node->neighbors.size();
+// New node with an empty row at the end of the arrays; dropped ids first
+static uint32_t addNode(RoadMap& roadMap, const Point& position, Trapezoid* trap,
+                        uint32_t label) {
+    uint32_t v;
+    if (!roadMap.freeNodes.empty()) {
+        v = roadMap.freeNodes.back();
+        roadMap.freeNodes.pop_back();
+        roadMap.positions[v] = position;
+    } else {
+        v = static_cast<uint32_t>(roadMap.nodeCount());
+        roadMap.positions.push_back(position);
+        roadMap.rowBegin.push_back(0);
+        roadMap.rowEnd.push_back(0);
+        roadMap.nodeTrapezoid.push_back(NULL);
+        roadMap.component.push_back(ROADMAP_NONE);
+    }
+    uint32_t tail = static_cast<uint32_t>(roadMap.neighbors.size());
+    roadMap.rowBegin[v] = roadMap.rowEnd[v] = tail;
+    roadMap.nodeTrapezoid[v] = trap;
+    roadMap.component[v] = label;
+    if (trap) trap->roadNode = static_cast<int>(v);
+    return v;
+}
+
+// Rows only grow at the end of the arrays; one sitting elsewhere is moved
+// there first and leaves its old entries unused
+static void addEdge(RoadMap& roadMap, uint32_t v, uint32_t w) {
+    if (roadMap.rowEnd[v] != roadMap.neighbors.size()) {
+        uint32_t tail = static_cast<uint32_t>(roadMap.neighbors.size());
+        for (uint32_t e = roadMap.rowBegin[v]; e < roadMap.rowEnd[v]; e++) {
+            uint32_t neighbor = roadMap.neighbors[e];
+            double length = roadMap.lengths[e];
+            roadMap.neighbors.push_back(neighbor);
+            roadMap.lengths.push_back(length);
+        }
+        roadMap.unusedEdges += roadMap.rowEnd[v] - roadMap.rowBegin[v];
+        roadMap.rowBegin[v] = tail;
+    }
+    const Point& p = roadMap.positions[v];
+    const Point& q = roadMap.positions[w];
+    roadMap.neighbors.push_back(w);
+    roadMap.lengths.push_back(hypot(q.x - p.x, q.y - p.y));
+    roadMap.rowEnd[v] = static_cast<uint32_t>(roadMap.neighbors.size());
+}
+
+static void removeEdge(RoadMap& roadMap, uint32_t v, uint32_t w) {
+    for (uint32_t e = roadMap.rowBegin[v]; e < roadMap.rowEnd[v]; e++) {
+        if (roadMap.neighbors[e] != w) continue;
+        uint32_t last = --roadMap.rowEnd[v];
+        roadMap.neighbors[e] = roadMap.neighbors[last];
+        roadMap.lengths[e] = roadMap.lengths[last];
+        roadMap.unusedEdges++;
+        return;
+    }
+}
+
+static void dropNode(RoadMap& roadMap, uint32_t v) {
+    roadMap.unusedEdges += roadMap.rowEnd[v] - roadMap.rowBegin[v];
+    roadMap.rowEnd[v] = roadMap.rowBegin[v];
+    if (roadMap.nodeTrapezoid[v]) roadMap.nodeTrapezoid[v]->roadNode = -1;
+    roadMap.nodeTrapezoid[v] = NULL;
+    roadMap.component[v] = ROADMAP_NONE;
+    roadMap.freeNodes.push_back(v);
+}
+
+// Pack the rows back to back again once more than half the arrays is
+// unused, so the arrays stay within twice the live size at O(E) per
+// compaction
+static void compactRows(RoadMap& roadMap) {
+    if (roadMap.unusedEdges * 2 <= roadMap.neighbors.size()) return;
+    vector<uint32_t> neighbors;
+    vector<double> lengths;
+    neighbors.reserve(roadMap.neighbors.size() - roadMap.unusedEdges);
+    lengths.reserve(neighbors.capacity());
+    for (size_t v = 0; v < roadMap.nodeCount(); v++) {
+        uint32_t begin = static_cast<uint32_t>(neighbors.size());
+        for (uint32_t e = roadMap.rowBegin[v]; e < roadMap.rowEnd[v]; e++) {
+            neighbors.push_back(roadMap.neighbors[e]);
+            lengths.push_back(roadMap.lengths[e]);
+        }
+        roadMap.rowBegin[v] = begin;
+        roadMap.rowEnd[v] = static_cast<uint32_t>(neighbors.size());
     }
-    return totalEdges / 2;
+    roadMap.neighbors.swap(neighbors);
+    roadMap.lengths.swap(lengths);
+    roadMap.unusedEdges = 0;
 }
 
-vector<Point> PathComputer::breadthFirstSearch(RoadMapNode* start, RoadMapNode* goal) {
-    if (!start || !goal) return {};
-    if (start == goal) return {start->position};
+static void addCrossing(RoadMap& roadMap, Trapezoid* left, Trapezoid* right, uint32_t label,
+                        vector<uint32_t>& created) {
+    Point position;
+    if (!wallCrossing(left, right, position)) return;
+    uint32_t a = roadMap.getNodeForTrapezoid(left);
+    uint32_t b = roadMap.getNodeForTrapezoid(right);
+    uint32_t crossing = addNode(roadMap, position, NULL, label);
+    addEdge(roadMap, crossing, a);
+    addEdge(roadMap, crossing, b);
+    addEdge(roadMap, a, crossing);
+    addEdge(roadMap, b, crossing);
+    created.push_back(crossing);
+}
+
+// Give everything reachable from the new nodes their label, where the new
+// nodes join regions that were apart
+static void mergeComponents(RoadMap& roadMap, const vector<uint32_t>& created) {
+    if (created.empty()) return;
+    uint32_t label = roadMap.component[created[0]];
+    bool mixed = false;
+    for (uint32_t v : created) {
+        for (uint32_t e = roadMap.rowBegin[v]; e < roadMap.rowEnd[v] && !mixed; e++) {
+            mixed = roadMap.component[roadMap.neighbors[e]] != label;
+        }
+    }
+    if (!mixed) return;
     
-    unordered_map<RoadMapNode*, RoadMapNode*> cameFrom;
-    queue<RoadMapNode*> q;
-    unordered_set<RoadMapNode*> visited;
+    vector<uint32_t> stack(created);
+    while (!stack.empty()) {
+        uint32_t v = stack.back();
+        stack.pop_back();
+        for (uint32_t e = roadMap.rowBegin[v]; e < roadMap.rowEnd[v]; e++) {
+            uint32_t w = roadMap.neighbors[e];
+            if (roadMap.component[w] != label) {
+                roadMap.component[w] = label;
+                stack.push_back(w);
+            }
+        }
+    }
+}
+
+// Are the new nodes connected among themselves? They usually are: an
+// obstacle inserted clear of the others leaves a ring of new trapezoids
+// around it, and a removal fills the hole with new ones.
+static bool createdConnected(const RoadMap& roadMap, vector<uint32_t> created) {
+    if (created.empty()) return true;
+    sort(created.begin(), created.end());
+    vector<uint8_t> seen(created.size(), 0);
+    vector<uint32_t> stack(1, created[0]);
+    seen[0] = 1;
+    size_t reached = 1;
+    while (!stack.empty()) {
+        uint32_t v = stack.back();
+        stack.pop_back();
+        for (uint32_t e = roadMap.rowBegin[v]; e < roadMap.rowEnd[v]; e++) {
+            auto it = lower_bound(created.begin(), created.end(), roadMap.neighbors[e]);
+            if (it == created.end() || *it != roadMap.neighbors[e]) continue;
+            size_t i = it - created.begin();
+            if (seen[i]) continue;
+            seen[i] = 1;
+            reached++;
+            stack.push_back(*it);
+        }
+    }
+    return reached == created.size();
+}
+
+// An obstacle touching others can cut a region in two. Flood fill every
+// region the new nodes lie in with a label of its own; the first keeps the
+// label the new nodes were given.
+static void splitComponents(RoadMap& roadMap, const vector<uint32_t>& created) {
+    vector<uint8_t> seen(roadMap.nodeCount(), 0);
+    vector<uint32_t> stack;
+    bool first = true;
+    for (uint32_t s : created) {
+        if (seen[s]) continue;
+        uint32_t label = first ? roadMap.component[s] : roadMap.componentCount++;
+        first = false;
+        seen[s] = 1;
+        roadMap.component[s] = label;
+        stack.push_back(s);
+        while (!stack.empty()) {
+            uint32_t v = stack.back();
+            stack.pop_back();
+            for (uint32_t e = roadMap.rowBegin[v]; e < roadMap.rowEnd[v]; e++) {
+                uint32_t w = roadMap.neighbors[e];
+                if (seen[w]) continue;
+                seen[w] = 1;
+                roadMap.component[w] = label;
+                stack.push_back(w);
+            }
+        }
+    }
+}
+
+void PathComputer::updateRoadMap(RoadMap& roadMap, const TrapezoidalMap& freeSpaceMap,
+                                 const MapUpdate& update) {
+    // 1. Drop the centers of the trapezoids that are gone, and with them
+    // every wall crossing they had. Trapezoids that were created and split
+    // again within the update never got a node.
+    uint32_t label = ROADMAP_NONE;
+    size_t dropped = 0;
+    for (Trapezoid* trap : update.removed) {
+        uint32_t v = roadMap.getNodeForTrapezoid(trap);
+        if (v == ROADMAP_NONE) continue;
+        label = roadMap.component[v];
+        for (uint32_t e = roadMap.rowBegin[v]; e < roadMap.rowEnd[v]; e++) {
+            uint32_t crossing = roadMap.neighbors[e];
+            uint32_t first = roadMap.rowBegin[crossing];
+            uint32_t other = roadMap.neighbors[first] == v ? roadMap.neighbors[first + 1]
+                                                           : roadMap.neighbors[first];
+            removeEdge(roadMap, other, crossing);
+            dropNode(roadMap, crossing);
+        }
+        dropNode(roadMap, v);
+        dropped++;
+    }
     
-    q.push(start);
-    visited.insert(start);
-    cameFrom[start] = nullptr;
+    // New nodes join the component of what they replace. A removal may join
+    // regions and an insertion touching other obstacles may split one; both
+    // are sorted out at the end.
+    if (label == ROADMAP_NONE) label = roadMap.componentCount++;
+
+    // 2. Centers for the new trapezoids
+    vector<uint32_t> created;
+    for (Trapezoid* trap : update.added) {
+        created.push_back(addNode(roadMap, getTrapezoidCenter(trap), trap, label));
+    }
+
+    // 3. Crossings on every wall a new trapezoid has, each seen from the
+    // trapezoid on its left as in buildRoadMap: the new trapezoids' own
+    // right walls and the right walls of old trapezoids next to them
+    vector<Trapezoid*> added(update.added);
+    sort(added.begin(), added.end());
+    auto isNew = [&added](Trapezoid* t) { return binary_search(added.begin(), added.end(), t); };
     
-    while (!q.empty()) {
-        RoadMapNode* current = q.front();
-        q.pop();
-        
-        if (current == goal) {
-            vector<Point> path;
-            RoadMapNode* node = goal;
-            while (node) {
-                path.push_back(node->position);
-                node = cameFrom[node];
-            }
-            reverse(path.begin(), path.end());
-            return path;
+    vector<Trapezoid*> oldLeft;
+    for (Trapezoid* trap : update.added) {
+        for (Trapezoid* prev : {trap->upperLeft, trap->lowerLeft}) {
+            if (freeSpaceMap.contains(prev) && !isNew(prev)) oldLeft.push_back(prev);
+        }
+    }
+    sort(oldLeft.begin(), oldLeft.end());
+    oldLeft.erase(unique(oldLeft.begin(), oldLeft.end()), oldLeft.end());
+    
+    for (Trapezoid* trap : update.added) {
+        Trapezoid* lower = (trap->lowerRight != trap->upperRight) ? trap->lowerRight : NULL;
+        for (Trapezoid* next : {trap->upperRight, lower}) {
+            if (freeSpaceMap.contains(next)) addCrossing(roadMap, trap, next, label, created);
         }
+    }
+    for (Trapezoid* trap : oldLeft) {
+        Trapezoid* lower = (trap->lowerRight != trap->upperRight) ? trap->lowerRight : NULL;
+        for (Trapezoid* next : {trap->upperRight, lower}) {
+            if (freeSpaceMap.contains(next) && isNew(next)) addCrossing(roadMap, trap, next, label, created);
+        }
+    }
+    
+    if (createdConnected(roadMap, created)) {
+        mergeComponents(roadMap, created);
+    } else {
+        splitComponents(roadMap, created);
+    }
+    compactRows(roadMap);
+    
+    TRACE_DEBUG("Roadmap update: dropped " << dropped << " centers, added "
+                << update.added.size() << "; " << roadMap.edgeCount() << " edges");
+}
+
+// Slack for paths that run along an obstacle edge or through its corners
+static const double PATH_TOLERANCE = 1e-9;
+
+// Does seg stay between t's top and bottom over the part of t's x-range it
+// covers? Both are straight, so checking the two ends of that part is enough.
+// A vertical side is an obstacle edge between t's corners, which a path may
+// touch anywhere, so it bounds t at the far corner.
+static bool staysInside(const Trapezoid* t, const Segment& seg, double xFrom, double xTo) {
+    bool verticalTop = fabs(t->top->p1.x - t->top->p2.x) < PATH_TOLERANCE;
+    bool verticalBottom = fabs(t->bottom->p1.x - t->bottom->p2.x) < PATH_TOLERANCE;
+    for (double x : {xFrom, xTo}) {
+        double y = seg.yAt(x);
+        double top = verticalTop ? t->rightp.y : t->topAt(x);
+        double bottom = verticalBottom ? t->leftp.y : t->bottomAt(x);
+        if (y > top + PATH_TOLERANCE || y < bottom - PATH_TOLERANCE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A vertical piece of path lies on one x, usually a wall between two
+// trapezoids; it is free if the trapezoid just left or just right of it
+// spans it
+static bool isValidVerticalSegment(const TrapezoidalMap& map, const Segment& seg) {
+    Point low = seg.getLeftEndpoint();
+    Point high = seg.getRightEndpoint();
+    double delta = PATH_TOLERANCE * (1.0 + fabs(low.x));
+    for (double x : {low.x - delta, low.x + delta}) {
+        Node* leaf = queryTrapezoidMap(map.root, Point(x, 0.5 * (low.y + high.y)));
+        Trapezoid* t = leaf ? leaf->trapezoid : NULL;
+        if (map.contains(t) && x >= t->leftp.x && x <= t->rightp.x
+            && high.y <= t->top->yAt(x) + PATH_TOLERANCE
+            && low.y >= t->bottom->yAt(x) - PATH_TOLERANCE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Same walk as findIntersectedTrapezoids, but it gives up as soon as the
+// segment leaves the free trapezoids
+static bool walkSegment(const TrapezoidalMap& map, const Segment& seg, bool collinearAbove) {
+    Point left = seg.getLeftEndpoint();
+    Point right = seg.getRightEndpoint();
+    
+    Node* startNode = locateSegmentStart(map.root, seg, collinearAbove);
+    Trapezoid* current = startNode ? startNode->trapezoid : NULL;
+    // Point location clamps to the map; anything left of it is outside
+    if (current && left.x < current->leftp.x - PATH_TOLERANCE) return false;
+    
+    while (map.contains(current)) {
+        double xFrom = max(left.x, current->leftp.x);
+        double xTo = min(right.x, current->rightp.x);
+        if (!staysInside(current, seg, xFrom, xTo)) return false;
+        if (!(current->rightp < right)) return true;
         
-        for (RoadMapNode* neighbor : current->neighbors) {
-            if (visited.find(neighbor) == visited.end()) {
-                visited.insert(neighbor);
-                cameFrom[neighbor] = current;
-                q.push(neighbor);
-            }
+        Point rightPoint = current->rightp;
+        Trapezoid* next;
+        if (current->upperRight == current->lowerRight) {
+            next = current->upperRight;
+        } else if (fabs(seg.yAt(rightPoint.x) - rightPoint.y) > PATH_TOLERANCE) {
+            next = seg.isAbove(rightPoint) ? current->lowerRight : current->upperRight;
+        } else {
+            // Through the vertex that splits the two neighbours: the
+            // direction of the segment against the splitting edge decides
+            const Segment* split = current->upperRight->bottom;
+            Point a = split->getLeftEndpoint();
+            Point b = split->getRightEndpoint();
+            double cross = (b.x - a.x) * (right.y - left.y) - (b.y - a.y) * (right.x - left.x);
+            next = (cross > 0) ? current->upperRight : current->lowerRight;
         }
+        current = next;
     }
+    return false;
+}
+
+static bool isValidSegment(const TrapezoidalMap& map, const Segment& seg) {
+    Point left = seg.getLeftEndpoint();
+    Point right = seg.getRightEndpoint();
+    if (fabs(right.x - left.x) < PATH_TOLERANCE) return isValidVerticalSegment(map, seg);
+    
+    // A segment running along an obstacle edge starts on whichever side of
+    // it point location picks; the walk only proves it free from the free side
+    return walkSegment(map, seg, false) || walkSegment(map, seg, true);
+}
+
+bool PathComputer::isValidPath(const TrapezoidalMap& freeSpaceMap, const vector<Point>& path) {
+    if (path.empty()) return false;
     
-    return {};
+    bool moved = false;
+    for (size_t i = 1; i < path.size(); i++) {
+        if (path[i].equals(path[i - 1])) continue;
+        if (!isValidSegment(freeSpaceMap, Segment(path[i - 1], path[i]))) return false;
+        moved = true;
+    }
+    // A path that never moves is valid if its one point is free
+    return moved || isValidVerticalSegment(freeSpaceMap, Segment(path[0], path[0]));
+}
+
+size_t PathComputer::validatePaths(const TrapezoidalMap& freeSpaceMap,
+                                   const vector<vector<Point>>& paths,
+                                   vector<uint8_t>& valid) {
+    valid.resize(paths.size());
+    size_t count = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        valid[i] = isValidPath(freeSpaceMap, paths[i]) ? 1 : 0;
+        count += valid[i];
+    }
+    return count;
+}
+
+int PathComputer::countTotalEdges(const RoadMap& roadMap) {
+    return static_cast<int>(roadMap.edgeCount());
+}
+
+vector<Point> PathComputer::breadthFirstSearch(const RoadMap& roadMap,
+                                               uint32_t start, uint32_t goal) {
+    SearchScratch scratch;
+    return breadthFirstSearch(roadMap, start, goal, scratch);
+}
+
+vector<Point> PathComputer::breadthFirstSearch(const RoadMap& roadMap,
+                                               uint32_t start, uint32_t goal,
+                                               SearchScratch& scratch) {
+    vector<Point> path;
+    RoadMapView view = roadMap.view();
+    if (breadthFirstCore(view, start, goal, scratch)) {
+        appendRoadmapPath(view, scratch, start, goal, path);
+    }
+    return path;
+}
+
+vector<Point> PathComputer::aStarSearch(const RoadMap& roadMap,
+                                        uint32_t start, uint32_t goal,
+                                        SearchScratch& scratch) {
+    vector<Point> path;
+    RoadMapView view = roadMap.view();
+    if (shortestPathCore(view, start, goal, scratch, NULL)) {
+        appendRoadmapPath(view, scratch, start, goal, path);
+    }
+    return path;
+}
+
+vector<Point> PathComputer::altSearch(const RoadMap& roadMap,
+                                      const LandmarkTable& landmarks,
+                                      uint32_t start, uint32_t goal,
+                                      SearchScratch& scratch) {
+    vector<Point> path;
+    RoadMapView view = roadMap.view();
+    if (shortestPathCore(view, start, goal, scratch, &landmarks)) {
+        appendRoadmapPath(view, scratch, start, goal, path);
+    }
+    return path;
 }
@@ -10,6 +10,9 @@
 #include "compute_path.hpp"
 
 #include "sdl_layer.hpp"
+#include "trace.hpp"
+
+static const char TRACE_MODULE[] = "compute_path_demo";
 
 void compute_path_demo() {
     // Application start
@@ -40,19 +43,26 @@ void compute_path_demo() {
     triangle3.addVertex(92, 25);
     polygons.push_back(triangle3);
 
-    std::cout << "Computing free space..." << std::endl;
+    TRACE_INFO("Computing free space...");
     TrapezoidalMap freeSpaceMap = FreeSpaceComputer::COMPUTEFREESPACE(polygons);
     
-    std::cout << "Building roadmap..." << std::endl;
+    TRACE_INFO("Building roadmap...");
     RoadMap roadMap = PathComputer::buildRoadMap(freeSpaceMap);
 
     Point start(20, 50);
     Point goal(85, 60);
 
-    std::cout << "Computing path from (" << start.x << ", " << start.y 
-              << ") to (" << goal.x << ", " << goal.y << ")" << std::endl;
+    TRACE_INFO("Computing path from (" << start.x << ", " << start.y 
+               << ") to (" << goal.x << ", " << goal.y << ")");
     
-    std::vector<Point> path = PathComputer::COMPUTEPATH(freeSpaceMap, roadMap, start, goal);
+    // T switches between the roadmap path and its taut version
+    bool taut = false;
+    auto computePath = [&]() {
+        return taut ? PathComputer::COMPUTETAUTPATH(freeSpaceMap, roadMap, start, goal)
+                    : PathComputer::COMPUTEPATH(freeSpaceMap, roadMap, start, goal);
+    };
+
+    std::vector<Point> path = computePath();
 
     bool running = true;
     SDL_Event event;
@@ -67,10 +77,15 @@ void compute_path_demo() {
             if (event.type == SDL_KEYDOWN) {
                 if (event.key.keysym.sym == SDLK_r) {
                     showRoadmap = !showRoadmap;
-                    std::cout << (showRoadmap ? "Showing roadmap" : "Hiding roadmap") << std::endl;
+                    TRACE_INFO((showRoadmap ? "Showing roadmap" : "Hiding roadmap"));
                 }
                 if (event.key.keysym.sym == SDLK_c) {
-                    path = PathComputer::COMPUTEPATH(freeSpaceMap, roadMap, start, goal);
+                    path = computePath();
+                }
+                if (event.key.keysym.sym == SDLK_t) {
+                    taut = !taut;
+                    TRACE_INFO((taut ? "Showing taut path" : "Showing roadmap path"));
+                    path = computePath();
                 }
             }
             if (event.type == SDL_MOUSEBUTTONDOWN) {
@@ -84,14 +99,14 @@ void compute_path_demo() {
                         
                         if (selectingStart) {
                             start = worldPos;
-                            std::cout << "New start: (" << start.x << ", " << start.y << ")" << std::endl;
+                            TRACE_INFO("New start: (" << start.x << ", " << start.y << ")");
                         } else {
                             goal = worldPos;
-                            std::cout << "New goal: (" << goal.x << ", " << goal.y << ")" << std::endl;
+                            TRACE_INFO("New goal: (" << goal.x << ", " << goal.y << ")");
                         }
                         selectingStart = !selectingStart;
                         
-                        path = PathComputer::COMPUTEPATH(freeSpaceMap, roadMap, start, goal);
+                        path = computePath();
                     }
                 }
             }
@@ -170,7 +185,7 @@ void compute_path_demo() {
             
             char stats[100];
             snprintf(stats, sizeof(stats), "Free Trapezoids: %zu | Roadmap Nodes: %zu", 
-                    freeSpaceMap.trapezoids.size(), roadMap.nodes.size());
+                    freeSpaceMap.trapezoids.size(), roadMap.nodeCount());
             drawText(renderer, font, stats, MAP_WIDTH/2, 40, textColor);
             
             if (path.empty()) {
@@ -189,9 +204,10 @@ void compute_path_demo() {
         }
 
         SDL_RenderPresent(renderer);
+        trace::flush();
     }
 
-    std::cout << "Cleaning up..." << std::endl;
+    TRACE_INFO("Cleaning up...");
     if (font) TTF_CloseFont(font);
     freeSpaceMap.cleanup();
     SDL_DestroyRenderer(renderer);
@@ -0,0 +1,112 @@
+#include "configuration_space.hpp"
+#include "compute_free_space.hpp"
+#include "minkowski_sum.hpp"
+#include "polygon_union.hpp"
+#include "parallel_for.hpp"
+#include "trace.hpp"
+
+#include <chrono>
+
+using namespace std;
+
+static const char TRACE_MODULE[] = "configuration_space";
+
+// Obstacles or obstacle pieces per task; a sum is a few hundred nanoseconds
+static const size_t GROW_CHUNK = 64;
+
+void convexObstaclePieces(vector<Polygon>& pieces, const vector<Polygon>& obstacles,
+                          size_t threads) {
+    size_t n = obstacles.size();
+    vector<vector<Polygon>> split(n);
+    parallelFor(n, threads, GROW_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            split[i] = MinkowskiSum::convexDecomposition(obstacles[i]);
+        }
+    });
+    pieces.clear();
+    for (vector<Polygon>& parts : split) {
+        for (Polygon& piece : parts) pieces.push_back(std::move(piece));
+    }
+}
+
+void buildConfigurationSpace(ConfigurationSpace& space,
+                             const Polygon& robot,
+                             const vector<Polygon>& obstacles,
+                             size_t threads,
+                             unsigned seed) {
+    auto t0 = chrono::steady_clock::now();
+    vector<Polygon> robotPieces = MinkowskiSum::convexDecomposition(robot);
+    vector<Polygon> obstaclePieces;
+    convexObstaclePieces(obstaclePieces, obstacles, threads);
+    double decompose = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    buildConfigurationSpace(space, robotPieces, obstaclePieces, threads, seed);
+    space.stats.grow += decompose;
+}
+
+void buildConfigurationSpace(ConfigurationSpace& space,
+                             const vector<Polygon>& robotPieces,
+                             const vector<Polygon>& obstaclePieces,
+                             size_t threads,
+                             unsigned seed) {
+    space.freeSpace.cleanup();
+    space.roadMap = RoadMap();
+    space.stats = PipelineStats();
+
+    // A robot made of pieces sweeps the union of what its pieces sweep
+    vector<Polygon> reflected(robotPieces);
+    for (Polygon& piece : reflected) piece = piece.reflectAboutOrigin();
+
+    // 1. Every obstacle piece grown by every robot piece, each sum in its own
+    // slot
+    auto t0 = chrono::steady_clock::now();
+    size_t n = obstaclePieces.size();
+    size_t r = reflected.size();
+    space.grown.resize(n * r);
+    space.stats.threads = parallelFor(n, threads, GROW_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            for (size_t j = 0; j < r; j++) {
+                MinkowskiSum::MINKOWSKISUM(obstaclePieces[i], reflected[j], space.grown[i * r + j]);
+            }
+        }
+    });
+    space.stats.grow = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    // 2. Overlapping sums merged into disjoint obstacles, whose edges go to
+    // offsets known from the vertex counts
+    t0 = chrono::steady_clock::now();
+    space.obstacles = unionPolygons(space.grown, threads);
+    size_t m = space.obstacles.size();
+    vector<size_t> offset(m + 1, 0);
+    for (size_t i = 0; i < m; i++) {
+        offset[i + 1] = offset[i] + space.obstacles[i].vertices.size();
+    }
+    space.edges.resize(offset[m]);
+    parallelFor(m, threads, GROW_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            FreeSpaceComputer::extractEdges(space.obstacles[i], static_cast<int>(i),
+                                            &space.edges[offset[i]]);
+        }
+    });
+    space.stats.unite = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    // 3. Free space, as COMPUTEFREESPACE does it but over the edges above
+    t0 = chrono::steady_clock::now();
+    space.freeSpace = BuildTrapezoidalMap(space.edges, seed);
+    space.stats.build = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    t0 = chrono::steady_clock::now();
+    FreeSpaceComputer::removeInteriorTrapezoids(space.freeSpace);
+    space.stats.removeInterior = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    // 4. Roadmap
+    t0 = chrono::steady_clock::now();
+    space.roadMap = PathComputer::buildRoadMap(space.freeSpace);
+    space.stats.roadMap = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    TRACE_INFO("Configuration space: " << n << " obstacle pieces grown on " << space.stats.threads
+               << " threads into " << space.grown.size() << " convex sums, " << m
+               << " after the union, " << space.edges.size() << " edges, "
+               << space.freeSpace.trapezoids.size() << " free trapezoids, "
+               << space.roadMap.nodeCount() << " roadmap nodes");
+}
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <cmath>
+#include <limits>
 
 Point::Point(double x, double y) : x(x), y(y) {};
 bool Point::operator<(const Point& p) const {
@@ -63,6 +64,20 @@ double Segment::yAt(double x) const {
 }
 
 
+// A vertical side only bounds a trapezoid of zero width, which the symbolic
+// shear fits in between the two ends of a vertical edge. Of the wall such a
+// trapezoid stands for, the part clear of the edge is the part below its
+// left corner (vertical top) or above its right corner (vertical bottom).
+double Trapezoid::topAt(double x) const {
+    if (fabs(top->p1.x - top->p2.x) < 1e-9) return leftp.y;
+    return top->yAt(x);
+}
+
+double Trapezoid::bottomAt(double x) const {
+    if (fabs(bottom->p1.x - bottom->p2.x) < 1e-9) return rightp.y;
+    return bottom->yAt(x);
+}
+
 double Segment::getY(double x) const {
     Point left = getLeftEndpoint();
     Point right = getRightEndpoint();
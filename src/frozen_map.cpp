@@ -0,0 +1,322 @@
+#include "frozen_map.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <unordered_map>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+static const char TRACE_MODULE[] = "frozen_map";
+
+
+FrozenSearchStructure freezeSearchStructure(const TrapezoidalMap& map) {
+    FrozenSearchStructure fs;
+    if (map.root == NULL) return fs;
+
+    // Number the nodes depth first, so a node's first child usually sits
+    // right after it and a query walks mostly forward through each array
+    unordered_map<Node*, uint32_t> nodeRef;
+    vector<Node*> order;
+    vector<Node*> stack;
+    stack.push_back(map.root);
+    size_t xCount = 0, yCount = 0;
+
+    while (!stack.empty()) {
+        Node* n = stack.back();
+        stack.pop_back();
+        if (n == NULL || nodeRef.find(n) != nodeRef.end()) continue;
+
+        if (n->type == X_NODE) {
+            nodeRef[n] = FROZEN_X_NODE | static_cast<uint32_t>(xCount++);
+            order.push_back(n);
+            stack.push_back(n->right);
+            stack.push_back(n->left);
+        } else if (n->type == Y_NODE) {
+            nodeRef[n] = FROZEN_Y_NODE | static_cast<uint32_t>(yCount++);
+            order.push_back(n);
+            stack.push_back(n->below);
+            stack.push_back(n->above);
+        } else if (n->trapezoid) {
+            nodeRef[n] = FROZEN_LEAF | static_cast<uint32_t>(fs.trapezoids.size());
+            fs.trapezoids.push_back(n->trapezoid);
+        } else {
+            nodeRef[n] = FROZEN_NONE;
+        }
+    }
+
+    if (max(max(xCount, yCount), fs.trapezoids.size()) > FROZEN_INDEX) {
+        TRACE_ERROR("Search structure too large to freeze: " << xCount << " x-nodes, "
+                    << yCount << " y-nodes, " << fs.trapezoids.size() << " leaves");
+        return FrozenSearchStructure();
+    }
+
+    auto refOf = [&nodeRef](Node* n) {
+        return n ? nodeRef[n] : FROZEN_NONE;
+    };
+
+    fs.xNodes.reserve(xCount);
+    fs.yNodes.reserve(yCount);
+    for (Node* n : order) {
+        if (n->type == X_NODE) {
+            FrozenXNode f;
+            f.x = n->point.x;
+            f.y = n->point.y;
+            f.child[0] = refOf(n->left);
+            f.child[1] = refOf(n->right);
+            fs.xNodes.push_back(f);
+        } else {
+            Point left = n->segment->getLeftEndpoint();
+            Point right = n->segment->getRightEndpoint();
+            FrozenYNode f;
+            f.a = left.x;
+            f.b = left.y;
+            f.c = right.x - left.x;
+            f.d = right.y - left.y;
+            f.child[0] = refOf(n->above);
+            f.child[1] = refOf(n->below);
+            fs.yNodes.push_back(f);
+        }
+    }
+    fs.root = refOf(map.root);
+
+    return fs;
+}
+
+uint32_t queryFrozenIndex(const FrozenSearchStructure& fs, const Point& p) {
+    return queryFrozenNodes(fs.xNodes.data(), fs.yNodes.data(), fs.root, p);
+}
+
+uint32_t queryFrozenNodes(const FrozenXNode* xNodes, const FrozenYNode* yNodes, uint32_t root,
+                          const Point& p) {
+    uint32_t i = root;
+    while (i < FROZEN_LEAF) {
+        // Keep these as branches: predicted branches let the CPU start
+        // loading the next node before the comparison is resolved
+        if (i < FROZEN_Y_NODE) {
+            const FrozenXNode& n = xNodes[i];
+            // Same lexicographic test as Point::operator<
+            bool less = (fabs(p.x - n.x) > 1e-9) ? (p.x < n.x) : (p.y < n.y);
+            if (less) {
+                i = n.child[0];
+            } else {
+                i = n.child[1];
+            }
+        } else {
+            const FrozenYNode& n = yNodes[i & FROZEN_INDEX];
+            // Same cross product as Segment::isAbove
+            double cross = n.c * (p.y - n.b) - n.d * (p.x - n.a);
+            if (cross > 1e-9) {
+                i = n.child[0];
+            } else {
+                i = n.child[1];
+            }
+        }
+    }
+    return (i == FROZEN_NONE) ? FROZEN_NONE : (i & FROZEN_INDEX);
+}
+
+Trapezoid* queryFrozenStructure(const FrozenSearchStructure& fs, const Point& p) {
+    uint32_t idx = queryFrozenIndex(fs, p);
+    return (idx == FROZEN_NONE) ? NULL : fs.trapezoids[idx];
+}
+
+// Node tests for a group of lanes. Lane l tests against the point key[l] and
+// the direction dir[l]; bit l of xBits / yBits is set when it takes child[1]
+// of its node if that node is an x-node / a y-node.
+struct LaneTests {
+    unsigned xBits;
+    unsigned yBits;
+};
+
+#if defined(__AVX2__)
+
+// Two groups of four: the walk is latency bound, so more chains in flight
+// matter more than the width of one vector
+static const size_t BATCH_LANES = 8;
+
+static LaneTests testLanes(const double* const* key, const double* const* dir,
+                           const double* px, const double* py) {
+    LaneTests t = {0, 0};
+    for (size_t g = 0; g < BATCH_LANES; g += 4) {
+        // Plain loads: hardware gathers are slower than four scalar loads on
+        // many current cores
+        const double* const* k = key + g;
+        const double* const* v = dir + g;
+        __m256d a = _mm256_set_pd(k[3][0], k[2][0], k[1][0], k[0][0]);
+        __m256d b = _mm256_set_pd(k[3][1], k[2][1], k[1][1], k[0][1]);
+        __m256d c = _mm256_set_pd(v[3][0], v[2][0], v[1][0], v[0][0]);
+        __m256d d = _mm256_set_pd(v[3][1], v[2][1], v[1][1], v[0][1]);
+        __m256d x = _mm256_load_pd(px + g);
+        __m256d y = _mm256_load_pd(py + g);
+        __m256d eps = _mm256_set1_pd(1e-9);
+
+        // x-node: lexicographic p < (a, b)
+        __m256d dx = _mm256_sub_pd(x, a);
+        __m256d absdx = _mm256_andnot_pd(_mm256_set1_pd(-0.0), dx);
+        __m256d apart = _mm256_cmp_pd(absdx, eps, _CMP_GT_OQ);
+        __m256d lessX = _mm256_cmp_pd(x, a, _CMP_LT_OQ);
+        __m256d lessY = _mm256_cmp_pd(y, b, _CMP_LT_OQ);
+        __m256d less = _mm256_blendv_pd(lessY, lessX, apart);
+
+        // y-node: cross product of Segment::isAbove
+        __m256d cross = _mm256_sub_pd(_mm256_mul_pd(c, _mm256_sub_pd(y, b)),
+                                      _mm256_mul_pd(d, dx));
+        __m256d above = _mm256_cmp_pd(cross, eps, _CMP_GT_OQ);
+
+        t.xBits |= (~static_cast<unsigned>(_mm256_movemask_pd(less)) & 0xFu) << g;
+        t.yBits |= (~static_cast<unsigned>(_mm256_movemask_pd(above)) & 0xFu) << g;
+    }
+    return t;
+}
+
+#elif defined(__SSE2__)
+
+static const size_t BATCH_LANES = 2;
+
+static LaneTests testLanes(const double* const* key, const double* const* dir,
+                           const double* px, const double* py) {
+    __m128d a = _mm_set_pd(key[1][0], key[0][0]);
+    __m128d b = _mm_set_pd(key[1][1], key[0][1]);
+    __m128d c = _mm_set_pd(dir[1][0], dir[0][0]);
+    __m128d d = _mm_set_pd(dir[1][1], dir[0][1]);
+    __m128d x = _mm_loadu_pd(px);
+    __m128d y = _mm_loadu_pd(py);
+    __m128d eps = _mm_set1_pd(1e-9);
+
+    // x-node: lexicographic p < (a, b)
+    __m128d dx = _mm_sub_pd(x, a);
+    __m128d absdx = _mm_andnot_pd(_mm_set1_pd(-0.0), dx);
+    __m128d apart = _mm_cmpgt_pd(absdx, eps);
+    __m128d lessX = _mm_cmplt_pd(x, a);
+    __m128d lessY = _mm_cmplt_pd(y, b);
+    __m128d less = _mm_or_pd(_mm_and_pd(apart, lessX), _mm_andnot_pd(apart, lessY));
+
+    // y-node: cross product of Segment::isAbove
+    __m128d cross = _mm_sub_pd(_mm_mul_pd(c, _mm_sub_pd(y, b)), _mm_mul_pd(d, dx));
+    __m128d above = _mm_cmpgt_pd(cross, eps);
+
+    LaneTests t;
+    t.xBits = ~static_cast<unsigned>(_mm_movemask_pd(less)) & 0x3u;
+    t.yBits = ~static_cast<unsigned>(_mm_movemask_pd(above)) & 0x3u;
+    return t;
+}
+
+#else
+
+static const size_t BATCH_LANES = 4;
+
+// Portable fallback: no vector unit, but the lanes still give the CPU
+// independent chains to overlap
+static LaneTests testLanes(const double* const* key, const double* const* dir,
+                           const double* px, const double* py) {
+    LaneTests t = {0, 0};
+    for (size_t l = 0; l < BATCH_LANES; l++) {
+        const double* k = key[l];
+        const double* v = dir[l];
+        double dx = px[l] - k[0];
+        bool less = (fabs(dx) > 1e-9) ? (px[l] < k[0]) : (py[l] < k[1]);
+        double cross = v[0] * (py[l] - k[1]) - v[1] * dx;
+        t.xBits |= static_cast<unsigned>(!less) << l;
+        t.yBits |= static_cast<unsigned>(!(cross > 1e-9)) << l;
+    }
+    return t;
+}
+
+#endif
+
+// Record of lanes without work: zero keys, and children that keep them idle
+static const FrozenYNode PARKED = {0, 0, 0, 0, {FROZEN_NONE, FROZEN_NONE}};
+// Direction of lanes on an x-node, whose y-node test is thrown away
+static const double NO_DIRECTION[2] = {0, 0};
+
+template <typename Emit>
+static void walkBatch(const FrozenSearchStructure& fs, const double* xs,
+                      const double* ys, size_t count, Emit emit) {
+    // Where a lane finds its node's record, by the tag of its reference:
+    // x-node, y-node, and the parked record for leaves and FROZEN_NONE. Table
+    // lookups instead of branches, since x-node vs y-node is a coin flip the
+    // predictor cannot learn.
+    const char* const base[4] = {reinterpret_cast<const char*>(fs.xNodes.data()),
+                                 reinterpret_cast<const char*>(fs.yNodes.data()),
+                                 reinterpret_cast<const char*>(&PARKED),
+                                 reinterpret_cast<const char*>(&PARKED)};
+    static const size_t STRIDE[4] = {sizeof(FrozenXNode), sizeof(FrozenYNode), 0, 0};
+    static const size_t CHILD[4] = {offsetof(FrozenXNode, child), offsetof(FrozenYNode, child),
+                                    offsetof(FrozenYNode, child), offsetof(FrozenYNode, child)};
+    const size_t IDLE = static_cast<size_t>(-1);
+
+    uint32_t node[BATCH_LANES];
+    size_t query[BATCH_LANES];
+    const double* key[BATCH_LANES];
+    const double* dir[BATCH_LANES];
+    const uint32_t* child[BATCH_LANES];
+    alignas(32) double px[BATCH_LANES];
+    alignas(32) double py[BATCH_LANES];
+    size_t nextQuery = 0;
+
+    for (size_t l = 0; l < BATCH_LANES; l++) {
+        node[l] = FROZEN_NONE;
+        query[l] = IDLE;
+        px[l] = py[l] = 0;
+    }
+
+    while (true) {
+        // Retire lanes that reached a leaf and hand them the next query
+        size_t busy = 0;
+        for (size_t l = 0; l < BATCH_LANES; l++) {
+            while (node[l] >= FROZEN_LEAF) {
+                if (query[l] != IDLE) {
+                    emit(query[l], node[l] == FROZEN_NONE ? FROZEN_NONE : node[l] & FROZEN_INDEX);
+                }
+                if (nextQuery == count) {
+                    node[l] = FROZEN_NONE;
+                    query[l] = IDLE;
+                    break;
+                }
+                query[l] = nextQuery++;
+                node[l] = fs.root;
+                px[l] = xs[query[l]];
+                py[l] = ys[query[l]];
+            }
+            busy += (query[l] != IDLE);
+        }
+        if (busy == 0) break;
+
+        unsigned isX = 0;
+        for (size_t l = 0; l < BATCH_LANES; l++) {
+            uint32_t tag = node[l] >> 30;
+            const char* record = base[tag] + (node[l] & FROZEN_INDEX) * STRIDE[tag];
+            key[l] = reinterpret_cast<const double*>(record);
+            dir[l] = (tag == 0) ? NO_DIRECTION : key[l] + 2;
+            child[l] = reinterpret_cast<const uint32_t*>(record + CHILD[tag]);
+            isX |= static_cast<unsigned>(tag == 0) << l;
+        }
+
+        LaneTests t = testLanes(key, dir, px, py);
+        unsigned bits = t.yBits ^ ((t.xBits ^ t.yBits) & isX);
+        for (size_t l = 0; l < BATCH_LANES; l++) {
+            node[l] = child[l][(bits >> l) & 1u];
+        }
+    }
+}
+
+void queryFrozenIndexBatch(const FrozenSearchStructure& fs, const double* xs,
+                           const double* ys, size_t count, uint32_t* out) {
+    walkBatch(fs, xs, ys, count, [out](size_t i, uint32_t idx) {
+        out[i] = idx;
+    });
+}
+
+void queryFrozenBatch(const FrozenSearchStructure& fs, const double* xs,
+                      const double* ys, size_t count, Trapezoid** out) {
+    Trapezoid* const* traps = fs.trapezoids.data();
+    walkBatch(fs, xs, ys, count, [out, traps](size_t i, uint32_t idx) {
+        out[i] = (idx == FROZEN_NONE) ? NULL : traps[idx];
+    });
+}
@@ -0,0 +1,255 @@
+#include "headless.hpp"
+#include "scene_io.hpp"
+#include "scene_generator.hpp"
+#include "compute_free_space.hpp"
+#include "compute_path.hpp"
+#include "landmarks.hpp"
+#include "trace.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace std;
+
+static const char* statusName(PathStatus status) {
+    switch (status) {
+    case PATH_FOUND:            return "found";
+    case PATH_START_BLOCKED:    return "start_blocked";
+    case PATH_GOAL_BLOCKED:     return "goal_blocked";
+    case PATH_NO_ROADMAP_NODE:  return "no_roadmap_node";
+    case PATH_DISCONNECTED:     return "disconnected";
+    case PATH_NOT_FOUND:        return "not_found";
+    }
+    return "unknown";
+}
+
+static double pathLength(const vector<Point>& path) {
+    double length = 0;
+    for (size_t i = 1; i < path.size(); i++) {
+        length += hypot(path[i].x - path[i - 1].x, path[i].y - path[i - 1].y);
+    }
+    return length;
+}
+
+static double secondsSince(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+static int usage() {
+    cerr << "usage: main run <scene> [bfs|astar|alt|taut] [--paths]" << endl
+         << "       main convert <scene> <binary scene>" << endl
+         << "       main bench [max edges] [csv|json] [queries] [seed]" << endl;
+    return 2;
+}
+
+static int convertScene(const char* in, const char* out) {
+    Scene scene;
+    if (!loadScene(scene, in) || !saveSceneBinary(scene, out)) return 1;
+    cout << "wrote " << scene.obstacles.size() << " obstacles and " << scene.starts.size()
+         << " queries to " << out << endl;
+    return 0;
+}
+
+static int runScene(const char* filename, const string& mode, bool printPaths) {
+    SearchAlgorithm algorithm = SEARCH_ASTAR;
+    bool taut = false;
+    if (mode == "bfs") {
+        algorithm = SEARCH_BFS;
+    } else if (mode == "alt") {
+        algorithm = SEARCH_ALT;
+    } else if (mode == "taut") {
+        taut = true;
+    } else if (mode != "astar") {
+        return usage();
+    }
+
+    auto t0 = chrono::steady_clock::now();
+    Scene scene;
+    if (!loadScene(scene, filename)) return 1;
+    double tLoad = secondsSince(t0);
+
+    t0 = chrono::steady_clock::now();
+    TrapezoidalMap map = FreeSpaceComputer::COMPUTEFREESPACE(scene.obstacles);
+    double tFreeSpace = secondsSince(t0);
+
+    t0 = chrono::steady_clock::now();
+    RoadMap roadMap = PathComputer::buildRoadMap(map);
+    double tRoadMap = secondsSince(t0);
+
+    LandmarkTable landmarks;
+    double tLandmarks = 0;
+    if (algorithm == SEARCH_ALT) {
+        t0 = chrono::steady_clock::now();
+        landmarks = buildLandmarkTable(roadMap);
+        tLandmarks = secondsSince(t0);
+    }
+
+    SearchScratch scratch;
+    vector<Point> path;
+    size_t found = 0;
+    double tQueries = 0;
+    for (size_t q = 0; q < scene.starts.size(); q++) {
+        t0 = chrono::steady_clock::now();
+        PathStatus status = taut
+            ? PathComputer::queryTautPath(map, roadMap, scene.starts[q], scene.goals[q], scratch, path)
+            : PathComputer::queryPath(map, roadMap, scene.starts[q], scene.goals[q], scratch, path,
+                                      algorithm, &landmarks);
+        tQueries += secondsSince(t0);
+
+        if (status == PATH_FOUND) found++;
+        cout << "query " << q << " " << statusName(status);
+        if (status == PATH_FOUND) {
+            cout << " " << path.size() << " points, length " << pathLength(path);
+            if (printPaths) {
+                cout << ":";
+                for (const Point& p : path) cout << " " << p.x << "," << p.y;
+            }
+        }
+        cout << '\n';
+    }
+
+    size_t m = scene.starts.size();
+    cout << "obstacles " << scene.obstacles.size() << ", free trapezoids " << map.trapezoids.size()
+         << ", roadmap " << roadMap.nodeCount() << " nodes / " << roadMap.edgeCount() << " edges"
+         << endl;
+    cout << "paths found " << found << "/" << m << " (" << mode << ")" << endl;
+    cout << "load scene   " << tLoad * 1e3 << " ms" << endl;
+    cout << "free space   " << tFreeSpace * 1e3 << " ms" << endl;
+    cout << "roadmap      " << tRoadMap * 1e3 << " ms" << endl;
+    if (algorithm == SEARCH_ALT) cout << "landmarks    " << tLandmarks * 1e3 << " ms" << endl;
+    cout << "queries      " << tQueries * 1e3 << " ms";
+    if (m > 0) cout << ", " << tQueries / m * 1e6 << " us per query";
+    cout << endl;
+
+    map.cleanup();
+    return 0;
+}
+
+// Best of runs for each pipeline stage at one input size
+struct StageTimes {
+    size_t edges, obstacles, trapezoids, freeTrapezoids, roadMapNodes, roadMapEdges, pathsFound;
+    double build, removeInterior, roadMap, path;    // seconds; path is per query
+};
+
+static StageTimes timeStages(const Scene& scene, unsigned seed, int runs) {
+    StageTimes t;
+    t.build = t.removeInterior = t.roadMap = t.path = INFINITY;
+    for (int r = 0; r < runs; r++) {
+        auto t0 = chrono::steady_clock::now();
+        vector<Segment> edges = FreeSpaceComputer::extractEdges(scene.obstacles);
+        TrapezoidalMap map = BuildTrapezoidalMap(edges, seed);
+        t.build = min(t.build, secondsSince(t0));
+        t.edges = edges.size();
+        t.trapezoids = map.trapezoids.size();
+
+        t0 = chrono::steady_clock::now();
+        FreeSpaceComputer::removeInteriorTrapezoids(map);
+        t.removeInterior = min(t.removeInterior, secondsSince(t0));
+        t.freeTrapezoids = map.trapezoids.size();
+
+        t0 = chrono::steady_clock::now();
+        RoadMap roadMap = PathComputer::buildRoadMap(map);
+        t.roadMap = min(t.roadMap, secondsSince(t0));
+        t.roadMapNodes = roadMap.nodeCount();
+        t.roadMapEdges = roadMap.edgeCount();
+
+        t.pathsFound = 0;
+        t0 = chrono::steady_clock::now();
+        for (size_t q = 0; q < scene.starts.size(); q++) {
+            vector<Point> path = PathComputer::COMPUTEPATH(map, roadMap, scene.starts[q], scene.goals[q]);
+            if (!path.empty()) t.pathsFound++;
+        }
+        if (!scene.starts.empty()) t.path = min(t.path, secondsSince(t0) / scene.starts.size());
+        map.cleanup();
+    }
+    t.obstacles = scene.obstacles.size();
+    if (scene.starts.empty()) t.path = 0;
+    return t;
+}
+
+// Sizes 10, 30, 100, 300, ... up to maxEdges, one line or object per size
+static int runBenchmark(size_t maxEdges, const string& format, size_t queries, unsigned seed) {
+    bool json = (format == "json");
+    if (!json && format != "csv") return usage();
+    // COMPUTEPATH reports queries that start or end in an obstacle as errors
+    trace::setLevel(TRACE_LEVEL_OFF);
+
+    vector<size_t> sizes;
+    for (size_t decade = 10; decade <= maxEdges; decade *= 10) {
+        sizes.push_back(decade);
+        if (3 * decade <= maxEdges) sizes.push_back(3 * decade);
+    }
+
+    if (json) {
+        cout << "[" << endl;
+    } else {
+        cout << "edges,obstacles,trapezoids,free_trapezoids,roadmap_nodes,roadmap_edges,"
+             << "build_ms,remove_interior_ms,roadmap_ms,path_us,paths_found,queries" << endl;
+    }
+    for (size_t i = 0; i < sizes.size(); i++) {
+        SceneParameters parameters;
+        parameters.edges = sizes[i];
+        parameters.queries = queries;
+        parameters.seed = seed;
+        Scene scene = generateScene(parameters);
+        // Small inputs finish in microseconds; repeat them to get past the noise
+        int runs = sizes[i] <= 10000 ? 5 : 1;
+        StageTimes t = timeStages(scene, seed, runs);
+
+        if (json) {
+            cout << "  {\"edges\": " << t.edges << ", \"obstacles\": " << t.obstacles
+                 << ", \"trapezoids\": " << t.trapezoids << ", \"free_trapezoids\": " << t.freeTrapezoids
+                 << ", \"roadmap_nodes\": " << t.roadMapNodes << ", \"roadmap_edges\": " << t.roadMapEdges
+                 << ", \"build_ms\": " << t.build * 1e3
+                 << ", \"remove_interior_ms\": " << t.removeInterior * 1e3
+                 << ", \"roadmap_ms\": " << t.roadMap * 1e3 << ", \"path_us\": " << t.path * 1e6
+                 << ", \"paths_found\": " << t.pathsFound << ", \"queries\": " << queries << "}"
+                 << (i + 1 < sizes.size() ? "," : "") << endl;
+        } else {
+            cout << t.edges << "," << t.obstacles << "," << t.trapezoids << "," << t.freeTrapezoids << ","
+                 << t.roadMapNodes << "," << t.roadMapEdges << "," << t.build * 1e3 << ","
+                 << t.removeInterior * 1e3 << "," << t.roadMap * 1e3 << "," << t.path * 1e6 << ","
+                 << t.pathsFound << "," << queries << endl;
+        }
+    }
+    if (json) cout << "]" << endl;
+    return 0;
+}
+
+int headless_main(int argc, char** argv) {
+    if (argc < 2) return usage();
+    // Results go to stdout; only problems are traced
+    trace::setLevel(TRACE_LEVEL_WARN);
+
+    string command = argv[1];
+    if (command == "bench") {
+        size_t maxEdges = argc > 2 ? strtoul(argv[2], NULL, 10) : 100000;
+        string format = argc > 3 ? argv[3] : "csv";
+        size_t queries = argc > 4 ? strtoul(argv[4], NULL, 10) : 100;
+        unsigned seed = argc > 5 ? static_cast<unsigned>(strtoul(argv[5], NULL, 10)) : 1;
+        return runBenchmark(maxEdges, format, queries, seed);
+    }
+    if (argc < 3) return usage();
+    if (command == "convert") {
+        return argc == 4 ? convertScene(argv[2], argv[3]) : usage();
+    }
+    if (command != "run") return usage();
+
+    string mode = "astar";
+    bool printPaths = false;
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--paths") {
+            printPaths = true;
+        } else {
+            mode = arg;
+        }
+    }
+
+    return runScene(argv[2], mode, printPaths);
+}
@@ -0,0 +1,225 @@
+#include "landmarks.hpp"
+#include "indexed_heap.hpp"
+#include "trace.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+using namespace std;
+
+static const char TRACE_MODULE[] = "landmarks";
+
+static const char LANDMARK_MAGIC[4] = {'T', 'M', 'L', 'T'};
+static const uint32_t LANDMARK_VERSION = 1;
+
+uint64_t fingerprintRoadMap(const RoadMap& roadMap) {
+    // FNV-1a over the raw arrays
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void* data, size_t bytes) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < bytes; i++) {
+            h = (h ^ p[i]) * 1099511628211ull;
+        }
+    };
+    uint64_t n = roadMap.nodeCount();
+    mix(&n, sizeof(n));
+    mix(roadMap.rowBegin.data(), roadMap.rowBegin.size() * sizeof(uint32_t));
+    mix(roadMap.rowEnd.data(), roadMap.rowEnd.size() * sizeof(uint32_t));
+    mix(roadMap.neighbors.data(), roadMap.neighbors.size() * sizeof(uint32_t));
+    mix(roadMap.lengths.data(), roadMap.lengths.size() * sizeof(double));
+    return h;
+}
+
+bool LandmarkTable::matches(const RoadMap& roadMap) const {
+    return nodeCount == roadMap.nodeCount() && roadMapFingerprint == fingerprintRoadMap(roadMap);
+}
+
+// Dijkstra from source over the whole roadmap. Nodes it does not reach are
+// left at INFINITY in dist. pushed marks the nodes queued so far; both
+// arrays hold nodeCount entries and are reset here. Edges whose length is
+// not finite are never taken: buildRoadMap does not make them, and one
+// would leave its far end at INFINITY however often it was queued.
+static void shortestDistances(const RoadMap& roadMap, uint32_t source,
+                              vector<double>& dist, vector<uint8_t>& pushed,
+                              IndexedHeap& heap) {
+    const uint32_t* rowBegin = roadMap.rowBegin.data();
+    const uint32_t* rowEnd = roadMap.rowEnd.data();
+    const uint32_t* neighbors = roadMap.neighbors.data();
+    const double* lengths = roadMap.lengths.data();
+
+    fill(dist.begin(), dist.end(), INFINITY);
+    fill(pushed.begin(), pushed.end(), 0);
+    heap.clear();
+    dist[source] = 0;
+    pushed[source] = 1;
+    heap.push(source, 0);
+    size_t skipped = 0;
+    while (!heap.empty()) {
+        uint32_t current = heap.pop();
+        for (uint32_t e = rowBegin[current]; e < rowEnd[current]; e++) {
+            if (!isfinite(lengths[e])) {
+                skipped++;
+                continue;
+            }
+            uint32_t neighbor = neighbors[e];
+            double d = dist[current] + lengths[e];
+            if (!pushed[neighbor]) {
+                pushed[neighbor] = 1;
+                dist[neighbor] = d;
+                heap.push(neighbor, d);
+            } else if (!heap.closed(neighbor) && d < dist[neighbor]) {
+                dist[neighbor] = d;
+                heap.decreaseKey(neighbor, d);
+            }
+        }
+    }
+    if (skipped) TRACE_WARN("Skipped " << skipped << " roadmap edges of non-finite length");
+}
+
+// Some node of the largest connected component
+static uint32_t largestComponentNode(const RoadMap& roadMap) {
+    vector<uint32_t> size(roadMap.componentCount, 0);
+    for (uint32_t label : roadMap.component) {
+        if (label != ROADMAP_NONE) size[label]++;
+    }
+    uint32_t largest = static_cast<uint32_t>(max_element(size.begin(), size.end()) - size.begin());
+    return static_cast<uint32_t>(find(roadMap.component.begin(), roadMap.component.end(), largest)
+                                 - roadMap.component.begin());
+}
+
+LandmarkTable buildLandmarkTable(const RoadMap& roadMap, size_t count) {
+    auto t0 = chrono::steady_clock::now();
+
+    LandmarkTable table;
+    size_t n = roadMap.nodeCount();
+    table.nodeCount = static_cast<uint32_t>(n);
+    table.roadMapFingerprint = fingerprintRoadMap(roadMap);
+    if (n == 0 || count == 0) return table;
+    if (count > n) count = n;
+
+    IndexedHeap heap;
+    heap.resize(n);
+    vector<double> dist(n);
+    vector<uint8_t> pushed(n);
+    vector<vector<double>> columns;
+
+    // Landmarks all go into the largest component; pockets cut off by
+    // obstacles are small and searches there keep the straight-line bound.
+    // The first one is the node farthest from some node of the component,
+    // so it already sits on the periphery.
+    uint32_t root = largestComponentNode(roadMap);
+    shortestDistances(roadMap, root, dist, pushed, heap);
+    uint32_t next = root;
+    for (uint32_t v = 0; v < n; v++) {
+        if (dist[v] != INFINITY && dist[v] > dist[next]) next = v;
+    }
+
+    // Distance from each node to the nearest landmark chosen so far
+    vector<double> nearest(n, INFINITY);
+    while (table.landmarks.size() < count) {
+        table.landmarks.push_back(next);
+        shortestDistances(roadMap, next, dist, pushed, heap);
+        columns.push_back(dist);
+
+        double best = 0;
+        for (uint32_t v = 0; v < n; v++) {
+            if (dist[v] < nearest[v]) nearest[v] = dist[v];
+            if (nearest[v] != INFINITY && nearest[v] > best) {
+                best = nearest[v];
+                next = v;
+            }
+        }
+        if (best == 0) break;       // every node of the component is a landmark
+    }
+
+    // Node-major, so a heuristic evaluation reads one contiguous row
+    size_t k = table.count();
+    table.distances.resize(n * k);
+    for (size_t j = 0; j < k; j++) {
+        for (size_t v = 0; v < n; v++) {
+            table.distances[v * k + j] = columns[j][v];
+        }
+    }
+
+    [[maybe_unused]] double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    TRACE_INFO("Landmark table: " << k << " landmarks over " << n << " nodes in "
+               << seconds << " s");
+    return table;
+}
+
+bool saveLandmarkTable(const LandmarkTable& table, const char* filename) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) {
+        TRACE_ERROR("Cannot open " << filename << " for writing");
+        return false;
+    }
+    uint32_t k = static_cast<uint32_t>(table.count());
+    bool ok = fwrite(LANDMARK_MAGIC, 1, 4, f) == 4
+        && fwrite(&LANDMARK_VERSION, sizeof(uint32_t), 1, f) == 1
+        && fwrite(&table.roadMapFingerprint, sizeof(uint64_t), 1, f) == 1
+        && fwrite(&table.nodeCount, sizeof(uint32_t), 1, f) == 1
+        && fwrite(&k, sizeof(uint32_t), 1, f) == 1
+        && fwrite(table.landmarks.data(), sizeof(uint32_t), k, f) == k
+        && fwrite(table.distances.data(), sizeof(double), table.distances.size(), f)
+               == table.distances.size();
+    if (fclose(f) != 0) ok = false;
+    if (!ok) TRACE_ERROR("Failed to write landmark table to " << filename);
+    return ok;
+}
+
+bool loadLandmarkTable(LandmarkTable& table, const char* filename) {
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        TRACE_ERROR("Cannot open " << filename);
+        return false;
+    }
+    // The counts in the header have to account for every byte after it,
+    // so a corrupt header is refused before anything is allocated
+    long fileSize = -1;
+    if (fseek(f, 0, SEEK_END) == 0) fileSize = ftell(f);
+    bool ok = fileSize >= 0 && fseek(f, 0, SEEK_SET) == 0;
+
+    LandmarkTable loaded;
+    char magic[4];
+    uint32_t version = 0, k = 0;
+    ok = ok && fread(magic, 1, 4, f) == 4 && memcmp(magic, LANDMARK_MAGIC, 4) == 0
+        && fread(&version, sizeof(uint32_t), 1, f) == 1 && version == LANDMARK_VERSION
+        && fread(&loaded.roadMapFingerprint, sizeof(uint64_t), 1, f) == 1
+        && fread(&loaded.nodeCount, sizeof(uint32_t), 1, f) == 1
+        && fread(&k, sizeof(uint32_t), 1, f) == 1
+        && k <= loaded.nodeCount;
+    if (ok) {
+        // k * 4 + nodeCount * k * 8 bytes, checked by division since the
+        // product may not fit in 64 bits
+        uint64_t rest = static_cast<uint64_t>(fileSize) - static_cast<uint64_t>(ftell(f));
+        uint64_t landmarkBytes = static_cast<uint64_t>(k) * sizeof(uint32_t);
+        ok = rest >= landmarkBytes && (rest - landmarkBytes) % sizeof(double) == 0;
+        if (ok) {
+            uint64_t cellCount = (rest - landmarkBytes) / sizeof(double);
+            ok = (k == 0) ? cellCount == 0
+                          : cellCount % k == 0 && cellCount / k == loaded.nodeCount;
+        }
+    }
+    if (ok) {
+        size_t cells = static_cast<size_t>(loaded.nodeCount) * k;
+        loaded.landmarks.resize(k);
+        loaded.distances.resize(cells);
+        ok = fread(loaded.landmarks.data(), sizeof(uint32_t), k, f) == k
+            && fread(loaded.distances.data(), sizeof(double), cells, f) == cells
+            && fgetc(f) == EOF;
+        for (uint32_t j = 0; ok && j < k; j++) {
+            ok = loaded.landmarks[j] < loaded.nodeCount;
+        }
+    }
+    fclose(f);
+    if (!ok) {
+        TRACE_ERROR(filename << " is not a landmark table");
+        return false;
+    }
+    table = std::move(loaded);
+    return true;
+}
@@ -2,13 +2,22 @@
 #include "demo/compute_free_space_demo.hpp"
 #include "demo/compute_path_demo.hpp"
 #include "demo/minkowski_sum_demo.hpp"
+#include "headless.hpp"
+#include "trace.hpp"
 #include <iostream>
 #include <string>
 
 using namespace std;
 
 int main(int argc, char** argv) {
+    // Scene files and benchmarks run without opening a window
+    if (argc >= 2 && (string(argv[1]) == "run" || string(argv[1]) == "convert" ||
+                      string(argv[1]) == "bench")) {
+        return headless_main(argc, argv);
+    }
     if (argc == 2) {
+        // The demos narrate each step of the algorithms
+        trace::setLevel(TRACE_LEVEL_INFO);
         string arg = argv[1];
         if (arg == "trap") {
             trapezoidal_map_demo();
@@ -0,0 +1,289 @@
+#include "map_snapshot.hpp"
+#include "trace.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char TRACE_MODULE[] = "map_snapshot";
+
+static const char SNAPSHOT_MAGIC[4] = {'T', 'M', 'S', 'N'};
+static const uint32_t SNAPSHOT_VERSION = 2;
+// Reads back as 0x04030201 on a machine of the other byte order
+static const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304u;
+
+// Records are read in place, so their layout is part of the format
+static_assert(sizeof(FrozenXNode) == 24, "FrozenXNode layout changed");
+static_assert(sizeof(FrozenYNode) == 40, "FrozenYNode layout changed");
+static_assert(sizeof(SnapshotTrapezoid) == 64, "SnapshotTrapezoid layout changed");
+static_assert(sizeof(SnapshotSegment) == 40, "SnapshotSegment layout changed");
+static_assert(sizeof(Point) == 2 * sizeof(double), "Point layout changed");
+
+static size_t alignUp(size_t offset) {
+    return (offset + 7) & ~static_cast<size_t>(7);
+}
+
+// Collects the sections in memory so the header can be filled in first
+struct SnapshotWriter {
+    vector<char> bytes;
+
+    SnapshotWriter() : bytes(sizeof(SnapshotHeader), 0) {}
+
+    template <typename T>
+    SnapshotSection add(const T* data, size_t count) {
+        SnapshotSection s;
+        s.offset = alignUp(bytes.size());
+        s.count = count;
+        bytes.resize(s.offset + count * sizeof(T), 0);
+        if (count > 0) memcpy(&bytes[s.offset], data, count * sizeof(T));
+        return s;
+    }
+};
+
+bool saveMapSnapshot(const TrapezoidalMap& map, const RoadMap& roadMap, const char* filename) {
+    FrozenSearchStructure fs = freezeSearchStructure(map);
+
+    unordered_map<const Trapezoid*, uint32_t> trapIndex;
+    for (size_t i = 0; i < fs.trapezoids.size(); i++) {
+        trapIndex[fs.trapezoids[i]] = static_cast<uint32_t>(i);
+    }
+    auto indexOf = [&trapIndex](const Trapezoid* t) {
+        auto it = trapIndex.find(t);
+        return it == trapIndex.end() ? FROZEN_NONE : it->second;
+    };
+
+    vector<const Segment*> segmentList(map.segments.begin(), map.segments.end());
+    unordered_map<const Segment*, uint32_t> segIndex;
+    for (size_t i = 0; i < segmentList.size(); i++) {
+        segIndex[segmentList[i]] = static_cast<uint32_t>(i);
+    }
+    auto segmentOf = [&](const Segment* s) {
+        auto it = segIndex.find(s);
+        if (it != segIndex.end()) return it->second;
+        uint32_t index = static_cast<uint32_t>(segmentList.size());
+        segIndex[s] = index;
+        segmentList.push_back(s);
+        return index;
+    };
+
+    vector<SnapshotTrapezoid> traps(fs.trapezoids.size());
+    for (size_t i = 0; i < fs.trapezoids.size(); i++) {
+        const Trapezoid* t = fs.trapezoids[i];
+        SnapshotTrapezoid& r = traps[i];
+        r.leftX = t->leftp.x;
+        r.leftY = t->leftp.y;
+        r.rightX = t->rightp.x;
+        r.rightY = t->rightp.y;
+        r.top = t->top ? segmentOf(t->top) : FROZEN_NONE;
+        r.bottom = t->bottom ? segmentOf(t->bottom) : FROZEN_NONE;
+        r.upperLeft = indexOf(t->upperLeft);
+        r.lowerLeft = indexOf(t->lowerLeft);
+        r.upperRight = indexOf(t->upperRight);
+        r.lowerRight = indexOf(t->lowerRight);
+        r.flags = map.contains(t) ? SNAPSHOT_FREE : 0;
+        r.roadNode = r.flags ? roadMap.getNodeForTrapezoid(t) : ROADMAP_NONE;
+    }
+
+    vector<SnapshotSegment> segments(segmentList.size());
+    for (size_t i = 0; i < segmentList.size(); i++) {
+        const Segment* s = segmentList[i];
+        Point left = s->getLeftEndpoint();
+        Point right = s->getRightEndpoint();
+        SnapshotSegment& r = segments[i];
+        r.x1 = left.x;
+        r.y1 = left.y;
+        r.x2 = right.x;
+        r.y2 = right.y;
+        r.polygonIndex = s->polygonIndex;
+        r.unused = 0;
+    }
+
+    vector<uint32_t> nodeTrapezoid(roadMap.nodeCount());
+    for (size_t i = 0; i < nodeTrapezoid.size(); i++) {
+        const Trapezoid* t = roadMap.nodeTrapezoid[i];
+        nodeTrapezoid[i] = t ? indexOf(t) : FROZEN_NONE;
+    }
+
+    SnapshotWriter w;
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.componentCount = roadMap.componentCount;
+    header.root = fs.root;
+    header.xNodes = w.add(fs.xNodes.data(), fs.xNodes.size());
+    header.yNodes = w.add(fs.yNodes.data(), fs.yNodes.size());
+    header.trapezoids = w.add(traps.data(), traps.size());
+    header.segments = w.add(segments.data(), segments.size());
+    header.positions = w.add(roadMap.positions.data(), roadMap.positions.size());
+    header.rowBegin = w.add(roadMap.rowBegin.data(), roadMap.rowBegin.size());
+    header.rowEnd = w.add(roadMap.rowEnd.data(), roadMap.rowEnd.size());
+    header.neighbors = w.add(roadMap.neighbors.data(), roadMap.neighbors.size());
+    header.lengths = w.add(roadMap.lengths.data(), roadMap.lengths.size());
+    header.component = w.add(roadMap.component.data(), roadMap.component.size());
+    header.nodeTrapezoid = w.add(nodeTrapezoid.data(), nodeTrapezoid.size());
+    header.fileSize = w.bytes.size();
+    memcpy(&w.bytes[0], &header, sizeof(header));
+
+    FILE* f = fopen(filename, "wb");
+    if (!f) {
+        TRACE_ERROR("Cannot open " << filename << " for writing");
+        return false;
+    }
+    bool ok = fwrite(w.bytes.data(), 1, w.bytes.size(), f) == w.bytes.size();
+    if (fclose(f) != 0) ok = false;
+    if (!ok) {
+        TRACE_ERROR("Failed to write map snapshot to " << filename);
+        return false;
+    }
+    TRACE_INFO("Map snapshot: " << fs.nodeCount() << " nodes, " << traps.size()
+               << " trapezoids, " << roadMap.nodeCount() << " roadmap nodes, "
+               << w.bytes.size() << " bytes");
+    return true;
+}
+
+MapSnapshot::MapSnapshot()
+    : xNodes(NULL), yNodes(NULL), root(FROZEN_NONE), trapezoids(NULL), trapezoidCount(0),
+      segments(NULL), segmentCount(0), nodeTrapezoid(NULL), componentCount(0),
+      mapping(NULL), mappingSize(0) {
+    memset(&roadMap, 0, sizeof(roadMap));
+}
+
+MapSnapshot::~MapSnapshot() {
+    closeMapSnapshot(*this);
+}
+
+// Does section s of elements of elementSize bytes lie inside the file?
+static bool sectionFits(const SnapshotSection& s, size_t elementSize, uint64_t fileSize) {
+    if (s.offset % 8 != 0 || s.offset < sizeof(SnapshotHeader) || s.offset > fileSize) {
+        return false;
+    }
+    return s.count <= (fileSize - s.offset) / elementSize;
+}
+
+template <typename T>
+static const T* sectionData(const char* base, const SnapshotSection& s) {
+    return reinterpret_cast<const T*>(base + s.offset);
+}
+
+bool openMapSnapshot(MapSnapshot& snapshot, const char* filename) {
+    closeMapSnapshot(snapshot);
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        TRACE_ERROR("Cannot open " << filename);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        close(fd);
+        TRACE_ERROR(filename << " is not a map snapshot");
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        TRACE_ERROR("Cannot map " << filename);
+        return false;
+    }
+
+    const char* base = static_cast<const char*>(mapping);
+    const SnapshotHeader& h = *reinterpret_cast<const SnapshotHeader*>(base);
+    uint64_t n = h.positions.count;
+    bool ok = memcmp(h.magic, SNAPSHOT_MAGIC, 4) == 0
+        && h.version == SNAPSHOT_VERSION
+        && h.byteOrder == SNAPSHOT_BYTE_ORDER
+        && h.fileSize == size
+        && sectionFits(h.xNodes, sizeof(FrozenXNode), size)
+        && sectionFits(h.yNodes, sizeof(FrozenYNode), size)
+        && sectionFits(h.trapezoids, sizeof(SnapshotTrapezoid), size)
+        && sectionFits(h.segments, sizeof(SnapshotSegment), size)
+        && sectionFits(h.positions, sizeof(Point), size)
+        && sectionFits(h.rowBegin, sizeof(uint32_t), size) && h.rowBegin.count == n
+        && sectionFits(h.rowEnd, sizeof(uint32_t), size) && h.rowEnd.count == n
+        && sectionFits(h.neighbors, sizeof(uint32_t), size)
+        && sectionFits(h.lengths, sizeof(double), size) && h.lengths.count == h.neighbors.count
+        && sectionFits(h.component, sizeof(uint32_t), size) && h.component.count == n
+        && sectionFits(h.nodeTrapezoid, sizeof(uint32_t), size) && h.nodeTrapezoid.count == n;
+    if (!ok) {
+        munmap(mapping, size);
+        TRACE_ERROR(filename << " is not a map snapshot");
+        return false;
+    }
+
+    snapshot.mapping = mapping;
+    snapshot.mappingSize = size;
+    snapshot.xNodes = sectionData<FrozenXNode>(base, h.xNodes);
+    snapshot.yNodes = sectionData<FrozenYNode>(base, h.yNodes);
+    snapshot.root = h.root;
+    snapshot.trapezoids = sectionData<SnapshotTrapezoid>(base, h.trapezoids);
+    snapshot.trapezoidCount = h.trapezoids.count;
+    snapshot.segments = sectionData<SnapshotSegment>(base, h.segments);
+    snapshot.segmentCount = h.segments.count;
+    snapshot.roadMap.nodeCount = n;
+    snapshot.roadMap.positions = sectionData<Point>(base, h.positions);
+    snapshot.roadMap.rowBegin = sectionData<uint32_t>(base, h.rowBegin);
+    snapshot.roadMap.rowEnd = sectionData<uint32_t>(base, h.rowEnd);
+    snapshot.roadMap.neighbors = sectionData<uint32_t>(base, h.neighbors);
+    snapshot.roadMap.lengths = sectionData<double>(base, h.lengths);
+    snapshot.roadMap.component = sectionData<uint32_t>(base, h.component);
+    snapshot.nodeTrapezoid = sectionData<uint32_t>(base, h.nodeTrapezoid);
+    snapshot.componentCount = h.componentCount;
+    return true;
+}
+
+void closeMapSnapshot(MapSnapshot& snapshot) {
+    if (snapshot.mapping) munmap(snapshot.mapping, snapshot.mappingSize);
+    snapshot.mapping = NULL;
+    snapshot.mappingSize = 0;
+    snapshot.xNodes = NULL;
+    snapshot.yNodes = NULL;
+    snapshot.root = FROZEN_NONE;
+    snapshot.trapezoids = NULL;
+    snapshot.trapezoidCount = 0;
+    snapshot.segments = NULL;
+    snapshot.segmentCount = 0;
+    memset(&snapshot.roadMap, 0, sizeof(snapshot.roadMap));
+    snapshot.nodeTrapezoid = NULL;
+    snapshot.componentCount = 0;
+}
+
+uint32_t locateInSnapshot(const MapSnapshot& snapshot, const Point& p) {
+    uint32_t index = queryFrozenNodes(snapshot.xNodes, snapshot.yNodes, snapshot.root, p);
+    return index < snapshot.trapezoidCount ? index : FROZEN_NONE;
+}
+
+PathStatus querySnapshotPath(const MapSnapshot& snapshot,
+                             const Point& pstart,
+                             const Point& pgoal,
+                             SearchScratch& scratch,
+                             vector<Point>& path,
+                             SearchAlgorithm algorithm,
+                             const LandmarkTable* landmarks) {
+    path.clear();
+    scratch.expanded = 0;
+
+    uint32_t delta_start = locateInSnapshot(snapshot, pstart);
+    uint32_t delta_goal = locateInSnapshot(snapshot, pgoal);
+
+    if (delta_start == FROZEN_NONE || !(snapshot.trapezoids[delta_start].flags & SNAPSHOT_FREE)) {
+        return PATH_START_BLOCKED;
+    }
+    if (delta_goal == FROZEN_NONE || !(snapshot.trapezoids[delta_goal].flags & SNAPSHOT_FREE)) {
+        return PATH_GOAL_BLOCKED;
+    }
+
+    return PathComputer::queryRoadMapPath(snapshot.roadMap,
+                                          snapshot.trapezoids[delta_start].roadNode,
+                                          snapshot.trapezoids[delta_goal].roadNode,
+                                          pstart, pgoal, scratch, path, algorithm, landmarks);
+}
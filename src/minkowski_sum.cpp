@@ -1,20 +1,18 @@
 #include "minkowski_sum.hpp"
+#include "parallel_for.hpp"
+#include "trace.hpp"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <unordered_map>
 using namespace std;
 
-Polygon MinkowskiSum::MINKOWSKISUM(const Polygon& P, const Polygon& Q) {
-    cout << "=== MINKOWSKI SUM ===" << endl;
-
-    if (P.vertices.size() < 3 || Q.vertices.size() < 3) {
-        cerr << "ERROR: Input polygons must have at least 3 vertices" << endl;
-        return Polygon();
-    }
-
-    Polygon A = P;
-    Polygon B = Q;
+static const char TRACE_MODULE[] = "minkowski_sum";
 
+// The edge merge itself, without the traces, for MINKOWSKISUM and the pieces
+// of MINKOWSKISUMNONCONVEX
+static void convexSum(const Polygon& A, const Polygon& B, Polygon& R) {
     auto lowestVertexIndex = [](const Polygon& poly) {
         int idx = 0;
         for (int i = 1; i < (int)poly.vertices.size(); i++) {
@@ -32,7 +30,7 @@ Polygon MinkowskiSum::MINKOWSKISUM(const Polygon& P, const Polygon& Q) {
     int n = A.vertices.size();
     int m = B.vertices.size();
 
-    Polygon R;
+    R.vertices.clear();
     R.vertices.reserve(n + m);
 
     int i = ia, j = ib;
@@ -60,10 +58,33 @@ Polygon MinkowskiSum::MINKOWSKISUM(const Polygon& P, const Polygon& Q) {
 
     } while (i != ia || j != ib);
 
-    cout << "Resulting polygon has " << R.vertices.size() << " vertices" << endl;
+    // The walk ends back on the first vertex; a repeat would be a zero-length edge
+    R.vertices.pop_back();
+}
+
+Polygon MinkowskiSum::MINKOWSKISUM(const Polygon& P, const Polygon& Q) {
+    TRACE_INFO("=== MINKOWSKI SUM ===");
+
+    if (P.vertices.size() < 3 || Q.vertices.size() < 3) {
+        TRACE_ERROR("Input polygons must have at least 3 vertices");
+        return Polygon();
+    }
+
+    Polygon R;
+    convexSum(P, Q, R);
+
+    TRACE_INFO("Resulting polygon has " << R.vertices.size() << " vertices");
     return R;
 }
 
+void MinkowskiSum::MINKOWSKISUM(const Polygon& P, const Polygon& Q, Polygon& out) {
+    if (P.vertices.size() < 3 || Q.vertices.size() < 3) {
+        out.vertices.clear();
+        return;
+    }
+    convexSum(P, Q, out);
+}
+
 void MinkowskiSum::normalizePolygon(Polygon& poly) {
     if (poly.vertices.empty()) return;
     
@@ -101,3 +122,228 @@ void MinkowskiSum::normalizePolygon(Polygon& poly) {
     }
 }
 
+
+// Twice the signed area of abc; positive when abc turns left
+static double turn(const Point& a, const Point& b, const Point& c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+static const double TURN_EPSILON = 1e-12;
+
+// Every vertex of the (counter-clockwise) index polygon turns left or goes
+// straight on
+static bool isConvex(const vector<Point>& v, const vector<int>& poly) {
+    size_t k = poly.size();
+    for (size_t i = 0; i < k; i++) {
+        if (turn(v[poly[i]], v[poly[(i + 1) % k]], v[poly[(i + 2) % k]]) < -TURN_EPSILON) return false;
+    }
+    return true;
+}
+
+static bool inTriangle(const Point& a, const Point& b, const Point& c, const Point& p) {
+    return turn(a, b, p) >= -TURN_EPSILON && turn(b, c, p) >= -TURN_EPSILON &&
+           turn(c, a, p) >= -TURN_EPSILON;
+}
+
+// Ear clipping over a counter-clockwise polygon; triangles as index triples.
+// The ring is a linked list with an ear flag per vertex. Clipping an ear
+// only changes the triangles of its two neighbours, so only their flags are
+// tested again. An ear test looks for reflex vertices inside the triangle in
+// the cells of a uniform grid its bounding box covers, so obstacles whose
+// ears are small next to the whole polygon triangulate in about O(n).
+static vector<vector<int>> triangulate(const vector<Point>& v) {
+    int n = static_cast<int>(v.size());
+    vector<int> prev(n), next(n);
+    for (int i = 0; i < n; i++) {
+        prev[i] = (i + n - 1) % n;
+        next[i] = (i + 1) % n;
+    }
+    // Only reflex vertices can lie inside a convex corner's triangle, and
+    // clipping never makes a convex vertex reflex
+    vector<char> reflex(n);
+    size_t reflexCount = 0;
+    double minX = v[0].x, maxX = v[0].x, minY = v[0].y, maxY = v[0].y;
+    for (int i = 0; i < n; i++) {
+        reflex[i] = turn(v[prev[i]], v[i], v[next[i]]) <= TURN_EPSILON;
+        reflexCount += reflex[i];
+        minX = min(minX, v[i].x);
+        maxX = max(maxX, v[i].x);
+        minY = min(minY, v[i].y);
+        maxY = max(maxY, v[i].y);
+    }
+
+    // About one reflex vertex per cell; vertices that turn convex stay in
+    // their cell and are skipped by the flag
+    int side = max(1, static_cast<int>(sqrt(static_cast<double>(reflexCount))));
+    double cellW = (maxX - minX) / side + 1e-12, cellH = (maxY - minY) / side + 1e-12;
+    auto column = [&](double x) { return min(side - 1, max(0, static_cast<int>((x - minX) / cellW))); };
+    auto row = [&](double y) { return min(side - 1, max(0, static_cast<int>((y - minY) / cellH))); };
+    vector<vector<int>> cells(static_cast<size_t>(side) * side);
+    for (int i = 0; i < n; i++) {
+        if (reflex[i]) cells[static_cast<size_t>(row(v[i].y)) * side + column(v[i].x)].push_back(i);
+    }
+
+    auto isEar = [&](int i) {
+        if (reflex[i]) return false;
+        const Point& a = v[prev[i]];
+        const Point& b = v[i];
+        const Point& c = v[next[i]];
+        int c0 = column(min(a.x, min(b.x, c.x))), c1 = column(max(a.x, max(b.x, c.x)));
+        int r0 = row(min(a.y, min(b.y, c.y))), r1 = row(max(a.y, max(b.y, c.y)));
+        for (int r = r0; r <= r1; r++) {
+            for (int col = c0; col <= c1; col++) {
+                for (int j : cells[static_cast<size_t>(r) * side + col]) {
+                    if (!reflex[j] || j == prev[i] || j == next[i]) continue;
+                    const Point& p = v[j];
+                    if (p.equals(a) || p.equals(b) || p.equals(c)) continue;
+                    if (inTriangle(a, b, c, p)) return false;
+                }
+            }
+        }
+        return true;
+    };
+    auto update = [&](int i) {
+        if (reflex[i] && turn(v[prev[i]], v[i], v[next[i]]) > TURN_EPSILON) reflex[i] = 0;
+    };
+    vector<char> ear(n);
+    for (int i = 0; i < n; i++) ear[i] = isEar(i);
+
+    vector<vector<int>> triangles;
+    int remaining = n, current = 0, misses = 0;
+    while (remaining > 3) {
+        if (!ear[current] && misses < remaining) {
+            current = next[current];
+            misses++;
+            continue;
+        }
+        if (misses >= remaining) {
+            // Only when the polygon is not simple or is degenerate
+            TRACE_WARN("No ear left among " << remaining << " vertices; clipping a corner anyway");
+        }
+        int a = prev[current], c = next[current];
+        triangles.push_back({a, current, c});
+        next[a] = c;
+        prev[c] = a;
+        reflex[current] = 0;
+        update(a);
+        update(c);
+        ear[a] = isEar(a);
+        ear[c] = isEar(c);
+        remaining--;
+        misses = 0;
+        current = a;
+    }
+    triangles.push_back({prev[current], current, next[current]});
+    return triangles;
+}
+
+vector<Polygon> MinkowskiSum::convexDecomposition(const Polygon& P) {
+    vector<Polygon> result;
+    if (P.vertices.size() < 3) return result;
+
+    Polygon ccw = P;
+    normalizePolygon(ccw);
+    const vector<Point>& v = ccw.vertices;
+    int n = static_cast<int>(v.size());
+
+    vector<int> all(n);
+    for (int i = 0; i < n; i++) all[i] = i;
+    if (isConvex(v, all)) {
+        result.push_back(ccw);
+        return result;
+    }
+
+    vector<vector<int>> pieces = triangulate(v);
+    vector<char> alive(pieces.size(), 1);
+
+    // Diagonals are the triangle edges that are not polygon edges; each is
+    // seen once, from the side where it runs from the lower index upwards
+    vector<pair<int, int>> diagonals;
+    for (const vector<int>& t : pieces) {
+        for (int e = 0; e < 3; e++) {
+            int a = t[e], b = t[(e + 1) % 3];
+            if (a < b && b - a != 1 && !(a == 0 && b == n - 1)) diagonals.push_back(make_pair(a, b));
+        }
+    }
+
+    // Piece on the left of each directed diagonal
+    auto key = [](int a, int b) { return (static_cast<uint64_t>(a) << 32) | static_cast<uint32_t>(b); };
+    unordered_map<uint64_t, size_t> owner;
+    for (size_t p = 0; p < pieces.size(); p++) {
+        for (int e = 0; e < 3; e++) owner[key(pieces[p][e], pieces[p][(e + 1) % 3])] = p;
+    }
+
+    // The piece that has directed edge a -> b, and the position of a in it
+    auto findEdge = [&](int a, int b, size_t& at) {
+        auto it = owner.find(key(a, b));
+        if (it == owner.end()) return pieces.size();
+        const vector<int>& piece = pieces[it->second];
+        for (size_t i = 0; i < piece.size(); i++) {
+            if (piece[i] == a) {
+                at = i;
+                break;
+            }
+        }
+        return it->second;
+    };
+
+    for (const pair<int, int>& d : diagonals) {
+        size_t i1 = 0, i2 = 0;
+        size_t p1 = findEdge(d.first, d.second, i1);
+        size_t p2 = findEdge(d.second, d.first, i2);
+        if (p1 == pieces.size() || p2 == pieces.size() || p1 == p2) continue;
+
+        // p1 from b round to a, then p2 strictly between a and b
+        const vector<int>& A = pieces[p1];
+        const vector<int>& B = pieces[p2];
+        vector<int> merged;
+        for (size_t k = 1; k <= A.size(); k++) merged.push_back(A[(i1 + k) % A.size()]);
+        for (size_t k = 2; k < B.size(); k++) merged.push_back(B[(i2 + k) % B.size()]);
+
+        if (isConvex(v, merged)) {
+            for (size_t k = 0; k < B.size(); k++) owner[key(B[k], B[(k + 1) % B.size()])] = p1;
+            owner.erase(key(d.first, d.second));
+            owner.erase(key(d.second, d.first));
+            pieces[p1] = merged;
+            alive[p2] = 0;
+        }
+    }
+
+    for (size_t p = 0; p < pieces.size(); p++) {
+        if (!alive[p]) continue;
+        Polygon piece;
+        for (int i : pieces[p]) piece.vertices.push_back(v[i]);
+        result.push_back(piece);
+    }
+    TRACE_DEBUG("Convex decomposition: " << n << " vertices, " << result.size() << " pieces");
+    return result;
+}
+
+// Below this many pieces starting threads costs more than the merges
+static const size_t PARALLEL_MIN_PIECES = 64;
+
+vector<Polygon> MinkowskiSum::MINKOWSKISUMNONCONVEX(const Polygon& P, const Polygon& R,
+                                                    size_t threads) {
+    TRACE_INFO("=== MINKOWSKI SUM (non-convex) ===");
+
+    vector<Polygon> sums;
+    if (P.vertices.size() < 3 || R.vertices.size() < 3) {
+        TRACE_ERROR("Input polygons must have at least 3 vertices");
+        return sums;
+    }
+
+    Polygon robot = R;
+    normalizePolygon(robot);
+    vector<Polygon> pieces = convexDecomposition(P);
+    sums.resize(pieces.size());
+
+    // Pieces are handed out one at a time; each result has its own slot
+    parallelFor(pieces.size(), threadLimit(threads, pieces.size() / PARALLEL_MIN_PIECES + 1), 1,
+                [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) convexSum(pieces[i], robot, sums[i]);
+    });
+
+    TRACE_INFO("Obstacle with " << P.vertices.size() << " vertices split into "
+               << pieces.size() << " convex pieces");
+    return sums;
+}
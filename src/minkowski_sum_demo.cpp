@@ -7,6 +7,9 @@
 #include "data_structure.hpp"
 #include "minkowski_sum.hpp"
 #include "sdl_layer.hpp"
+#include "trace.hpp"
+
+static const char TRACE_MODULE[] = "minkowski_sum_demo";
 
 void minkowski_sum_demo() {
 
@@ -37,7 +40,7 @@ void minkowski_sum_demo() {
     MinkowskiSum::normalizePolygon(P);
     MinkowskiSum::normalizePolygon(reflected_R);
 
-    std::cout << "Computing Minkowski sum..." << std::endl;
+    TRACE_INFO("Computing Minkowski sum...");
     Polygon minkowskiSum = MinkowskiSum::MINKOWSKISUM(P, reflected_R);
     
     bool running = true;
@@ -52,7 +55,7 @@ void minkowski_sum_demo() {
             if (event.type == SDL_KEYDOWN) {
                 if (event.key.keysym.sym == SDLK_SPACE) {
                     visualizationStep = (visualizationStep + 1) % 2;
-                    std::cout << "Visualization step: " << visualizationStep << std::endl;
+                    TRACE_INFO("Visualization step: " << visualizationStep);
                 }
             }
         }
@@ -105,9 +108,10 @@ void minkowski_sum_demo() {
         }
 
         SDL_RenderPresent(renderer);
+        trace::flush();
     }
 
-    std::cout << "Cleaning up..." << std::endl;
+    TRACE_INFO("Cleaning up...");
     if (font) TTF_CloseFont(font);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
@@ -0,0 +1,349 @@
+#include "orientation_slices.hpp"
+#include "minkowski_sum.hpp"
+#include "parallel_for.hpp"
+#include "trace.hpp"
+
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+static const char TRACE_MODULE[] = "orientation_slices";
+
+static const double TWO_PI = 2 * M_PI;
+
+size_t OrientationSlices::sliceFor(double angle) const {
+    long k = lround(angle / (TWO_PI / slices.size())) % static_cast<long>(slices.size());
+    return static_cast<size_t>(k < 0 ? k + static_cast<long>(slices.size()) : k);
+}
+
+size_t OrientationSlices::sliceOf(uint32_t node) const {
+    return upper_bound(nodeBase.begin(), nodeBase.end(), node) - nodeBase.begin() - 1;
+}
+
+size_t OrientationSlices::linkCount() const {
+    // One entry per link turns first
+    return count(turnsFirst.begin(), turnsFirst.end(), 1);
+}
+
+static Point rotate(const Point& p, double c, double s) {
+    return Point(p.x * c - p.y * s, p.x * s + p.y * c);
+}
+
+static double cross(const Point& o, const Point& a, const Point& b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// Counter-clockwise convex hull (monotone chain), without collinear points
+static Polygon convexHull(vector<Point>& points) {
+    sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    vector<Point> hull(2 * points.size());
+    size_t k = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
+        hull[k++] = points[i];
+    }
+    for (size_t i = points.size() - 1, lower = k + 1; i-- > 0;) {
+        while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
+        hull[k++] = points[i];
+    }
+    Polygon polygon;
+    hull.resize(k > 1 ? k - 1 : k);
+    polygon.vertices = std::move(hull);
+    return polygon;
+}
+
+// A convex piece turned through [middle - half, middle + half] around the
+// reference point sweeps no more than the hull of the piece at both ends and
+// of every vertex at the middle angle, pushed out by 1 / cos(half): a vertex
+// moves along an arc, which lies in the triangle of its two ends and the
+// point where the tangents there meet.
+static Polygon sweptPiece(const Polygon& piece, double middle, double half) {
+    vector<Point> points;
+    double ends[2] = {middle - half, middle + half};
+    for (double angle : ends) {
+        double c = cos(angle), s = sin(angle);
+        for (const Point& v : piece.vertices) points.push_back(rotate(v, c, s));
+    }
+    double c = cos(middle) / cos(half), s = sin(middle) / cos(half);
+    for (const Point& v : piece.vertices) points.push_back(rotate(v, c, s));
+    return convexHull(points);
+}
+
+// A link found from node from of one slice to node to of the next: the turn
+// happens at from's position
+struct Link {
+    uint32_t from;
+    uint32_t to;
+    double length;
+};
+
+// A fresh roadmap numbers its trapezoid centers first, by slot
+static uint32_t centerCount(const ConfigurationSpace& slice) {
+    return static_cast<uint32_t>(slice.freeSpace.trapezoids.size());
+}
+
+// Link every center of slice a that lies in the free space of slice b to the
+// center of the trapezoid it lies in. With reverse, the links found from b
+// to a before, target[u] for center u of a, are given: a center of a whose
+// own link already leads to the same pair is skipped.
+static void findLinks(const OrientationSlices& space, size_t a, size_t b, double turn,
+                      vector<uint32_t>& target, bool reverse, vector<Link>& links) {
+    const RoadMap& roadMap = space.slices[a].roadMap;
+    const ConfigurationSpace& other = space.slices[b];
+    uint32_t n = centerCount(space.slices[a]);
+    if (!reverse) target.assign(n, ROADMAP_NONE);
+    for (uint32_t u = 0; u < n; u++) {
+        if (roadMap.component[u] == ROADMAP_NONE) continue;
+        const Point& p = roadMap.positions[u];
+        Trapezoid* t = PathComputer::findTrapezoidContainingPoint(other.freeSpace, p);
+        if (!other.freeSpace.contains(t)) continue;
+        uint32_t v = other.roadMap.getNodeForTrapezoid(t);
+        if (v == ROADMAP_NONE) continue;
+        if (reverse && v < target.size() && target[v] == u) continue;
+        if (!reverse) target[u] = v;
+        const Point& q = other.roadMap.positions[v];
+        double dx = q.x - p.x, dy = q.y - p.y;
+        links.push_back(Link{space.nodeBase[a] + u, space.nodeBase[b] + v, turn + sqrt(dx * dx + dy * dy)});
+    }
+}
+
+static uint32_t findRoot(vector<uint32_t>& parent, uint32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void buildOrientationSlices(OrientationSlices& space,
+                            const Polygon& robot,
+                            const vector<Polygon>& obstacles,
+                            size_t sliceCount,
+                            size_t threads,
+                            unsigned seed) {
+    size_t K = max<size_t>(3, sliceCount);
+    double width = TWO_PI / K;
+    space.stats = OrientationStats();
+    space.angles.resize(K);
+    for (size_t k = 0; k < K; k++) space.angles[k] = width * k;
+
+    space.reach = 0;
+    for (const Point& v : robot.vertices) space.reach = max(space.reach, sqrt(v.x * v.x + v.y * v.y));
+
+    // 1. Convex pieces of the obstacles and of the robot, shared by every
+    // slice
+    auto t0 = chrono::steady_clock::now();
+    vector<Polygon> obstaclePieces;
+    convexObstaclePieces(obstaclePieces, obstacles, threads);
+    vector<Polygon> robotPieces = MinkowskiSum::convexDecomposition(robot);
+    space.stats.decompose = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    // 2. One slice per thread at a time; each builds single-threaded, which
+    // keeps every core busy with the map builds too
+    t0 = chrono::steady_clock::now();
+    space.slices.resize(K);
+    space.stats.threads = parallelFor(K, threads, 1, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++) {
+            vector<Polygon> swept;
+            for (const Polygon& piece : robotPieces) {
+                swept.push_back(sweptPiece(piece, space.angles[k], width / 2));
+            }
+            buildConfigurationSpace(space.slices[k], swept, obstaclePieces, 1, seed);
+        }
+    });
+    space.nodeBase.assign(K + 1, 0);
+    for (size_t k = 0; k < K; k++) {
+        space.nodeBase[k + 1] = space.nodeBase[k] + centerCount(space.slices[k]);
+    }
+    space.stats.slices = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    // 3. Links between slice k and the next, found both ways round
+    t0 = chrono::steady_clock::now();
+    double turn = space.reach * width;
+    vector<vector<Link>> found(K);
+    parallelFor(K, threads, 1, [&](size_t begin, size_t end) {
+        vector<uint32_t> target;
+        for (size_t k = begin; k < end; k++) {
+            findLinks(space, k, (k + 1) % K, turn, target, false, found[k]);
+            findLinks(space, (k + 1) % K, k, turn, target, true, found[k]);
+        }
+    });
+
+    // The layered graph: each center's roadmap row with the wall crossings
+    // folded into the edges, then its links. A crossing has exactly the two
+    // centers it joins as neighbours. A link goes into the rows of both its
+    // ends; the far end turns last.
+    size_t n = space.nodeBase[K];
+    RoadMap& graph = space.graph;
+    graph = RoadMap();
+    graph.positions.resize(n);
+    graph.rowBegin.assign(n + 1, 0);
+    for (size_t k = 0; k < K; k++) {
+        const RoadMap& roadMap = space.slices[k].roadMap;
+        uint32_t base = space.nodeBase[k];
+        for (uint32_t i = 0; i < centerCount(space.slices[k]); i++) {
+            graph.positions[base + i] = roadMap.positions[i];
+            graph.rowBegin[base + i + 1] = roadMap.rowEnd[i] - roadMap.rowBegin[i];
+        }
+    }
+    for (const vector<Link>& links : found) {
+        for (const Link& link : links) {
+            graph.rowBegin[link.from + 1]++;
+            graph.rowBegin[link.to + 1]++;
+        }
+    }
+    for (size_t v = 0; v < n; v++) graph.rowBegin[v + 1] += graph.rowBegin[v];
+    graph.neighbors.resize(graph.rowBegin[n]);
+    graph.lengths.resize(graph.rowBegin[n]);
+    space.turnsFirst.assign(graph.rowBegin[n], 0);
+    space.crossing.assign(graph.rowBegin[n], ROADMAP_NONE);
+    graph.rowEnd.assign(graph.rowBegin.begin(), graph.rowBegin.end() - 1);
+    graph.rowBegin.resize(n);
+    for (size_t k = 0; k < K; k++) {
+        const RoadMap& roadMap = space.slices[k].roadMap;
+        uint32_t base = space.nodeBase[k];
+        for (uint32_t i = 0; i < centerCount(space.slices[k]); i++) {
+            for (uint32_t e = roadMap.rowBegin[i]; e < roadMap.rowEnd[i]; e++) {
+                uint32_t x = roadMap.neighbors[e];
+                uint32_t first = roadMap.rowBegin[x];
+                bool second = roadMap.neighbors[first] == i;
+                uint32_t at = graph.rowEnd[base + i]++;
+                graph.neighbors[at] = base + roadMap.neighbors[first + second];
+                graph.lengths[at] = roadMap.lengths[e] + roadMap.lengths[first + second];
+                space.crossing[at] = x;
+            }
+        }
+    }
+    for (const vector<Link>& links : found) {
+        for (const Link& link : links) {
+            uint32_t at = graph.rowEnd[link.from]++;
+            graph.neighbors[at] = link.to;
+            graph.lengths[at] = link.length;
+            space.turnsFirst[at] = 1;
+            at = graph.rowEnd[link.to]++;
+            graph.neighbors[at] = link.from;
+            graph.lengths[at] = link.length;
+        }
+    }
+
+    // Components, numbered densely. Dropped roadmap nodes stay labelled
+    // ROADMAP_NONE.
+    vector<uint32_t> parent(n);
+    for (uint32_t v = 0; v < n; v++) parent[v] = v;
+    for (uint32_t v = 0; v < n; v++) {
+        for (uint32_t e = graph.rowBegin[v]; e < graph.rowEnd[v]; e++) {
+            uint32_t a = findRoot(parent, v);
+            uint32_t b = findRoot(parent, graph.neighbors[e]);
+            if (a != b) parent[a] = b;
+        }
+    }
+    vector<uint32_t> label(n, ROADMAP_NONE);
+    graph.component.resize(n);
+    for (uint32_t v = 0; v < n; v++) {
+        size_t k = space.sliceOf(v);
+        if (space.slices[k].roadMap.component[v - space.nodeBase[k]] == ROADMAP_NONE) {
+            graph.component[v] = ROADMAP_NONE;
+            continue;
+        }
+        uint32_t& l = label[findRoot(parent, v)];
+        if (l == ROADMAP_NONE) l = graph.componentCount++;
+        graph.component[v] = l;
+    }
+    space.stats.link = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    // 4. Landmarks. Straight-line distance alone hardly tells the slices
+    // apart, and a query would spread through all of them.
+    t0 = chrono::steady_clock::now();
+    space.landmarks = buildLandmarkTable(graph);
+    space.stats.landmarks = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    TRACE_INFO("Orientation slices: " << K << " slices built on " << space.stats.threads
+               << " threads, " << n << " roadmap nodes, " << space.linkCount() << " links between slices, "
+               << graph.componentCount << " connected parts");
+}
+
+// Append pose unless it repeats the last one
+static void addPose(vector<Pose>& path, const Point& position, double angle) {
+    if (!path.empty() && path.back().position.equals(position) && path.back().angle == angle) return;
+    path.push_back(Pose(position, angle));
+}
+
+// Locate a pose in the slice of its heading: its layered graph node, or the
+// reason there is none
+static PathStatus locate(const OrientationSlices& space, const Pose& pose, PathStatus blocked,
+                         size_t& k, uint32_t& node) {
+    k = space.sliceFor(pose.angle);
+    const ConfigurationSpace& slice = space.slices[k];
+    Trapezoid* t = PathComputer::findTrapezoidContainingPoint(slice.freeSpace, pose.position);
+    if (!slice.freeSpace.contains(t)) return blocked;
+    uint32_t local = slice.roadMap.getNodeForTrapezoid(t);
+    if (local == ROADMAP_NONE) return PATH_NO_ROADMAP_NODE;
+    node = space.nodeBase[k] + local;
+    return PATH_FOUND;
+}
+
+PathStatus queryOrientationPath(const OrientationSlices& space,
+                                const Pose& start,
+                                const Pose& goal,
+                                SearchScratch& scratch,
+                                vector<Pose>& path) {
+    path.clear();
+    scratch.expanded = 0;
+    if (space.slices.empty()) return PATH_NO_ROADMAP_NODE;
+
+    size_t startSlice, goalSlice;
+    uint32_t nu_start, nu_goal;
+    PathStatus status = locate(space, start, PATH_START_BLOCKED, startSlice, nu_start);
+    if (status != PATH_FOUND) return status;
+    status = locate(space, goal, PATH_GOAL_BLOCKED, goalSlice, nu_goal);
+    if (status != PATH_FOUND) return status;
+
+    vector<Point> points;
+    status = PathComputer::queryRoadMapPath(space.graph.view(), nu_start, nu_goal, start.position,
+                                            goal.position, scratch, points, SEARCH_ALT,
+                                            &space.landmarks);
+    if (status != PATH_FOUND) return status;
+
+    // The search leaves its parent links in scratch; the node chain, start
+    // first, goes into the scratch's BFS queue
+    vector<uint32_t>& chain = scratch.frontier;
+    chain.clear();
+    for (uint32_t node = nu_goal; ; node = scratch.parent[node]) {
+        chain.push_back(node);
+        if (node == nu_start) break;
+    }
+    reverse(chain.begin(), chain.end());
+
+    const RoadMap& graph = space.graph;
+    path.push_back(start);
+    addPose(path, start.position, space.angles[startSlice]);
+    size_t k = startSlice;
+    for (size_t i = 0; i < chain.size(); i++) {
+        const Point& position = graph.positions[chain[i]];
+        if (i > 0) {
+            // The row entry the step was taken by says whether it is a link
+            // and at which end the turn happens, or which wall it crosses
+            uint32_t from = chain[i - 1];
+            uint32_t e = graph.rowBegin[from];
+            while (graph.neighbors[e] != chain[i]) e++;
+            size_t next = space.sliceOf(chain[i]);
+            if (next != k) {
+                if (space.turnsFirst[e]) {
+                    addPose(path, graph.positions[from], space.angles[next]);
+                } else {
+                    addPose(path, position, space.angles[k]);
+                }
+                k = next;
+            } else {
+                addPose(path, space.slices[k].roadMap.positions[space.crossing[e]], space.angles[k]);
+            }
+        }
+        addPose(path, position, space.angles[k]);
+    }
+    addPose(path, goal.position, space.angles[goalSlice]);
+    addPose(path, goal.position, goal.angle);
+    return PATH_FOUND;
+}
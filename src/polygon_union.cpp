@@ -0,0 +1,600 @@
+#include "polygon_union.hpp"
+#include "parallel_for.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+static const char TRACE_MODULE[] = "polygon_union";
+
+// Tolerances relative to the size of the group being merged: points closer
+// than SNAP are one vertex, and a ring is tested for enclosure by a point
+// OFFSET inside it
+static const double SNAP = 1e-10;
+static const double OFFSET = 1e-8;
+// Relative tolerance on cross products and edge parameters
+static const double PARALLEL = 1e-12;
+static const double PARAMETER = 1e-9;
+
+struct Box {
+    double minX, minY, maxX, maxY;
+};
+
+static Box boundingBox(const vector<Point>& v) {
+    Box b = {v[0].x, v[0].y, v[0].x, v[0].y};
+    for (const Point& p : v) {
+        b.minX = min(b.minX, p.x);
+        b.minY = min(b.minY, p.y);
+        b.maxX = max(b.maxX, p.x);
+        b.maxY = max(b.maxY, p.y);
+    }
+    return b;
+}
+
+static bool contains(const Box& b, const Point& p) {
+    return p.x >= b.minX && p.x <= b.maxX && p.y >= b.minY && p.y <= b.maxY;
+}
+
+static double cross(double ax, double ay, double bx, double by) {
+    return ax * by - ay * bx;
+}
+
+static double signedArea(const vector<Point>& v) {
+    double area = 0;
+    for (size_t i = 0, j = v.size() - 1; i < v.size(); j = i++) {
+        area += v[j].x * v[i].y - v[i].x * v[j].y;
+    }
+    return area / 2;
+}
+
+// Even-odd rule; p must not lie on the boundary
+static bool pointInPolygon(const vector<Point>& v, const Point& p) {
+    bool inside = false;
+    for (size_t i = 0, j = v.size() - 1; i < v.size(); j = i++) {
+        const Point& a = v[i];
+        const Point& b = v[j];
+        if ((a.y > p.y) != (b.y > p.y) &&
+            p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// Where p, the middle of a piece of edge running along (dx, dy), lies
+// against a counter-clockwise ring: strictly inside or outside it, or on
+// one of its edges, running the same way or the opposite way
+enum RingSide { OUTSIDE, INSIDE, ALONG, AGAINST };
+
+static RingSide sideOf(const vector<Point>& v, const Point& p, double dx, double dy, double tolerance) {
+    bool inside = false;
+    for (size_t i = 0, j = v.size() - 1; i < v.size(); j = i++) {
+        const Point& a = v[j];
+        const Point& b = v[i];
+        double ex = b.x - a.x, ey = b.y - a.y;
+        double px = p.x - a.x, py = p.y - a.y;
+        double e2 = ex * ex + ey * ey;
+        double c = cross(ex, ey, px, py);
+        if (c * c <= tolerance * tolerance * e2) {
+            double t = ex * px + ey * py;
+            if (t >= 0 && t <= e2) return ex * dx + ey * dy > 0 ? ALONG : AGAINST;
+        }
+        if ((a.y > p.y) != (b.y > p.y) && p.x < a.x + py * ex / ey) inside = !inside;
+    }
+    return inside ? INSIDE : OUTSIDE;
+}
+
+// Buffers of sweepOverlaps, kept from call to call
+struct SweepBuffers {
+    vector<size_t> order;
+    vector<vector<size_t>> bands;
+};
+
+// Sweeps keep about this many boxes per band
+static const size_t BOXES_PER_BAND = 64;
+static const size_t MAX_BANDS = 4096;
+
+// Calls visit(i, j) once for every pair of boxes that overlap, allowing a
+// gap of slack in x. Boxes are swept by their left side and met with the
+// active ones, those still open there. The active boxes are kept per
+// horizontal band of extent, so a box only meets those at its own height; a
+// pair sharing several bands is visited from the lowest.
+template <typename Visit>
+static void sweepOverlaps(const vector<Box>& boxes, const Box& extent, double slack,
+                          SweepBuffers& buffers, const Visit& visit) {
+    size_t bandCount = min(MAX_BANDS, max<size_t>(1, boxes.size() / BOXES_PER_BAND));
+    double bandHeight = (extent.maxY - extent.minY) / bandCount;
+    auto band = [&](double y) {
+        if (!(bandHeight > 0)) return size_t(0);
+        return min(bandCount - 1, static_cast<size_t>(max(0.0, (y - extent.minY) / bandHeight)));
+    };
+    if (buffers.bands.size() < bandCount) buffers.bands.resize(bandCount);
+    for (size_t b = 0; b < bandCount; b++) buffers.bands[b].clear();
+
+    vector<size_t>& order = buffers.order;
+    order.resize(boxes.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    sort(order.begin(), order.end(), [&](size_t a, size_t b) { return boxes[a].minX < boxes[b].minX; });
+
+    for (size_t i : order) {
+        const Box& e = boxes[i];
+        double x = e.minX - slack;
+        for (size_t b = band(e.minY); b <= band(e.maxY); b++) {
+            vector<size_t>& active = buffers.bands[b];
+            for (size_t k = 0; k < active.size();) {
+                size_t j = active[k];
+                const Box& f = boxes[j];
+                if (f.maxX < x) {
+                    active[k] = active.back();
+                    active.pop_back();
+                    continue;
+                }
+                k++;
+                if (f.maxY < e.minY || f.minY > e.maxY) continue;
+                if (band(max(e.minY, f.minY)) != b) continue;
+                visit(i, j);
+            }
+            active.push_back(i);
+        }
+    }
+}
+
+static Box extentOf(const vector<Box>& boxes) {
+    Box all = boxes[0];
+    for (const Box& b : boxes) {
+        all.minX = min(all.minX, b.minX);
+        all.minY = min(all.minY, b.minY);
+        all.maxX = max(all.maxX, b.maxX);
+        all.maxY = max(all.maxY, b.maxY);
+    }
+    return all;
+}
+
+static size_t findRoot(vector<size_t>& parent, size_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Polygons whose bounding boxes overlap, directly or through others, in
+// groups ordered by their first polygon
+static vector<vector<size_t>> groupByBoxes(const vector<Box>& boxes) {
+    size_t n = boxes.size();
+    vector<vector<size_t>> groups;
+    if (n == 0) return groups;
+
+    vector<size_t> parent(n);
+    for (size_t i = 0; i < n; i++) parent[i] = i;
+    SweepBuffers buffers;
+    sweepOverlaps(boxes, extentOf(boxes), 0, buffers, [&](size_t i, size_t j) {
+        parent[findRoot(parent, j)] = findRoot(parent, i);
+    });
+
+    vector<size_t> groupOf(n, n);
+    for (size_t i = 0; i < n; i++) {
+        size_t root = findRoot(parent, i);
+        if (groupOf[root] == n) {
+            groupOf[root] = groups.size();
+            groups.push_back(vector<size_t>());
+        }
+        groups[groupOf[root]].push_back(i);
+    }
+    return groups;
+}
+
+// An edge of a group ring, a -> b, and the edge that follows it
+struct UnionEdge {
+    Point a, b;
+    size_t ring;
+    size_t next;
+};
+
+// A point an edge is split at, by its parameter along a -> b
+struct Split {
+    size_t edge;
+    double t;
+    Point p;
+};
+
+// A piece of an edge between consecutive split points, as vertex ids
+struct Piece {
+    int from, to;
+};
+
+// Buffers of one worker, kept from group to group
+struct UnionScratch {
+    vector<UnionEdge> edges;
+    vector<Box> edgeBoxes;
+    SweepBuffers sweep;
+    vector<Split> splits;
+    vector<Point> occurrences;      // per edge: a, then its split points
+    vector<size_t> edgeStart;
+    vector<size_t> byX;
+    vector<int> vertexOf;
+    vector<Point> vertices;
+    vector<Piece> pieces;
+    vector<size_t> cellStart;
+    vector<size_t> cellRings;
+    vector<size_t> first;
+    vector<char> used;
+};
+
+static bool isInside(double t) {
+    return t > PARAMETER && t < 1 - PARAMETER;
+}
+
+// Records where edges i and j meet on each of them. An endpoint of one lying
+// on the other is used as it is, so the pieces of both end on the same point.
+static void intersect(const vector<UnionEdge>& edges, size_t i, size_t j, vector<Split>& splits) {
+    const UnionEdge& e = edges[i];
+    const UnionEdge& f = edges[j];
+    double dx = e.b.x - e.a.x, dy = e.b.y - e.a.y;
+    double fx = f.b.x - f.a.x, fy = f.b.y - f.a.y;
+    double cx = f.a.x - e.a.x, cy = f.a.y - e.a.y;
+    double denom = cross(dx, dy, fx, fy);
+    double e2 = dx * dx + dy * dy, f2 = fx * fx + fy * fy;
+
+    if (denom * denom <= PARALLEL * PARALLEL * e2 * f2) {
+        // Parallel: only collinear overlaps matter, split each at the other's ends
+        if (fabs(cross(dx, dy, cx, cy)) > PARALLEL * (e2 + cx * cx + cy * cy)) return;
+        const Point* ends[2] = {&f.a, &f.b};
+        for (const Point* p : ends) {
+            double t = ((p->x - e.a.x) * dx + (p->y - e.a.y) * dy) / e2;
+            if (isInside(t)) splits.push_back(Split{i, t, *p});
+        }
+        const Point* others[2] = {&e.a, &e.b};
+        for (const Point* p : others) {
+            double u = ((p->x - f.a.x) * fx + (p->y - f.a.y) * fy) / f2;
+            if (isInside(u)) splits.push_back(Split{j, u, *p});
+        }
+        return;
+    }
+
+    double t = cross(cx, cy, fx, fy) / denom;
+    double u = cross(cx, cy, dx, dy) / denom;
+    if (t < -PARAMETER || t > 1 + PARAMETER || u < -PARAMETER || u > 1 + PARAMETER) return;
+
+    Point p(e.a.x + t * dx, e.a.y + t * dy);
+    if (!isInside(u)) p = u < 0.5 ? f.a : f.b;
+    else if (!isInside(t)) p = t < 0.5 ? e.a : e.b;
+    if (isInside(t)) splits.push_back(Split{i, t, p});
+    if (isInside(u)) splits.push_back(Split{j, u, p});
+}
+
+// Drops vertices that continue straight on from the one before
+static void dropCollinear(vector<Point>& v) {
+    size_t n = v.size(), kept = 0;
+    for (size_t i = 0; i < n; i++) {
+        const Point& a = kept ? v[kept - 1] : v[n - 1];
+        const Point& b = v[i];
+        const Point& c = v[(i + 1) % n];
+        double ux = b.x - a.x, uy = b.y - a.y, wx = c.x - b.x, wy = c.y - b.y;
+        if (fabs(cross(ux, uy, wx, wy)) <= PARALLEL * (ux * ux + uy * uy + wx * wx + wy * wy)
+            && ux * wx + uy * wy > 0) {
+            continue;
+        }
+        v[kept++] = b;
+    }
+    v.resize(kept);
+}
+
+// Point just inside a counter-clockwise ring, left of the middle of its
+// longest edge
+static Point inside(const vector<Point>& v, double scale) {
+    size_t longest = 0;
+    double best = -1;
+    for (size_t i = 0; i < v.size(); i++) {
+        const Point& a = v[i];
+        const Point& b = v[(i + 1) % v.size()];
+        double l = (b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y);
+        if (l > best) {
+            best = l;
+            longest = i;
+        }
+    }
+    const Point& a = v[longest];
+    const Point& b = v[(longest + 1) % v.size()];
+    double length = sqrt(best), offset = min(OFFSET * scale, length / 4);
+    return Point((a.x + b.x) / 2 - (b.y - a.y) / length * offset,
+                 (a.y + b.y) / 2 + (b.x - a.x) / length * offset);
+}
+
+// Groups with more rings than this index them in a grid for the inside tests
+static const size_t GRID_MIN_RINGS = 8;
+
+// Merged boundaries of one group: counter-clockwise outer rings and the
+// clockwise holes inside them
+struct GroupUnion {
+    vector<Polygon> outer;
+    vector<vector<Point>> holes;
+};
+
+// Union of one group of counter-clockwise rings
+static void unionGroup(const vector<const vector<Point>*>& rings, const vector<Box>& boxes,
+                       UnionScratch& s, GroupUnion& out) {
+    Box all = extentOf(boxes);
+    double scale = max(1.0, max(all.maxX - all.minX, all.maxY - all.minY));
+    double tolerance = SNAP * scale;
+
+    vector<UnionEdge>& edges = s.edges;
+    edges.clear();
+    s.edgeBoxes.clear();
+    for (size_t r = 0; r < rings.size(); r++) {
+        const vector<Point>& v = *rings[r];
+        size_t base = edges.size();
+        for (size_t i = 0; i < v.size(); i++) {
+            const Point& a = v[i];
+            const Point& b = v[(i + 1) % v.size()];
+            edges.push_back(UnionEdge{a, b, r, i + 1 < v.size() ? base + i + 1 : base});
+            s.edgeBoxes.push_back(Box{min(a.x, b.x), min(a.y, b.y), max(a.x, b.x), max(a.y, b.y)});
+        }
+    }
+
+    // 1. Crossings, among the edges whose boxes overlap. Edges of one ring
+    // never cross.
+    s.splits.clear();
+    sweepOverlaps(s.edgeBoxes, all, tolerance, s.sweep, [&](size_t i, size_t j) {
+        if (edges[i].ring != edges[j].ring) intersect(edges, i, j, s.splits);
+    });
+
+    // 2. Vertex ids. Every edge contributes its start and its split points
+    // in order along it; occurrences within the tolerance of one another,
+    // found next to each other in x order, become one vertex.
+    sort(s.splits.begin(), s.splits.end(), [](const Split& a, const Split& b) {
+        return a.edge != b.edge ? a.edge < b.edge : a.t < b.t;
+    });
+    s.occurrences.clear();
+    s.edgeStart.resize(edges.size() + 1);
+    for (size_t i = 0, k = 0; i < edges.size(); i++) {
+        s.edgeStart[i] = s.occurrences.size();
+        s.occurrences.push_back(edges[i].a);
+        for (; k < s.splits.size() && s.splits[k].edge == i; k++) s.occurrences.push_back(s.splits[k].p);
+    }
+    s.edgeStart[edges.size()] = s.occurrences.size();
+
+    const vector<Point>& occ = s.occurrences;
+    s.byX.resize(occ.size());
+    for (size_t i = 0; i < occ.size(); i++) s.byX[i] = i;
+    sort(s.byX.begin(), s.byX.end(), [&](size_t a, size_t b) {
+        return occ[a].x != occ[b].x ? occ[a].x < occ[b].x : occ[a].y < occ[b].y;
+    });
+    s.vertexOf.assign(occ.size(), -1);
+    s.vertices.clear();
+    for (size_t k = 0; k < s.byX.size(); k++) {
+        const Point& p = occ[s.byX[k]];
+        int id = -1;
+        for (size_t back = k; back-- > 0 && p.x - occ[s.byX[back]].x <= tolerance;) {
+            const Point& q = occ[s.byX[back]];
+            if (fabs(q.y - p.y) <= tolerance) {
+                id = s.vertexOf[s.byX[back]];
+                break;
+            }
+            // Further back on the same x only gets lower
+            if (q.x == p.x && q.y < p.y) break;
+        }
+        if (id < 0) {
+            id = static_cast<int>(s.vertices.size());
+            s.vertices.push_back(p);
+        }
+        s.vertexOf[s.byX[k]] = id;
+    }
+
+    // 3. A piece is on the boundary of the union unless its middle is inside
+    // another ring, or on an edge of one running the other way (the two
+    // rings meet along it). Pieces split at every crossing lie wholly inside
+    // or outside each ring, so the middle stands for the whole piece.
+    bool useGrid = rings.size() > GRID_MIN_RINGS;
+    int side = max(1, static_cast<int>(sqrt(static_cast<double>(rings.size()))));
+    double cellW = (all.maxX - all.minX) / side + tolerance;
+    double cellH = (all.maxY - all.minY) / side + tolerance;
+    auto column = [&](double x) { return min(side - 1, max(0, static_cast<int>((x - all.minX) / cellW))); };
+    auto row = [&](double y) { return min(side - 1, max(0, static_cast<int>((y - all.minY) / cellH))); };
+    if (useGrid) {
+        // Rings per cell of their bounding boxes, as one array
+        size_t cellCount = static_cast<size_t>(side) * side;
+        s.cellStart.assign(cellCount + 1, 0);
+        for (int pass = 0; pass < 2; pass++) {
+            for (size_t r = 0; r < rings.size(); r++) {
+                for (int y = row(boxes[r].minY); y <= row(boxes[r].maxY); y++) {
+                    for (int x = column(boxes[r].minX); x <= column(boxes[r].maxX); x++) {
+                        size_t cell = static_cast<size_t>(y) * side + x;
+                        if (pass == 0) s.cellStart[cell + 1]++;
+                        else s.cellRings[s.first[cell]++] = r;
+                    }
+                }
+            }
+            if (pass == 0) {
+                for (size_t c = 0; c < cellCount; c++) s.cellStart[c + 1] += s.cellStart[c];
+                s.cellRings.resize(s.cellStart[cellCount]);
+                s.first.assign(s.cellStart.begin(), s.cellStart.end());
+            }
+        }
+    }
+    auto covered = [&](const Point& p, double dx, double dy) {
+        size_t begin = 0, end = rings.size();
+        if (useGrid) {
+            size_t cell = static_cast<size_t>(row(p.y)) * side + column(p.x);
+            begin = s.cellStart[cell];
+            end = s.cellStart[cell + 1];
+        }
+        for (size_t k = begin; k < end; k++) {
+            size_t r = useGrid ? s.cellRings[k] : k;
+            if (!contains(boxes[r], p)) continue;
+            RingSide side = sideOf(*rings[r], p, dx, dy, tolerance);
+            if (side == INSIDE || side == AGAINST) return true;
+        }
+        return false;
+    };
+
+    s.pieces.clear();
+    for (size_t i = 0; i < edges.size(); i++) {
+        for (size_t k = s.edgeStart[i]; k < s.edgeStart[i + 1]; k++) {
+            // The last piece ends where the next edge starts
+            size_t end = k + 1 < s.edgeStart[i + 1] ? k + 1 : s.edgeStart[edges[i].next];
+            int from = s.vertexOf[k], to = s.vertexOf[end];
+            if (from == to) continue;
+            const Point& a = s.vertices[from];
+            const Point& b = s.vertices[to];
+            Point middle((a.x + b.x) / 2, (a.y + b.y) / 2);
+            if (!covered(middle, b.x - a.x, b.y - a.y)) s.pieces.push_back(Piece{from, to});
+        }
+    }
+    // The same piece from two rings with their insides on the same side
+    vector<Piece>& boundary = s.pieces;
+    sort(boundary.begin(), boundary.end(), [](const Piece& a, const Piece& b) {
+        return a.from != b.from ? a.from < b.from : a.to < b.to;
+    });
+    boundary.erase(unique(boundary.begin(), boundary.end(),
+                          [](const Piece& a, const Piece& b) { return a.from == b.from && a.to == b.to; }),
+                   boundary.end());
+
+    // 4. Chain the pieces into rings. Where rings touch, a vertex has more
+    // than one way on; taking the sharpest left turn keeps them apart.
+    size_t vertexCount = s.vertices.size();
+    s.first.assign(vertexCount + 1, 0);
+    for (const Piece& piece : boundary) s.first[piece.from + 1]++;
+    for (size_t v = 0; v < vertexCount; v++) s.first[v + 1] += s.first[v];
+    s.used.assign(boundary.size(), 0);
+
+    size_t broken = 0;
+    for (size_t start = 0; start < boundary.size(); start++) {
+        if (s.used[start]) continue;
+        s.used[start] = 1;
+        vector<Point> ring(1, s.vertices[boundary[start].from]);
+        size_t current = start;
+        bool closed = false;
+        while (true) {
+            int at = boundary[current].to;
+            if (at == boundary[start].from) {
+                closed = true;
+                break;
+            }
+            ring.push_back(s.vertices[at]);
+            const Point& p = s.vertices[boundary[current].from];
+            const Point& q = s.vertices[at];
+            size_t best = boundary.size();
+            double bestAngle = 0;
+            for (size_t k = s.first[at]; k < s.first[at + 1]; k++) {
+                if (s.used[k]) continue;
+                const Point& w = s.vertices[boundary[k].to];
+                double angle = atan2(cross(q.x - p.x, q.y - p.y, w.x - q.x, w.y - q.y),
+                                     (q.x - p.x) * (w.x - q.x) + (q.y - p.y) * (w.y - q.y));
+                if (best == boundary.size() || angle > bestAngle) {
+                    best = k;
+                    bestAngle = angle;
+                }
+            }
+            if (best == boundary.size()) break;
+            s.used[best] = 1;
+            current = best;
+        }
+        if (!closed) {
+            broken++;
+            continue;
+        }
+        dropCollinear(ring);
+        if (ring.size() < 3) continue;
+        if (signedArea(ring) > 0) {
+            Polygon polygon;
+            polygon.vertices = std::move(ring);
+            out.outer.push_back(std::move(polygon));
+        } else {
+            out.holes.push_back(std::move(ring));
+        }
+    }
+    if (broken) TRACE_WARN("Union: " << broken << " boundary chains did not close and were dropped");
+}
+
+// Holes are filled in, so the rings inside them, from any group, go too.
+// A ring lies wholly inside a hole or wholly outside it; a point just
+// inside the ring tells which.
+static void dropEnclosed(vector<Polygon>& result, const vector<vector<Point>>& holes) {
+    if (holes.empty()) return;
+    size_t n = result.size();
+    vector<Box> boxes;
+    for (const Polygon& polygon : result) boxes.push_back(boundingBox(polygon.vertices));
+    for (const vector<Point>& hole : holes) boxes.push_back(boundingBox(hole));
+    Box all = extentOf(boxes);
+    double scale = max(1.0, max(all.maxX - all.minX, all.maxY - all.minY));
+
+    vector<char> enclosed(n, 0);
+    SweepBuffers buffers;
+    sweepOverlaps(boxes, all, 0, buffers, [&](size_t i, size_t j) {
+        if ((i < n) == (j < n)) return;
+        size_t r = i < n ? i : j, h = i < n ? j : i;
+        const Box& a = boxes[r];
+        const Box& b = boxes[h];
+        if (enclosed[r] || a.minX < b.minX || a.maxX > b.maxX || a.minY < b.minY || a.maxY > b.maxY) return;
+        enclosed[r] = pointInPolygon(holes[h - n], inside(result[r].vertices, scale));
+    });
+
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (enclosed[i]) continue;
+        if (kept != i) result[kept] = std::move(result[i]);
+        kept++;
+    }
+    result.resize(kept);
+}
+
+// Below this many groups starting threads costs more than the merges
+static const size_t PARALLEL_MIN_GROUPS = 16;
+
+vector<Polygon> unionPolygons(const vector<Polygon>& polygons, size_t threads) {
+    // Counter-clockwise copies of the polygons with an area
+    vector<vector<Point>> rings;
+    vector<Box> boxes;
+    for (const Polygon& polygon : polygons) {
+        if (polygon.vertices.size() < 3) continue;
+        double area = signedArea(polygon.vertices);
+        if (area == 0) continue;
+        rings.push_back(polygon.vertices);
+        if (area < 0) reverse(rings.back().begin(), rings.back().end());
+        boxes.push_back(boundingBox(rings.back()));
+    }
+
+    vector<vector<size_t>> groups = groupByBoxes(boxes);
+    vector<GroupUnion> merged(groups.size());
+
+    // Groups are handed out one at a time; each result has its own slot.
+    // The buffers live per thread, so merges reuse them across groups.
+    parallelFor(groups.size(), threadLimit(threads, groups.size() / PARALLEL_MIN_GROUPS + 1), 1,
+                [&](size_t begin, size_t end) {
+        static thread_local UnionScratch scratch;
+        static thread_local vector<const vector<Point>*> members;
+        static thread_local vector<Box> memberBoxes;
+        for (size_t g = begin; g < end; g++) {
+            if (groups[g].size() == 1) continue;
+            members.clear();
+            memberBoxes.clear();
+            for (size_t i : groups[g]) {
+                members.push_back(&rings[i]);
+                memberBoxes.push_back(boxes[i]);
+            }
+            unionGroup(members, memberBoxes, scratch, merged[g]);
+        }
+    });
+
+    vector<Polygon> result;
+    vector<vector<Point>> holes;
+    size_t mergedGroups = 0;
+    for (size_t g = 0; g < groups.size(); g++) {
+        if (groups[g].size() == 1) {
+            Polygon polygon;
+            polygon.vertices = std::move(rings[groups[g][0]]);
+            result.push_back(std::move(polygon));
+            continue;
+        }
+        mergedGroups++;
+        for (Polygon& polygon : merged[g].outer) result.push_back(std::move(polygon));
+        for (vector<Point>& hole : merged[g].holes) holes.push_back(std::move(hole));
+    }
+    dropEnclosed(result, holes);
+    TRACE_DEBUG("Union: " << rings.size() << " polygons, " << mergedGroups << " groups merged, "
+                << holes.size() << " holes filled, " << result.size() << " boundaries");
+    return result;
+}
@@ -0,0 +1,119 @@
+#include "query_pool.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+QueryPool::QueryPool(size_t threads)
+    : job(NULL), jobCount(0), jobChunk(1), nextBegin(0),
+      generation(0), active(0), stopping(false) {
+    if (threads == 0) {
+        threads = max<size_t>(1, thread::hardware_concurrency());
+    }
+    scratch.resize(threads);
+    for (size_t w = 0; w < threads; w++) {
+        workers.emplace_back(&QueryPool::workerLoop, this, w);
+    }
+}
+
+QueryPool::~QueryPool() {
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread& t : workers) {
+        t.join();
+    }
+}
+
+void QueryPool::run(size_t count, size_t chunk, const Job& fn) {
+    if (count == 0) return;
+
+    unique_lock<mutex> lock(mtx);
+    job = &fn;
+    jobCount = count;
+    jobChunk = max<size_t>(1, chunk);
+    nextBegin = 0;
+    active = workers.size();
+    generation++;
+    wake.notify_all();
+
+    finished.wait(lock, [this]() { return active == 0; });
+    job = NULL;
+}
+
+void QueryPool::workerLoop(size_t worker) {
+    size_t seen = 0;
+    while (true) {
+        const Job* current;
+        {
+            unique_lock<mutex> lock(mtx);
+            wake.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            current = job;
+        }
+
+        // Chunks are claimed with one atomic add, so uneven queries (long
+        // searches next to trivial ones) still spread across the workers
+        while (true) {
+            size_t begin = nextBegin.fetch_add(jobChunk);
+            if (begin >= jobCount) break;
+            size_t end = min(jobCount, begin + jobChunk);
+            (*current)(worker, begin, end);
+        }
+
+        {
+            lock_guard<mutex> lock(mtx);
+            if (--active == 0) finished.notify_one();
+        }
+    }
+}
+
+void QueryPool::locate(const TrapezoidalMap& map, const vector<Point>& points,
+                       vector<Trapezoid*>& out) {
+    out.assign(points.size(), NULL);
+    Job fn = [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            Node* leaf = queryTrapezoidMap(map.root, points[i]);
+            out[i] = leaf ? leaf->trapezoid : NULL;
+        }
+    };
+    run(points.size(), 1024, fn);
+}
+
+void QueryPool::locate(const FrozenSearchStructure& fs, const double* xs, const double* ys,
+                       size_t count, Trapezoid** out) {
+    Job fn = [&](size_t, size_t begin, size_t end) {
+        queryFrozenBatch(fs, xs + begin, ys + begin, end - begin, out + begin);
+    };
+    run(count, 1024, fn);
+}
+
+void QueryPool::computePaths(const TrapezoidalMap& freeSpaceMap, const RoadMap& roadMap,
+                             const vector<PathQuery>& queries, vector<PathResult>& out,
+                             SearchAlgorithm algorithm, const LandmarkTable* landmarks) {
+    out.resize(queries.size());
+    Job fn = [&](size_t worker, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            out[i].status = PathComputer::queryPath(freeSpaceMap, roadMap,
+                                                    queries[i].start, queries[i].goal,
+                                                    scratch[worker], out[i].path,
+                                                    algorithm, landmarks);
+            out[i].settled = scratch[worker].expanded;
+        }
+    };
+    run(queries.size(), 8, fn);
+}
+
+void QueryPool::validatePaths(const TrapezoidalMap& freeSpaceMap,
+                              const vector<vector<Point>>& paths, vector<uint8_t>& valid) {
+    valid.resize(paths.size());
+    Job fn = [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            valid[i] = PathComputer::isValidPath(freeSpaceMap, paths[i]) ? 1 : 0;
+        }
+    };
+    run(paths.size(), 64, fn);
+}
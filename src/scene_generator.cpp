@@ -0,0 +1,89 @@
+#include "scene_generator.hpp"
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <algorithm>
+
+using namespace std;
+
+// [0, 1) from the raw engine output, which the standard fixes bit for bit
+static double unit(mt19937& rng) {
+    return rng() / 4294967296.0;
+}
+
+static double uniform(mt19937& rng, double lo, double hi) {
+    return lo + (hi - lo) * unit(rng);
+}
+
+// Vertices on an ellipse at increasing angles: always convex
+static Polygon convexObstacle(mt19937& rng, size_t vertices, double cx, double cy, double radius) {
+    vector<double> angles(vertices);
+    for (double& a : angles) a = uniform(rng, 0, 2 * M_PI);
+    sort(angles.begin(), angles.end());
+    // Half random, half even spread: neighbouring vertices end up at least
+    // pi / vertices apart, so no edge is tiny
+    for (size_t i = 0; i < vertices; i++) angles[i] = angles[i] / 2 + i * M_PI / vertices;
+
+    double aspect = uniform(rng, 0.6, 1.0);
+    double rotation = uniform(rng, 0, M_PI);
+    double c = cos(rotation), s = sin(rotation);
+    Polygon polygon;
+    for (double a : angles) {
+        double x = radius * cos(a), y = radius * aspect * sin(a);
+        polygon.addVertex(cx + c * x - s * y, cy + s * x + c * y);
+    }
+    return polygon;
+}
+
+// Alternating outer and inner radii around the center: star-shaped, so the
+// boundary never crosses itself, and concave at every inner vertex
+static Polygon concaveObstacle(mt19937& rng, size_t vertices, double cx, double cy, double radius) {
+    double offset = uniform(rng, 0, 2 * M_PI);
+    Polygon polygon;
+    for (size_t i = 0; i < vertices; i++) {
+        double a = offset + 2 * M_PI * (i + uniform(rng, -0.2, 0.2)) / vertices;
+        double r = (i % 2 == 0) ? radius : radius * uniform(rng, 0.35, 0.7);
+        polygon.addVertex(cx + r * cos(a), cy + r * sin(a));
+    }
+    return polygon;
+}
+
+Scene generateScene(const SceneParameters& parameters) {
+    mt19937 rng(parameters.seed);
+
+    // Shapes first, so the grid can be sized for them
+    vector<size_t> vertexCounts;
+    vector<char> concave;
+    size_t edges = 0;
+    while (edges < parameters.edges || vertexCounts.empty()) {
+        bool isConcave = unit(rng) < parameters.concaveFraction;
+        size_t n = isConcave ? 6 + 2 * (rng() % 4) : 3 + rng() % 6;
+        vertexCounts.push_back(n);
+        concave.push_back(isConcave);
+        edges += n;
+    }
+
+    size_t count = vertexCounts.size();
+    size_t columns = static_cast<size_t>(ceil(sqrt(static_cast<double>(count))));
+    Scene scene;
+    scene.obstacles.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        // Radius plus center jitter stays below half a cell, leaving a
+        // corridor between neighbours
+        double radius = uniform(rng, 0.25, 0.4);
+        double cx = (i % columns) + 0.5 + uniform(rng, -0.05, 0.05);
+        double cy = (i / columns) + 0.5 + uniform(rng, -0.05, 0.05);
+        scene.obstacles.push_back(concave[i] ? concaveObstacle(rng, vertexCounts[i], cx, cy, radius)
+                                             : convexObstacle(rng, vertexCounts[i], cx, cy, radius));
+    }
+
+    double width = static_cast<double>(columns);
+    double height = static_cast<double>((count + columns - 1) / columns);
+    for (size_t q = 0; q < parameters.queries; q++) {
+        scene.starts.push_back(Point(uniform(rng, 0, width), uniform(rng, 0, height)));
+        scene.goals.push_back(Point(uniform(rng, 0, width), uniform(rng, 0, height)));
+    }
+    return scene;
+}
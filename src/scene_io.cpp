@@ -0,0 +1,241 @@
+#include "scene_io.hpp"
+#include "trace.hpp"
+
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <charconv>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char TRACE_MODULE[] = "scene_io";
+
+static const char SCENE_MAGIC[4] = {'T', 'M', 'S', 'C'};
+static const uint32_t SCENE_VERSION = 1;
+
+// Read-only mapping of a whole file, unmapped on scope exit
+struct MappedFile {
+    const char* data;
+    size_t size;
+
+    MappedFile() : data(NULL), size(0) {}
+    ~MappedFile() {
+        if (data) munmap(const_cast<char*>(data), size);
+    }
+
+    bool open(const char* filename) {
+        int fd = ::open(filename, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        if (ok && st.st_size > 0) {
+            void* mapping = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ok = false;
+            } else {
+                data = static_cast<const char*>(mapping);
+                size = static_cast<size_t>(st.st_size);
+                // One front-to-back pass
+                madvise(mapping, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+        return ok;
+    }
+};
+
+// Position in the mapped text. Numbers are converted in place with
+// from_chars, which needs neither a terminator nor the locale.
+struct TextCursor {
+    const char* p;
+    const char* end;
+    size_t line;
+
+    void skipBlanks() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    }
+    bool atLineEnd() {
+        skipBlanks();
+        return p == end || *p == '\n' || *p == '#';
+    }
+    void nextLine() {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        p = nl ? nl + 1 : end;
+        line++;
+    }
+    bool keyword(const char* word) {
+        size_t n = strlen(word);
+        if (static_cast<size_t>(end - p) < n || memcmp(p, word, n) != 0) return false;
+        if (p + n < end && p[n] != ' ' && p[n] != '\t' && p[n] != '\r' && p[n] != '\n') return false;
+        p += n;
+        return true;
+    }
+    // from_chars also takes "inf" and "nan", which no coordinate may be
+    bool number(double& value) {
+        skipBlanks();
+        if (p < end && *p == '+') p++;
+        from_chars_result r = from_chars(p, end, value);
+        if (r.ec != errc() || !isfinite(value)) return false;
+        p = r.ptr;
+        return true;
+    }
+};
+
+static bool parseText(Scene& scene, const char* data, size_t size,
+                      [[maybe_unused]] const char* filename) {
+    TextCursor c = {data, data + size, 1};
+    while (c.p < c.end) {
+        if (c.atLineEnd()) {
+            c.nextLine();
+            continue;
+        }
+        if (c.keyword("polygon")) {
+            Polygon polygon;
+            double x, y;
+            while (!c.atLineEnd()) {
+                if (!c.number(x) || !c.number(y)) {
+                    TRACE_ERROR(filename << ":" << c.line << ": expected x y pairs after polygon");
+                    return false;
+                }
+                polygon.addVertex(x, y);
+            }
+            if (polygon.vertices.size() < 3) {
+                TRACE_ERROR(filename << ":" << c.line << ": polygon needs at least 3 vertices");
+                return false;
+            }
+            scene.obstacles.push_back(std::move(polygon));
+        } else if (c.keyword("query")) {
+            double sx, sy, gx, gy;
+            if (!c.number(sx) || !c.number(sy) || !c.number(gx) || !c.number(gy) || !c.atLineEnd()) {
+                TRACE_ERROR(filename << ":" << c.line << ": expected query sx sy gx gy");
+                return false;
+            }
+            scene.starts.push_back(Point(sx, sy));
+            scene.goals.push_back(Point(gx, gy));
+        } else {
+            TRACE_ERROR(filename << ":" << c.line << ": unknown record");
+            return false;
+        }
+        c.nextLine();
+    }
+    return true;
+}
+
+// Bounds-checked reads from the mapped binary form
+struct BinaryCursor {
+    const char* p;
+    const char* end;
+
+    template <typename T>
+    bool read(T* out, size_t count) {
+        size_t bytes = count * sizeof(T);
+        if (count > static_cast<size_t>(end - p) / sizeof(T)) return false;
+        memcpy(out, p, bytes);
+        p += bytes;
+        return true;
+    }
+};
+
+static bool parseBinary(Scene& scene, const char* data, size_t size) {
+    BinaryCursor c = {data + 4, data + size};
+    uint32_t version = 0, polygonCount = 0, queryCount = 0;
+    if (!c.read(&version, 1) || version != SCENE_VERSION
+        || !c.read(&polygonCount, 1) || !c.read(&queryCount, 1)) {
+        return false;
+    }
+
+    // Every polygon takes at least a count and three vertices, so a count
+    // the rest of the file cannot hold is rejected before allocating
+    if (polygonCount > static_cast<size_t>(c.end - c.p) / (sizeof(uint32_t) + 3 * 2 * sizeof(double))) {
+        return false;
+    }
+    scene.obstacles.resize(polygonCount);
+    for (Polygon& polygon : scene.obstacles) {
+        uint32_t vertexCount = 0;
+        if (!c.read(&vertexCount, 1) || vertexCount < 3
+            || vertexCount > static_cast<size_t>(c.end - c.p) / (2 * sizeof(double))) {
+            return false;
+        }
+        polygon.vertices.resize(vertexCount);
+        for (Point& v : polygon.vertices) {
+            double xy[2];
+            c.read(xy, 2);
+            if (!isfinite(xy[0]) || !isfinite(xy[1])) return false;
+            v = Point(xy[0], xy[1]);
+        }
+    }
+
+    if (queryCount > static_cast<size_t>(c.end - c.p) / (4 * sizeof(double))) return false;
+    scene.starts.resize(queryCount);
+    scene.goals.resize(queryCount);
+    for (uint32_t q = 0; q < queryCount; q++) {
+        double v[4];
+        c.read(v, 4);
+        for (double d : v) {
+            if (!isfinite(d)) return false;
+        }
+        scene.starts[q] = Point(v[0], v[1]);
+        scene.goals[q] = Point(v[2], v[3]);
+    }
+    return c.p == c.end;
+}
+
+bool loadScene(Scene& scene, const char* filename) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        TRACE_ERROR("Cannot open " << filename);
+        return false;
+    }
+
+    Scene loaded;
+    if (file.size >= 4 && memcmp(file.data, SCENE_MAGIC, 4) == 0) {
+        if (!parseBinary(loaded, file.data, file.size)) {
+            TRACE_ERROR(filename << " is not a valid binary scene");
+            return false;
+        }
+    } else if (!parseText(loaded, file.data, file.size, filename)) {
+        return false;
+    }
+
+    TRACE_INFO("Scene " << filename << ": " << loaded.obstacles.size() << " obstacles, "
+               << loaded.starts.size() << " queries");
+    scene = std::move(loaded);
+    return true;
+}
+
+bool saveSceneBinary(const Scene& scene, const char* filename) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) {
+        TRACE_ERROR("Cannot open " << filename << " for writing");
+        return false;
+    }
+    uint32_t polygonCount = static_cast<uint32_t>(scene.obstacles.size());
+    uint32_t queryCount = static_cast<uint32_t>(scene.starts.size());
+    bool ok = fwrite(SCENE_MAGIC, 1, 4, f) == 4
+        && fwrite(&SCENE_VERSION, sizeof(uint32_t), 1, f) == 1
+        && fwrite(&polygonCount, sizeof(uint32_t), 1, f) == 1
+        && fwrite(&queryCount, sizeof(uint32_t), 1, f) == 1;
+    for (size_t i = 0; ok && i < scene.obstacles.size(); i++) {
+        const vector<Point>& vertices = scene.obstacles[i].vertices;
+        uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+        ok = fwrite(&vertexCount, sizeof(uint32_t), 1, f) == 1;
+        for (size_t j = 0; ok && j < vertices.size(); j++) {
+            double xy[2] = {vertices[j].x, vertices[j].y};
+            ok = fwrite(xy, sizeof(double), 2, f) == 2;
+        }
+    }
+    for (size_t q = 0; ok && q < scene.starts.size(); q++) {
+        double v[4] = {scene.starts[q].x, scene.starts[q].y, scene.goals[q].x, scene.goals[q].y};
+        ok = fwrite(v, sizeof(double), 4, f) == 4;
+    }
+    if (fclose(f) != 0) ok = false;
+    if (!ok) TRACE_ERROR("Failed to write scene to " << filename);
+    return ok;
+}
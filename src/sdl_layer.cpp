@@ -1,13 +1,16 @@
 #include "sdl_layer.hpp"
+#include "trace.hpp"
+
+static const char TRACE_MODULE[] = "sdl_layer";
 
 bool sdl_start(SDL_Window*& window, SDL_Renderer*& renderer, TTF_Font*& font) {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "Could not initialize SDL: " << SDL_GetError() << std::endl;
+        TRACE_ERROR("Could not initialize SDL: " << SDL_GetError());
         return false;
     }
     
     if (TTF_Init() < 0) {
-        std::cerr << "Could not initialize SDL_ttf: " << TTF_GetError() << std::endl;
+        TRACE_ERROR("Could not initialize SDL_ttf: " << TTF_GetError());
         SDL_Quit();
         return false;
     }
@@ -17,7 +20,7 @@ bool sdl_start(SDL_Window*& window, SDL_Renderer*& renderer, TTF_Font*& font) {
         SCREEN_WIDTH, SCREEN_HEIGHT,
         SDL_WINDOW_SHOWN);
     if (!window) {
-        std::cerr << "Could not create window: " << SDL_GetError() << std::endl;
+        TRACE_ERROR("Could not create window: " << SDL_GetError());
         TTF_Quit();
         SDL_Quit();
         return false;
@@ -26,7 +29,7 @@ bool sdl_start(SDL_Window*& window, SDL_Renderer*& renderer, TTF_Font*& font) {
     renderer = SDL_CreateRenderer(window, -1,
         SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (!renderer) {
-        std::cerr << "Could not create renderer: " << SDL_GetError() << std::endl;
+        TRACE_ERROR("Could not create renderer: " << SDL_GetError());
         SDL_DestroyWindow(window);
         TTF_Quit();
         SDL_Quit();
@@ -35,7 +38,7 @@ bool sdl_start(SDL_Window*& window, SDL_Renderer*& renderer, TTF_Font*& font) {
     
     font = TTF_OpenFont("/System/Library/Fonts/Helvetica.ttc", 14);
     if (!font) {
-        std::cerr << "Could not load font; text will not be shown." << std::endl;
+        TRACE_WARN("Could not load font; text will not be shown.");
     }
     
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
@@ -330,19 +333,20 @@ void drawPath(SDL_Renderer* renderer, const std::vector<Point>& path, Uint8 r, U
 }
 
 
-void drawRoadMap(SDL_Renderer* renderer, RoadMap& roadMap, bool rightSide) {
+void drawRoadMap(SDL_Renderer* renderer, const RoadMap& roadMap, bool rightSide) {
     // Draw edges
     SDL_SetRenderDrawColor(renderer, 200, 200, 200, 100);
-    for (RoadMapNode* node : roadMap.nodes) {
-        for (RoadMapNode* neighbor : node->neighbors) {
-            SDL_FPoint p1 = worldToScreen(node->position, rightSide);
-            SDL_FPoint p2 = worldToScreen(neighbor->position, rightSide);
+    for (size_t i = 0; i < roadMap.nodeCount(); i++) {
+        SDL_FPoint p1 = worldToScreen(roadMap.positions[i], rightSide);
+        for (uint32_t e = roadMap.rowBegin[i]; e < roadMap.rowEnd[i]; e++) {
+            SDL_FPoint p2 = worldToScreen(roadMap.positions[roadMap.neighbors[e]], rightSide);
             SDL_RenderDrawLineF(renderer, p1.x, p1.y, p2.x, p2.y);
         }
     }
-    // Draw nodes
-    for (RoadMapNode* node : roadMap.nodes) {
-        SDL_FPoint p = worldToScreen(node->position, rightSide);
+    // Draw nodes, skipping ids dropped by updateRoadMap
+    for (size_t i = 0; i < roadMap.nodeCount(); i++) {
+        if (roadMap.component[i] == ROADMAP_NONE) continue;
+        SDL_FPoint p = worldToScreen(roadMap.positions[i], rightSide);
         drawCircle(renderer, static_cast<int>(p.x), static_cast<int>(p.y), 4, 100, 100, 255, 255);
     }
 }
@@ -0,0 +1,202 @@
+#include "trace.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+// Bounded multi-producer queue (sequence-numbered cells, as in Vyukov's
+// MPMC queue). Producers claim a cell with one CAS and publish it with a
+// release store; the consumer side is serialised by the draining flag.
+namespace {
+
+const size_t RING_SIZE = 1024;     // power of two
+const size_t RING_MASK = RING_SIZE - 1;
+
+struct Cell {
+    atomic<size_t> sequence;
+    TraceRecord record;
+};
+
+struct RingBuffer {
+    Cell cells[RING_SIZE];
+    atomic<size_t> enqueuePos;
+    atomic<size_t> dequeuePos;      // only advanced while draining
+    atomic_flag draining;
+    atomic<size_t> dropped;
+    atomic<TraceSink> sink;
+
+    RingBuffer() : enqueuePos(0), dequeuePos(0), dropped(0), sink(trace::stdoutSink) {
+        draining.clear();
+        for (size_t i = 0; i < RING_SIZE; i++) {
+            cells[i].sequence.store(i, memory_order_relaxed);
+        }
+    }
+
+    // Whatever is still buffered at exit gets written out
+    ~RingBuffer() { tryDrain(); }
+
+    bool push(int level, const char* module, const char* text, size_t length) {
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & RING_MASK];
+            size_t seq = cell->sequence.load(memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;       // full
+            } else {
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+
+        TraceRecord& r = cell->record;
+        r.level = level;
+        r.module = module;
+        r.timestampNs = static_cast<uint64_t>(
+            chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now().time_since_epoch()).count());
+        r.length = static_cast<uint32_t>(length);
+        memcpy(r.text, text, length);
+        r.text[length] = '\0';
+
+        cell->sequence.store(pos + 1, memory_order_release);
+        return true;
+    }
+
+    // Caller holds the draining flag
+    void drain() {
+        TraceSink out = sink.load(memory_order_acquire);
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        for (;;) {
+            Cell* cell = &cells[pos & RING_MASK];
+            size_t seq = cell->sequence.load(memory_order_acquire);
+            if (seq != pos + 1) break;      // empty, or not yet published
+            if (out) out(cell->record);
+            cell->sequence.store(pos + RING_SIZE, memory_order_release);
+            pos++;
+            dequeuePos.store(pos, memory_order_relaxed);
+        }
+    }
+
+    bool tryDrain() {
+        if (draining.test_and_set(memory_order_acquire)) return false;
+        drain();
+        draining.clear(memory_order_release);
+        return true;
+    }
+
+    size_t pending() const {
+        // Racy estimate, only used to decide when to drain early
+        return enqueuePos.load(memory_order_relaxed) - dequeuePos.load(memory_order_relaxed);
+    }
+};
+
+RingBuffer& ring() {
+    static RingBuffer buffer;
+    return buffer;
+}
+
+}  // namespace
+
+namespace trace {
+
+// Library users see problems only; the demos raise this to follow the
+// algorithms step by step
+atomic<int> runtimeLevel(TRACE_LEVEL_WARN);
+
+void setLevel(int level) {
+    runtimeLevel.store(level, memory_order_relaxed);
+}
+
+int level() {
+    return runtimeLevel.load(memory_order_relaxed);
+}
+
+void setSink(TraceSink sink) {
+    flush();
+    ring().sink.store(sink, memory_order_release);
+}
+
+void stdoutSink(const TraceRecord& record) {
+    // Keep stdout and stderr lines in the order they were traced
+    if (record.level <= TRACE_LEVEL_WARN) fflush(stdout);
+    if (record.level == TRACE_LEVEL_ERROR) {
+        fprintf(stderr, "ERROR: %s\n", record.text);
+    } else if (record.level == TRACE_LEVEL_WARN) {
+        fprintf(stderr, "WARNING: %s\n", record.text);
+    } else {
+        fwrite(record.text, 1, record.length, stdout);
+        fputc('\n', stdout);
+    }
+}
+
+void write(int level, const char* module, const char* text, size_t length) {
+    RingBuffer& r = ring();
+    if (!r.push(level, module, text, length)) {
+        // Full: make room if nobody else is draining, otherwise drop
+        if (!r.tryDrain() || !r.push(level, module, text, length)) {
+            r.dropped.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+    }
+    // Errors go out straight away; everything else once the buffer fills up
+    if (level <= TRACE_LEVEL_WARN || r.pending() >= RING_SIZE / 2) {
+        r.tryDrain();
+    }
+}
+
+void flush() {
+    ring().tryDrain();
+}
+
+size_t dropped() {
+    return ring().dropped.load(memory_order_relaxed);
+}
+
+}  // namespace trace
+
+TraceLine& TraceLine::operator<<(const char* s) {
+    if (!s) s = "(null)";
+    while (*s && length < TRACE_MESSAGE_SIZE - 1) {
+        text[length++] = *s++;
+    }
+    return *this;
+}
+
+TraceLine& TraceLine::operator<<(char c) {
+    if (length < TRACE_MESSAGE_SIZE - 1) text[length++] = c;
+    return *this;
+}
+
+// snprintf never writes past the end; clamp length to what actually fits
+#define TRACE_APPEND(fmt, value)                                                  \
+    do {                                                                          \
+        int n = snprintf(text + length, TRACE_MESSAGE_SIZE - length, fmt, value); \
+        if (n > 0) length = min(length + n, TRACE_MESSAGE_SIZE - 1);              \
+    } while (0)
+
+TraceLine& TraceLine::operator<<(long long v) {
+    TRACE_APPEND("%lld", v);
+    return *this;
+}
+
+TraceLine& TraceLine::operator<<(unsigned long long v) {
+    TRACE_APPEND("%llu", v);
+    return *this;
+}
+
+TraceLine& TraceLine::operator<<(double v) {
+    // Same as the default ostream formatting
+    TRACE_APPEND("%g", v);
+    return *this;
+}
+
+TraceLine& TraceLine::operator<<(const void* p) {
+    TRACE_APPEND("%p", p);
+    return *this;
+}
@@ -5,36 +5,88 @@
 #include <ctime>
 #include <cmath>
 #include <set>
+#include <random>
+#include <numeric>
+#include <climits>
 
 #include "data_structure.hpp"
 #include "trapezoidal_map.hpp"
+#include "trace.hpp"
 
 using namespace std;
 
+static const char TRACE_MODULE[] = "trapezoidal_map";
+
+// Lets trace points print a trapezoid inline
+[[maybe_unused]] static TraceLine& operator<<(TraceLine& line, const Trapezoid* t) {
+    if (t == NULL) return line << "NULL trapezoid";
+    return line << "Trap " << static_cast<const void*>(t)
+                << ": left=(" << t->leftp.x << "," << t->leftp.y
+                << ") right=(" << t->rightp.x << "," << t->rightp.y << ")"
+                << " top=" << static_cast<const void*>(t->top)
+                << " bottom=" << static_cast<const void*>(t->bottom);
+}
+
+Trapezoid* TrapezoidalMap::newTrapezoid() {
+    return trapezoidArena.create();
+}
+
+Node* TrapezoidalMap::newNode() {
+    return nodeArena.create();
+}
+
+Segment* TrapezoidalMap::newSegment(const Segment& s) {
+    Segment* seg = segmentArena.create(s);
+    segments.push_back(seg);
+    return seg;
+}
+
 void TrapezoidalMap::addTrapezoid(Trapezoid* t) {
+    t->slot = static_cast<int>(trapezoids.size());
     trapezoids.push_back(t);
 }
 
 void TrapezoidalMap::removeTrapezoid(Trapezoid* t) {
+    if (!contains(t)) return;
+    
+    Trapezoid* last = trapezoids.back();
+    trapezoids[t->slot] = last;
+    last->slot = t->slot;
+    trapezoids.pop_back();
+    t->slot = -1;
+}
+
+size_t TrapezoidalMap::removeTrapezoidsIf(bool (*pred)(Trapezoid*)) {
+    size_t kept = 0;
     for (size_t i = 0; i < trapezoids.size(); i++) {
-        if (trapezoids[i] == t) {
-            trapezoids.erase(trapezoids.begin() + i);
-            return;
+        Trapezoid* t = trapezoids[i];
+        if (pred(t)) {
+            t->slot = -1;
+        } else {
+            t->slot = static_cast<int>(kept);
+            trapezoids[kept++] = t;
         }
     }
+    size_t removed = trapezoids.size() - kept;
+    trapezoids.resize(kept);
+    return removed;
+}
+
+bool TrapezoidalMap::contains(const Trapezoid* t) const {
+    return t && t->slot >= 0 && static_cast<size_t>(t->slot) < trapezoids.size() &&
+           trapezoids[t->slot] == t;
 }
 
 void TrapezoidalMap::cleanup() {
-    deleteSearchStructure(root);
-    for (size_t i = 0; i < trapezoids.size(); i++) {
-        delete trapezoids[i];
-    }
-    for (size_t i = 0; i < segments.size(); i++) {
-        delete segments[i];
-    }
+    // Trapezoids, nodes and segments are owned by the arenas, so teardown is
+    // a bulk release instead of a walk over the DAG
+    trapezoidArena.release();
+    nodeArena.release();
+    segmentArena.release();
     trapezoids.clear();
     segments.clear();
     root = NULL;
+    stats = BuildStats();
 }
 
 Node* queryTrapezoidMap(Node* n, const Point& p) {
@@ -44,7 +96,9 @@ Node* queryTrapezoidMap(Node* n, const Point& p) {
         return n;
     }
     if (n->type == X_NODE) {
-        if (p.x < n->point.x - 1e-9) {
+        // Lexicographic order acts as a symbolic shear, so points sharing an
+        // x-coordinate (vertical edges) are still separated
+        if (p < n->point) {
             return queryTrapezoidMap(n->left, p);
         } else {
             return queryTrapezoidMap(n->right, p);
@@ -60,268 +114,367 @@ Node* queryTrapezoidMap(Node* n, const Point& p) {
     return NULL;
 }
 
+Node* locateSegmentStart(Node* n, const Segment& seg, bool collinearAbove) {
+    Point left = seg.getLeftEndpoint();
+    Point right = seg.getRightEndpoint();
+
+    while (n != NULL && n->type != LEAF_NODE) {
+        if (n->type == X_NODE) {
+            n = (left < n->point) ? n->left : n->right;
+            continue;
+        }
+
+        Point a = n->segment->getLeftEndpoint();
+        Point b = n->segment->getRightEndpoint();
+        double cross = (b.x - a.x) * (left.y - a.y) - (b.y - a.y) * (left.x - a.x);
+        if (fabs(cross) <= 1e-9) {
+            cross = (b.x - a.x) * (right.y - left.y) - (b.y - a.y) * (right.x - left.x);
+            if (fabs(cross) <= 1e-9) cross = collinearAbove ? 1 : -1;
+        }
+        n = (cross > 1e-9) ? n->above : n->below;
+    }
+    return n;
+}
+
+// Where p lies against seg: positive above, negative below, 0 on it
+static int sideOf(const Segment& seg, const Point& p) {
+    Point a = seg.getLeftEndpoint();
+    Point b = seg.getRightEndpoint();
+    double cross = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+    return (cross > 1e-9) - (cross < -1e-9);
+}
+
 void findIntersectedTrapezoids(Node* root, const Segment& seg, 
                                vector<Trapezoid*>& result) {
-    Point left = seg.getLeftEndpoint();
     Point right = seg.getRightEndpoint();
 
-    Node* startNode = queryTrapezoidMap(root, left);
+    Node* startNode = locateSegmentStart(root, seg);
     if (startNode == NULL || startNode->trapezoid == NULL) {
-        cout << "ERROR: No trapezoid found for left endpoint" << endl;
+        TRACE_ERROR("No trapezoid found for left endpoint");
         return;
     }
 
     Trapezoid* current = startNode->trapezoid;
     result.push_back(current);
 
-    cout << "Starting trapezoid: ";
-    printTrapezoid(current);
+    TRACE_DEBUG("Starting trapezoid: " << current);
 
     while (current != nullptr) {
-        if (current->rightp.x >= right.x - 1e-9) {
-            cout << "Reached trapezoid containing right endpoint" << endl;
+        if (!(current->rightp < right)) {
+            TRACE_DEBUG("Reached trapezoid containing right endpoint");
             break;
         }
 
         Trapezoid* next = nullptr;
         Point rightPoint = current->rightp;
         
-        bool segmentAboveRightPoint = seg.isAbove(rightPoint);
+        int side = sideOf(seg, rightPoint);
         
-        cout << "At right boundary x=" << rightPoint.x << ", y=" << rightPoint.y;
-        cout << " - segment is " << (segmentAboveRightPoint ? "above" : "below") << endl;
+        TRACE_DEBUG("At right boundary x=" << rightPoint.x << ", y=" << rightPoint.y
+                    << " - segment is " << (side > 0 ? "below" : side < 0 ? "above" : "through it"));
         
-        if (segmentAboveRightPoint) {
+        if (side > 0) {
             next = current->lowerRight;
-            cout << "Following lowerRight neighbor" << endl;
-        } else {
+            TRACE_DEBUG("Following lowerRight neighbor");
+        } else if (side < 0) {
             next = current->upperRight;
-            cout << "Following upperRight neighbor" << endl;
+            TRACE_DEBUG("Following upperRight neighbor");
+        } else {
+            // The segment runs through a vertex of another obstacle that
+            // touches it. Segments leaving the vertex to the right split
+            // what lies there, and current may even close at the vertex,
+            // so the search structure picks the trapezoid the rest of the
+            // segment starts in.
+            Node* restart = locateSegmentStart(root, Segment(rightPoint, right));
+            next = restart ? restart->trapezoid : nullptr;
+            TRACE_DEBUG("Relocated past a vertex on the segment");
         }
 
         if (next == nullptr) {
-            cout << "ERROR: No next trapezoid found at x=" << current->rightp.x << endl;
+            TRACE_ERROR("No next trapezoid found at x=" << current->rightp.x);
             break;
         }
         
         if (!result.empty() && next == result.back()) {
-            cout << "WARNING: Circular reference detected" << endl;
-            break;
-        }
-        
-        if (result.size() > 100) {
-            cout << "ERROR: Too many trapezoids in intersection path" << endl;
+            TRACE_WARN("Circular reference detected");
             break;
         }
         
         result.push_back(next);
         current = next;
-        cout << "Next trapezoid: ";
-        printTrapezoid(current);
+        TRACE_DEBUG("Next trapezoid: " << current);
     }
 }
 
-void insertInSingleTrapezoid(TrapezoidalMap& map, Trapezoid* oldTrap, Segment* seg) {
-    Point left = seg->getLeftEndpoint();
-    Point right = seg->getRightEndpoint();
-    
-    cout << "=== Single trapezoid insertion ===" << endl;
-    cout << "Old trapezoid: ";
-    printTrapezoid(oldTrap);
-    
-    // Check if we need left and right traps
-    bool needLeftTrap = (fabs(left.x - oldTrap->leftp.x) > 1e-9);
-    bool needRightTrap = (fabs(right.x - oldTrap->rightp.x) > 1e-9);
-    
-    cout << "Need left trap: " << needLeftTrap << ", Need right trap: " << needRightTrap << endl;
-    
-    Trapezoid *A = NULL, *B = NULL, *C = NULL, *D = NULL;
-    
-    // Create left trap only if needed
-    if (needLeftTrap) {
-        A = new Trapezoid();
+static void replaceLeftNeighbor(Trapezoid* t, Trapezoid* oldTrap, Trapezoid* newTrap) {
+    if (!t) return;
+    if (t->upperLeft == oldTrap) t->upperLeft = newTrap;
+    if (t->lowerLeft == oldTrap) t->lowerLeft = newTrap;
+}
+
+static void replaceRightNeighbor(Trapezoid* t, Trapezoid* oldTrap, Trapezoid* newTrap) {
+    if (!t) return;
+    if (t->upperRight == oldTrap) t->upperRight = newTrap;
+    if (t->lowerRight == oldTrap) t->lowerRight = newTrap;
+}
+
+static Node* makeLeafNode(TrapezoidalMap& map, Trapezoid* t) {
+    Node* node = map.newNode();
+    node->type = LEAF_NODE;
+    node->trapezoid = t;
+    t->node = node;
+    return node;
+}
+
+static void makeXNode(Node* node, const Point& p, Node* left, Node* right) {
+    node->type = X_NODE;
+    node->point = p;
+    node->left = left;
+    node->right = right;
+    node->trapezoid = NULL;
+    node->segment = NULL;
+    node->above = NULL;
+    node->below = NULL;
+}
+
+static void makeYNode(Node* node, Segment* seg, Node* above, Node* below) {
+    node->type = Y_NODE;
+    node->segment = seg;
+    node->above = above;
+    node->below = below;
+    node->trapezoid = NULL;
+    node->point = Point(0, 0);
+    node->left = NULL;
+    node->right = NULL;
+}
+
+// Push depths down from a leaf that was just turned into an X or Y node. New
+// DAG edges only ever point at freshly created nodes, so nothing above n
+// changes and the walk stays within the few nodes of this insertion.
+static void updateDepths(TrapezoidalMap& map, Node* n) {
+    Node* children[2];
+    if (n->type == X_NODE) {
+        children[0] = n->left;
+        children[1] = n->right;
+    } else if (n->type == Y_NODE) {
+        children[0] = n->above;
+        children[1] = n->below;
+    } else {
+        map.stats.maxDepth = max(map.stats.maxDepth, n->depth);
+        return;
+    }
+    for (Node* child : children) {
+        if (child && child->depth < n->depth + 1) {
+            child->depth = n->depth + 1;
+            updateDepths(map, child);
+        }
+    }
+}
+
+// Hook up the left ends of the trapezoids above (upperTrap) and below (lowerTrap)
+// the new segment where it starts inside oldTrap. Returns the left cap when the
+// left endpoint is not already on oldTrap's left wall.
+static Trapezoid* splitLeftEnd(TrapezoidalMap& map, Trapezoid* oldTrap,
+                               Trapezoid* upperTrap, Trapezoid* lowerTrap,
+                               const Point& left) {
+    if (!(oldTrap->leftp == left)) {
+        Trapezoid* A = map.newTrapezoid();
         A->leftp = oldTrap->leftp;
         A->rightp = left;
         A->top = oldTrap->top;
         A->bottom = oldTrap->bottom;
+        A->upperLeft = oldTrap->upperLeft;
+        A->lowerLeft = oldTrap->lowerLeft;
+        A->upperRight = upperTrap;
+        A->lowerRight = lowerTrap;
+        replaceRightNeighbor(oldTrap->upperLeft, oldTrap, A);
+        replaceRightNeighbor(oldTrap->lowerLeft, oldTrap, A);
+        upperTrap->upperLeft = A;
+        upperTrap->lowerLeft = A;
+        lowerTrap->upperLeft = A;
+        lowerTrap->lowerLeft = A;
+        return A;
+    }
+
+    // The left endpoint is an existing vertex. If top or bottom starts there,
+    // or runs through it where obstacles touch, the piece on that side
+    // closes to a point and has no left neighbours.
+    bool topStarts = oldTrap->top->getLeftEndpoint() == left || sideOf(*oldTrap->top, left) == 0;
+    bool bottomStarts = oldTrap->bottom->getLeftEndpoint() == left || sideOf(*oldTrap->bottom, left) == 0;
+
+    if (topStarts && bottomStarts) {
+        return NULL;
+    }
+    if (topStarts) {
+        lowerTrap->upperLeft = oldTrap->upperLeft;
+        lowerTrap->lowerLeft = oldTrap->lowerLeft;
+        replaceRightNeighbor(oldTrap->upperLeft, oldTrap, lowerTrap);
+        replaceRightNeighbor(oldTrap->lowerLeft, oldTrap, lowerTrap);
+    } else if (bottomStarts) {
+        upperTrap->upperLeft = oldTrap->upperLeft;
+        upperTrap->lowerLeft = oldTrap->lowerLeft;
+        replaceRightNeighbor(oldTrap->upperLeft, oldTrap, upperTrap);
+        replaceRightNeighbor(oldTrap->lowerLeft, oldTrap, upperTrap);
+    } else {
+        // A segment ends at the vertex: its wall continues above and below
+        upperTrap->upperLeft = oldTrap->upperLeft;
+        upperTrap->lowerLeft = oldTrap->upperLeft;
+        lowerTrap->upperLeft = oldTrap->lowerLeft;
+        lowerTrap->lowerLeft = oldTrap->lowerLeft;
+        replaceRightNeighbor(oldTrap->upperLeft, oldTrap, upperTrap);
+        replaceRightNeighbor(oldTrap->lowerLeft, oldTrap, lowerTrap);
     }
+    return NULL;
+}
+
+// Mirror image of splitLeftEnd for the segment's right endpoint.
+static Trapezoid* splitRightEnd(TrapezoidalMap& map, Trapezoid* oldTrap,
+                                Trapezoid* upperTrap, Trapezoid* lowerTrap,
+                                const Point& right) {
+    if (!(oldTrap->rightp == right)) {
+        Trapezoid* D = map.newTrapezoid();
+        D->leftp = right;
+        D->rightp = oldTrap->rightp;
+        D->top = oldTrap->top;
+        D->bottom = oldTrap->bottom;
+        D->upperRight = oldTrap->upperRight;
+        D->lowerRight = oldTrap->lowerRight;
+        D->upperLeft = upperTrap;
+        D->lowerLeft = lowerTrap;
+        replaceLeftNeighbor(oldTrap->upperRight, oldTrap, D);
+        replaceLeftNeighbor(oldTrap->lowerRight, oldTrap, D);
+        upperTrap->upperRight = D;
+        upperTrap->lowerRight = D;
+        lowerTrap->upperRight = D;
+        lowerTrap->lowerRight = D;
+        return D;
+    }
+
+    bool topEnds = oldTrap->top->getRightEndpoint() == right || sideOf(*oldTrap->top, right) == 0;
+    bool bottomEnds = oldTrap->bottom->getRightEndpoint() == right || sideOf(*oldTrap->bottom, right) == 0;
+
+    if (topEnds && bottomEnds) {
+        return NULL;
+    }
+    if (topEnds) {
+        lowerTrap->upperRight = oldTrap->upperRight;
+        lowerTrap->lowerRight = oldTrap->lowerRight;
+        replaceLeftNeighbor(oldTrap->upperRight, oldTrap, lowerTrap);
+        replaceLeftNeighbor(oldTrap->lowerRight, oldTrap, lowerTrap);
+    } else if (bottomEnds) {
+        upperTrap->upperRight = oldTrap->upperRight;
+        upperTrap->lowerRight = oldTrap->lowerRight;
+        replaceLeftNeighbor(oldTrap->upperRight, oldTrap, upperTrap);
+        replaceLeftNeighbor(oldTrap->lowerRight, oldTrap, upperTrap);
+    } else {
+        upperTrap->upperRight = oldTrap->upperRight;
+        upperTrap->lowerRight = oldTrap->upperRight;
+        lowerTrap->upperRight = oldTrap->lowerRight;
+        lowerTrap->lowerRight = oldTrap->lowerRight;
+        replaceLeftNeighbor(oldTrap->upperRight, oldTrap, upperTrap);
+        replaceLeftNeighbor(oldTrap->lowerRight, oldTrap, lowerTrap);
+    }
+    return NULL;
+}
+
+// Neighbours across the wall above (or below) a vertex r the new segment
+// runs through. prev and cur are the old trapezoids holding the segment left
+// and right of r, leftPiece and rightPiece their new pieces on that side of
+// it. A piece whose side of prev or cur closes at r has no neighbour there;
+// otherwise it takes over the wall from prev or cur.
+static void linkAtVertex(Trapezoid* prev, Trapezoid* cur, Trapezoid* leftPiece,
+                         Trapezoid* rightPiece, const Point& r, bool above) {
+    const Segment* prevSide = above ? prev->top : prev->bottom;
+    const Segment* curSide = above ? cur->top : cur->bottom;
+    bool leftOpen = !(prevSide->getRightEndpoint() == r);
+    bool rightOpen = !(curSide->getLeftEndpoint() == r);
+    
+    Trapezoid* across = NULL;
+    if (leftOpen && rightOpen) {
+        leftPiece->upperRight = leftPiece->lowerRight = rightPiece;
+        rightPiece->upperLeft = rightPiece->lowerLeft = leftPiece;
+        return;
+    }
+    if (leftOpen) {
+        // Segments leave r to the right on this side; the wall runs up to
+        // (or down to) the outermost one
+        across = above ? prev->upperRight : prev->lowerRight;
+        leftPiece->upperRight = leftPiece->lowerRight = across;
+        replaceLeftNeighbor(across, prev, leftPiece);
+    }
+    if (rightOpen) {
+        across = above ? cur->upperLeft : cur->lowerLeft;
+        rightPiece->upperLeft = rightPiece->lowerLeft = across;
+        replaceRightNeighbor(across, cur, rightPiece);
+    }
+}
+
+void insertInSingleTrapezoid(TrapezoidalMap& map, Trapezoid* oldTrap, Segment* seg) {
+    Point left = seg->getLeftEndpoint();
+    Point right = seg->getRightEndpoint();
+    
+    TRACE_DEBUG("=== Single trapezoid insertion ===");
+    TRACE_DEBUG("Old trapezoid: " << oldTrap);
     
     // Create B and C (upper and lower trapezoids split by segment)
-    B = new Trapezoid();
+    Trapezoid* B = map.newTrapezoid();
     B->leftp = left;
     B->rightp = right;
     B->top = oldTrap->top;
     B->bottom = seg;
     
-    C = new Trapezoid();
+    Trapezoid* C = map.newTrapezoid();
     C->leftp = left;
     C->rightp = right;
     C->top = seg;
     C->bottom = oldTrap->bottom;
     
-    // Create right trap only if needed
-    if (needRightTrap) {
-        D = new Trapezoid();
-        D->leftp = right;
-        D->rightp = oldTrap->rightp;
-        D->top = oldTrap->top;
-        D->bottom = oldTrap->bottom;
-    }
+    // Left and right caps are only created when needed; the neighbours of
+    // oldTrap are re-pointed at whatever replaces it on each side
+    Trapezoid* A = splitLeftEnd(map, oldTrap, B, C, left);
+    Trapezoid* D = splitRightEnd(map, oldTrap, B, C, right);
     
-    // Add neighbours
-    if (A) {
-        A->upperRight = B;
-        A->lowerRight = C;
-        B->upperLeft = A;
-        B->lowerLeft = A;
-        C->upperLeft = A;
-        C->lowerLeft = A;
-        A->upperLeft = oldTrap->upperLeft;
-        A->lowerLeft = oldTrap->lowerLeft;
-    } else {
-        B->upperLeft = oldTrap->upperLeft;
-        B->lowerLeft = oldTrap->upperLeft;
-        C->upperLeft = oldTrap->lowerLeft;
-        C->lowerLeft = oldTrap->lowerLeft;
-    }
-    
-    if (D) {
-        B->upperRight = D;
-        B->lowerRight = D;
-        C->upperRight = D;
-        C->lowerRight = D;
-        D->upperLeft = B;
-        D->lowerLeft = C;
-        D->upperRight = oldTrap->upperRight;
-        D->lowerRight = oldTrap->lowerRight;
-    } else {
-        B->upperRight = oldTrap->upperRight;
-        B->lowerRight = oldTrap->upperRight;
-        C->upperRight = oldTrap->lowerRight;
-        C->lowerRight = oldTrap->lowerRight;
-    }
-    
-    // Update external neighbors
-    if (oldTrap->upperLeft) {
-        Trapezoid* target = A ? A : B;
-        if (oldTrap->upperLeft->upperRight == oldTrap) 
-            oldTrap->upperLeft->upperRight = target;
-        if (oldTrap->upperLeft->lowerRight == oldTrap) 
-            oldTrap->upperLeft->lowerRight = target;
-    }
-    if (oldTrap->lowerLeft) {
-        Trapezoid* target = A ? A : C;
-        if (oldTrap->lowerLeft->upperRight == oldTrap) 
-            oldTrap->lowerLeft->upperRight = target;
-        if (oldTrap->lowerLeft->lowerRight == oldTrap) 
-            oldTrap->lowerLeft->lowerRight = target;
-    }
-    if (oldTrap->upperRight) {
-        Trapezoid* target = D ? D : B;
-        if (oldTrap->upperRight->upperLeft == oldTrap) 
-            oldTrap->upperRight->upperLeft = target;
-        if (oldTrap->upperRight->lowerLeft == oldTrap) 
-            oldTrap->upperRight->lowerLeft = target;
-    }
-    if (oldTrap->lowerRight) {
-        Trapezoid* target = D ? D : C;
-        if (oldTrap->lowerRight->upperLeft == oldTrap) 
-            oldTrap->lowerRight->upperLeft = target;
-        if (oldTrap->lowerRight->lowerLeft == oldTrap) 
-            oldTrap->lowerRight->lowerLeft = target;
-    }
+    TRACE_DEBUG("Need left trap: " << (A != NULL) << ", Need right trap: " << (D != NULL));
     
     // Create leaf nodes for all trapezoids
-    Node* aNode = NULL;
-    Node* bNode = NULL;
-    Node* cNode = NULL;
-    Node* dNode = NULL;
-    
-    if (A) {
-        aNode = new Node();
-        aNode->type = LEAF_NODE;
-        aNode->trapezoid = A;
-        A->node = aNode;
-    }
-    
-    bNode = new Node();
-    bNode->type = LEAF_NODE;
-    bNode->trapezoid = B;
-    B->node = bNode;
-    
-    cNode = new Node();
-    cNode->type = LEAF_NODE;
-    cNode->trapezoid = C;
-    C->node = cNode;
-    
-    if (D) {
-        dNode = new Node();
-        dNode->type = LEAF_NODE;
-        dNode->trapezoid = D;
-        D->node = dNode;
-    }
+    Node* aNode = A ? makeLeafNode(map, A) : NULL;
+    Node* bNode = makeLeafNode(map, B);
+    Node* cNode = makeLeafNode(map, C);
+    Node* dNode = D ? makeLeafNode(map, D) : NULL;
     
     // Build the search structure based on which trapezoids exist
     Node* oldNode = oldTrap->node;
     
     if (oldNode) {
-        // Y-node to split B and C
-        Node* sNode = new Node();
-        sNode->type = Y_NODE;
-        sNode->segment = seg;
-        sNode->above = bNode;
-        sNode->below = cNode;
-        
-        if (needLeftTrap && needRightTrap) {
+        if (A && D) {
             // Case 1: A, B, C, D all exist (4 trapezoids)
             // Structure: X_NODE(left) -> [A | X_NODE(right) -> [Y_NODE(seg) -> [B | C] | D]]
-            Node* qNode = new Node();
-            qNode->type = X_NODE;
-            qNode->point = right;
-            qNode->left = sNode;
-            qNode->right = dNode;
-            
-            oldNode->type = X_NODE;
-            oldNode->point = left;
-            oldNode->left = aNode;
-            oldNode->right = qNode;
+            Node* sNode = map.newNode();
+            makeYNode(sNode, seg, bNode, cNode);
+            Node* qNode = map.newNode();
+            makeXNode(qNode, right, sNode, dNode);
+            makeXNode(oldNode, left, aNode, qNode);
             
-        } else if (needLeftTrap && !needRightTrap) {
+        } else if (A) {
             // Case 2: A, B, C exist (3 trapezoids, no right cap)
             // Structure: X_NODE(left) -> [A | Y_NODE(seg) -> [B | C]]
-            oldNode->type = X_NODE;
-            oldNode->point = left;
-            oldNode->left = aNode;
-            oldNode->right = sNode;
+            Node* sNode = map.newNode();
+            makeYNode(sNode, seg, bNode, cNode);
+            makeXNode(oldNode, left, aNode, sNode);
             
-        } else if (!needLeftTrap && needRightTrap) {
+        } else if (D) {
             // Case 3: B, C, D exist (3 trapezoids, no left cap)
             // Structure: X_NODE(right) -> [Y_NODE(seg) -> [B | C] | D]
-            oldNode->type = X_NODE;
-            oldNode->point = right;
-            oldNode->left = sNode;
-            oldNode->right = dNode;
+            Node* sNode = map.newNode();
+            makeYNode(sNode, seg, bNode, cNode);
+            makeXNode(oldNode, right, sNode, dNode);
             
         } else {
             // Case 4: Only B, C exist (2 trapezoids)
             // Structure: Y_NODE(seg) -> [B | C]
-            oldNode->type = Y_NODE;
-            oldNode->segment = seg;
-            oldNode->above = bNode;
-            oldNode->below = cNode;
-        }
-        
-        // Clear old leaf node data
-        oldNode->trapezoid = NULL;
-        if (oldNode->type != Y_NODE || needLeftTrap || needRightTrap) {
-            oldNode->segment = NULL;
-            oldNode->above = NULL;
-            oldNode->below = NULL;
-        }
-        if (oldNode->type != X_NODE) {
-            oldNode->left = NULL;
-            oldNode->right = NULL;
+            makeYNode(oldNode, seg, bNode, cNode);
         }
+        updateDepths(map, oldNode);
     }
     
     // Update trapezoid list
@@ -331,14 +484,8 @@ void insertInSingleTrapezoid(TrapezoidalMap& map, Trapezoid* oldTrap, Segment* s
     map.addTrapezoid(C);
     if (D) map.addTrapezoid(D);
     
-    int numTraps = (A ? 1 : 0) + 2 + (D ? 1 : 0);
-    cout << "Created " << numTraps << " trapezoid(s): ";
-    if (A) cout << "A ";
-    cout << "B C ";
-    if (D) cout << "D";
-    cout << endl;
-    
-    delete oldTrap;
+    TRACE_DEBUG("Created " << (A ? 1 : 0) + 2 + (D ? 1 : 0) << " trapezoid(s): "
+                << (A ? "A " : "") << "B C " << (D ? "D" : ""));
 }
 
 void insertAcrossMultipleTrapezoids(TrapezoidalMap& map,
@@ -346,257 +493,448 @@ void insertAcrossMultipleTrapezoids(TrapezoidalMap& map,
                                     Segment* seg) {
     if (intersected.empty()) return;
     
-    cout << "=== Multiple trapezoid insertion ===" << endl;
-    cout << "Intersecting " << intersected.size() << " trapezoids" << endl;
+    TRACE_DEBUG("=== Multiple trapezoid insertion ===");
+    TRACE_DEBUG("Intersecting " << intersected.size() << " trapezoids");
     
     Point left = seg->getLeftEndpoint();
     Point right = seg->getRightEndpoint();
+    size_t k = intersected.size();
     
-    vector<Trapezoid*> upper;
-    vector<Trapezoid*> lower;
-    Trapezoid* leftTrap = NULL;
-    Trapezoid* rightTrap = NULL;
+    // upper[i] / lower[i] is the trapezoid above / below the segment inside
+    // intersected[i]. Consecutive entries are shared when the wall between two
+    // intersected trapezoids is cut away by the segment.
+    vector<Trapezoid*> upper(k);
+    vector<Trapezoid*> lower(k);
+    vector<Trapezoid*> created;
     
-    bool needLeftTrap = (intersected[0]->leftp.x < left.x - 1e-9);
-    bool needRightTrap = (intersected.back()->rightp.x > right.x + 1e-9);
-    
-    if (needLeftTrap) {
-        leftTrap = new Trapezoid();
-        leftTrap->leftp = intersected[0]->leftp;
-        leftTrap->rightp = left;
-        leftTrap->top = intersected[0]->top;
-        leftTrap->bottom = intersected[0]->bottom;
-        leftTrap->upperLeft = intersected[0]->upperLeft;
-        leftTrap->lowerLeft = intersected[0]->lowerLeft;
-        
-        cout << "Created left trap" << endl;
-    }
+    Trapezoid* upperTrap = map.newTrapezoid();
+    upperTrap->leftp = left;
+    upperTrap->top = intersected[0]->top;
+    upperTrap->bottom = seg;
+    created.push_back(upperTrap);
     
-    for (size_t i = 0; i < intersected.size(); i++) {
-        Trapezoid* t = intersected[i];
-        
-        Point lp = t->leftp;
-        Point rp = t->rightp;
+    Trapezoid* lowerTrap = map.newTrapezoid();
+    lowerTrap->leftp = left;
+    lowerTrap->top = seg;
+    lowerTrap->bottom = intersected[0]->bottom;
+    created.push_back(lowerTrap);
+    
+    upper[0] = upperTrap;
+    lower[0] = lowerTrap;
+    
+    for (size_t i = 1; i < k; i++) {
+        Trapezoid* prev = intersected[i - 1];
+        Trapezoid* cur = intersected[i];
+        Point r = prev->rightp;
         
-        if (i == 0 && lp.x < left.x - 1e-9) {
-            lp = left;
-        }
-        if (i == intersected.size() - 1 && rp.x > right.x + 1e-9) {
-            rp = right;
+        int side = sideOf(*seg, r);
+        if (side > 0) {
+            // The wall through r survives above the segment and is cut away
+            // below it: close the upper trapezoid, keep extending the lower one
+            Trapezoid* next = map.newTrapezoid();
+            next->leftp = r;
+            next->top = cur->top;
+            next->bottom = seg;
+            created.push_back(next);
+            
+            upperTrap->rightp = r;
+            upperTrap->upperRight = (prev->upperRight != cur) ? prev->upperRight : next;
+            upperTrap->lowerRight = next;
+            if (prev->upperRight != cur) replaceLeftNeighbor(prev->upperRight, prev, upperTrap);
+            
+            next->upperLeft = (cur->upperLeft != prev) ? cur->upperLeft : upperTrap;
+            next->lowerLeft = upperTrap;
+            if (cur->upperLeft != prev) replaceRightNeighbor(cur->upperLeft, cur, next);
+            
+            upperTrap = next;
+        } else if (side < 0) {
+            Trapezoid* next = map.newTrapezoid();
+            next->leftp = r;
+            next->top = seg;
+            next->bottom = cur->bottom;
+            created.push_back(next);
+            
+            lowerTrap->rightp = r;
+            lowerTrap->lowerRight = (prev->lowerRight != cur) ? prev->lowerRight : next;
+            lowerTrap->upperRight = next;
+            if (prev->lowerRight != cur) replaceLeftNeighbor(prev->lowerRight, prev, lowerTrap);
+            
+            next->lowerLeft = (cur->lowerLeft != prev) ? cur->lowerLeft : lowerTrap;
+            next->upperLeft = lowerTrap;
+            if (cur->lowerLeft != prev) replaceRightNeighbor(cur->lowerLeft, cur, next);
+            
+            lowerTrap = next;
+        } else {
+            // r is a vertex on the segment, where another obstacle touches
+            // it: the walls above and below r both survive, so both pieces
+            // end at r and new ones start
+            Trapezoid* nextUpper = map.newTrapezoid();
+            nextUpper->leftp = r;
+            nextUpper->top = cur->top;
+            nextUpper->bottom = seg;
+            created.push_back(nextUpper);
+            
+            Trapezoid* nextLower = map.newTrapezoid();
+            nextLower->leftp = r;
+            nextLower->top = seg;
+            nextLower->bottom = cur->bottom;
+            created.push_back(nextLower);
+            
+            upperTrap->rightp = r;
+            lowerTrap->rightp = r;
+            linkAtVertex(prev, cur, upperTrap, nextUpper, r, true);
+            linkAtVertex(prev, cur, lowerTrap, nextLower, r, false);
+            
+            upperTrap = nextUpper;
+            lowerTrap = nextLower;
         }
         
-        Trapezoid* upperTrap = new Trapezoid();
-        upperTrap->leftp = lp;
-        upperTrap->rightp = rp;
-        upperTrap->top = t->top;
-        upperTrap->bottom = seg;
-        
-        Trapezoid* lowerTrap = new Trapezoid();
-        lowerTrap->leftp = lp;
-        lowerTrap->rightp = rp;
-        lowerTrap->top = seg;
-        lowerTrap->bottom = t->bottom;
-        
-        upper.push_back(upperTrap);
-        lower.push_back(lowerTrap);
-        
-        cout << "Created upper/lower pair " << i << endl;
+        upper[i] = upperTrap;
+        lower[i] = lowerTrap;
     }
+    upperTrap->rightp = right;
+    lowerTrap->rightp = right;
     
-    if (needRightTrap) {
-        rightTrap = new Trapezoid();
-        rightTrap->leftp = right;
-        rightTrap->rightp = intersected.back()->rightp;
-        rightTrap->top = intersected.back()->top;
-        rightTrap->bottom = intersected.back()->bottom;
-        rightTrap->upperRight = intersected.back()->upperRight;
-        rightTrap->lowerRight = intersected.back()->lowerRight;
-        
-        cout << "Created right trap" << endl;
+    Trapezoid* leftTrap = splitLeftEnd(map, intersected[0], upper[0], lower[0], left);
+    Trapezoid* rightTrap = splitRightEnd(map, intersected.back(), upper.back(), lower.back(), right);
+    
+    if (leftTrap) TRACE_DEBUG("Created left trap");
+    if (rightTrap) TRACE_DEBUG("Created right trap");
+    TRACE_DEBUG("Created " << created.size() << " trapezoids along the segment");
+    
+    for (Trapezoid* t : created) {
+        makeLeafNode(map, t);
     }
     
-    for (size_t i = 0; i < upper.size(); i++) {
-        if (i > 0) {
-            upper[i]->upperLeft = upper[i-1];
-            upper[i]->lowerLeft = upper[i-1];
-            upper[i-1]->upperRight = upper[i];
-            upper[i-1]->lowerRight = upper[i];
+    // Update DAG
+    for (size_t i = 0; i < k; i++) {
+        Node* oldNode = intersected[i]->node;
+        if (!oldNode) continue;
+        
+        if (i == 0 && leftTrap) {
+            Node* yNode = map.newNode();
+            makeYNode(yNode, seg, upper[i]->node, lower[i]->node);
+            makeXNode(oldNode, left, makeLeafNode(map, leftTrap), yNode);
             
-            lower[i]->upperLeft = lower[i-1];
-            lower[i]->lowerLeft = lower[i-1];
-            lower[i-1]->upperRight = lower[i];
-            lower[i-1]->lowerRight = lower[i];
+        } else if (i == k - 1 && rightTrap) {
+            Node* yNode = map.newNode();
+            makeYNode(yNode, seg, upper[i]->node, lower[i]->node);
+            makeXNode(oldNode, right, yNode, makeLeafNode(map, rightTrap));
+            
+        } else {
+            makeYNode(oldNode, seg, upper[i]->node, lower[i]->node);
         }
     }
+    for (size_t i = 0; i < k; i++) {
+        if (intersected[i]->node) updateDepths(map, intersected[i]->node);
+    }
     
-    // Update neighbours
-    if (leftTrap) {
-        leftTrap->upperRight = upper[0];
-        leftTrap->lowerRight = lower[0];
-        upper[0]->upperLeft = leftTrap;
-        upper[0]->lowerLeft = leftTrap;
-        lower[0]->upperLeft = leftTrap;
-        lower[0]->lowerLeft = leftTrap;
-        
-        if (intersected[0]->upperLeft) {
-            if (intersected[0]->upperLeft->upperRight == intersected[0])
-                intersected[0]->upperLeft->upperRight = leftTrap;
-            if (intersected[0]->upperLeft->lowerRight == intersected[0])
-                intersected[0]->upperLeft->lowerRight = leftTrap;
+    // Update trapezoid list
+    for (Trapezoid* t : intersected) {
+        map.removeTrapezoid(t);
+    }
+    if (leftTrap) map.addTrapezoid(leftTrap);
+    for (Trapezoid* t : created) {
+        map.addTrapezoid(t);
+    }
+    if (rightTrap) map.addTrapezoid(rightTrap);
+    
+    TRACE_DEBUG("Finished multiple trapezoid insertion");
+}
+
+Segment* findSegment(Node* root, const Segment& seg) {
+    // Right above a segment of the map, its own y-node sends the query up
+    Node* leaf = locateSegmentStart(root, seg, true);
+    if (!leaf || !leaf->trapezoid) return NULL;
+    Segment* below = leaf->trapezoid->bottom;
+    if (!below || !(below->p1 == seg.p1) || !(below->p2 == seg.p2)) return NULL;
+    return below;
+}
+
+// The trapezoids along one side of seg, left to right
+static bool collectSide(Trapezoid* t, const Segment* seg, bool above, vector<Trapezoid*>& side) {
+    Point right = seg->getRightEndpoint();
+    while (t && (above ? t->bottom : t->top) == seg) {
+        side.push_back(t);
+        if (!(t->rightp < right)) return true;
+        t = above ? t->lowerRight : t->upperRight;
+    }
+    return false;
+}
+
+// Whether a segment other than seg ends at p, an endpoint of seg. Any such
+// segment bounds one of the trapezoids next to seg at p (above, below) or
+// one of their neighbours across the walls through p.
+static bool endpointShared(const Segment* seg, const Point& p,
+                           Trapezoid* above, Trapezoid* below, bool leftEnd) {
+    Trapezoid* around[6] = {
+        above, below,
+        leftEnd ? above->upperLeft : above->upperRight,
+        leftEnd ? above->lowerLeft : above->lowerRight,
+        leftEnd ? below->upperLeft : below->upperRight,
+        leftEnd ? below->lowerLeft : below->lowerRight
+    };
+    for (Trapezoid* t : around) {
+        if (!t) continue;
+        for (const Segment* s : {t->top, t->bottom}) {
+            if (s && s != seg && (s->p1 == p || s->p2 == p)) return true;
         }
-        if (intersected[0]->lowerLeft) {
-            if (intersected[0]->lowerLeft->upperRight == intersected[0])
-                intersected[0]->lowerLeft->upperRight = leftTrap;
-            if (intersected[0]->lowerLeft->lowerRight == intersected[0])
-                intersected[0]->lowerLeft->lowerRight = leftTrap;
+    }
+    return false;
+}
+
+// The single trapezoid beyond the walls through an endpoint nothing else
+// uses, provided it spans both of them
+static Trapezoid* acrossEndpoint(Trapezoid* above, Trapezoid* below, bool leftEnd) {
+    Trapezoid* t = leftEnd ? above->upperLeft : above->upperRight;
+    bool spans = t &&
+        t == (leftEnd ? above->lowerLeft : above->lowerRight) &&
+        t == (leftEnd ? below->upperLeft : below->upperRight) &&
+        t == (leftEnd ? below->lowerLeft : below->lowerRight) &&
+        t->top == above->top && t->bottom == below->bottom;
+    return spans ? t : NULL;
+}
+
+// Set t's neighbours on one side from a top-to-bottom candidate list that
+// may contain NULLs and repeats
+static void setNeighbors(Trapezoid* t, const vector<Trapezoid*>& candidates, bool left) {
+    Trapezoid* found[2] = {NULL, NULL};
+    size_t n = 0;
+    for (Trapezoid* c : candidates) {
+        if (!c || (n > 0 && found[n - 1] == c)) continue;
+        if (n == 2) {
+            TRACE_ERROR("Trapezoid with more than two " << (left ? "left" : "right") << " neighbours");
+            break;
         }
+        found[n++] = c;
+    }
+    Trapezoid* upper = found[0];
+    Trapezoid* lower = n == 2 ? found[1] : found[0];
+    if (left) {
+        t->upperLeft = upper;
+        t->lowerLeft = lower;
     } else {
-        upper[0]->upperLeft = intersected[0]->upperLeft;
-        upper[0]->lowerLeft = intersected[0]->upperLeft;
-        lower[0]->upperLeft = intersected[0]->lowerLeft;
-        lower[0]->lowerLeft = intersected[0]->lowerLeft;
-        
-        if (intersected[0]->upperLeft) {
-            if (intersected[0]->upperLeft->upperRight == intersected[0])
-                intersected[0]->upperLeft->upperRight = upper[0];
-            if (intersected[0]->upperLeft->lowerRight == intersected[0])
-                intersected[0]->upperLeft->lowerRight = upper[0];
+        t->upperRight = upper;
+        t->lowerRight = lower;
+    }
+}
+
+// Turn node into a balanced tree of x-nodes over merged[first..last],
+// splitting at the walls between them
+static void makeXTree(TrapezoidalMap& map, Node* node, const vector<Trapezoid*>& merged,
+                      size_t first, size_t last) {
+    if (first == last) {
+        // Nothing to tell apart; both sides lead to the one trapezoid
+        makeXNode(node, merged[first]->leftp, merged[first]->node, merged[first]->node);
+        return;
+    }
+    size_t mid = (first + last) / 2;
+    Node* left = merged[first]->node;
+    if (mid > first) {
+        left = map.newNode();
+        makeXTree(map, left, merged, first, mid);
+    }
+    Node* right = merged[last]->node;
+    if (last > mid + 1) {
+        right = map.newNode();
+        makeXTree(map, right, merged, mid + 1, last);
+    }
+    makeXNode(node, merged[mid]->rightp, left, right);
+}
+
+bool deleteSegment(TrapezoidalMap& map, Segment* seg, vector<Trapezoid*>& removed) {
+    Point left = seg->getLeftEndpoint();
+    Point right = seg->getRightEndpoint();
+    
+    Node* aboveStart = locateSegmentStart(map.root, *seg, true);
+    Node* belowStart = locateSegmentStart(map.root, *seg, false);
+    vector<Trapezoid*> above, below;
+    if (!aboveStart || !belowStart ||
+        !collectSide(aboveStart->trapezoid, seg, true, above) ||
+        !collectSide(belowStart->trapezoid, seg, false, below)) {
+        TRACE_ERROR("Segment to delete is not in the map");
+        return false;
+    }
+    
+    // An endpoint nobody else uses loses its walls, and the trapezoid on the
+    // far side of them joins the merged ones
+    Trapezoid* leftTrap = NULL;
+    Trapezoid* rightTrap = NULL;
+    if (!endpointShared(seg, left, above.front(), below.front(), true)) {
+        leftTrap = acrossEndpoint(above.front(), below.front(), true);
+        if (!leftTrap) {
+            TRACE_ERROR("Unexpected trapezoids left of the deleted segment");
+            return false;
         }
-        if (intersected[0]->lowerLeft) {
-            if (intersected[0]->lowerLeft->upperRight == intersected[0])
-                intersected[0]->lowerLeft->upperRight = lower[0];
-            if (intersected[0]->lowerLeft->lowerRight == intersected[0])
-                intersected[0]->lowerLeft->lowerRight = lower[0];
+    }
+    if (!endpointShared(seg, right, above.back(), below.back(), false)) {
+        rightTrap = acrossEndpoint(above.back(), below.back(), false);
+        if (!rightTrap) {
+            TRACE_ERROR("Unexpected trapezoids right of the deleted segment");
+            return false;
         }
     }
     
-    if (rightTrap) {
-        rightTrap->upperLeft = upper.back();
-        rightTrap->lowerLeft = lower.back();
-        upper.back()->upperRight = rightTrap;
-        upper.back()->lowerRight = rightTrap;
-        lower.back()->upperRight = rightTrap;
-        lower.back()->lowerRight = rightTrap;
+    TRACE_DEBUG("=== Segment deletion ===");
+    TRACE_DEBUG("Merging " << above.size() << " trapezoids above with " << below.size() << " below");
+    
+    // 1. Every wall that ended on the segment now runs on to the far side,
+    // so the merged trapezoids are the slabs between consecutive walls of
+    // either side. aboveFirst[i] .. aboveLast[i] are the slabs above[i]
+    // overlaps, likewise for below.
+    size_t a = above.size(), b = below.size();
+    vector<size_t> aboveFirst(a), aboveLast(a), belowFirst(b), belowLast(b);
+    vector<size_t> slabAbove, slabBelow;        // slab -> index into above / below
+    vector<Trapezoid*> merged;
+    
+    Trapezoid* cur = map.newTrapezoid();
+    cur->leftp = leftTrap ? leftTrap->leftp : left;
+    size_t i = 0, j = 0;
+    aboveFirst[0] = belowFirst[0] = 0;
+    for (;;) {
+        cur->top = above[i]->top;
+        cur->bottom = below[j]->bottom;
+        merged.push_back(cur);
+        slabAbove.push_back(i);
+        slabBelow.push_back(j);
+        if (i == a - 1 && j == b - 1) break;
         
-        if (intersected.back()->upperRight) {
-            if (intersected.back()->upperRight->upperLeft == intersected.back())
-                intersected.back()->upperRight->upperLeft = rightTrap;
-            if (intersected.back()->upperRight->lowerLeft == intersected.back())
-                intersected.back()->upperRight->lowerLeft = rightTrap;
+        bool wallAbove = (j == b - 1) || (i < a - 1 && above[i]->rightp < below[j]->rightp);
+        Point wall = wallAbove ? above[i]->rightp : below[j]->rightp;
+        cur->rightp = wall;
+        size_t k = merged.size();
+        if (wallAbove) {
+            aboveLast[i] = k - 1;
+            aboveFirst[++i] = k;
+        } else {
+            belowLast[j] = k - 1;
+            belowFirst[++j] = k;
         }
-        if (intersected.back()->lowerRight) {
-            if (intersected.back()->lowerRight->upperLeft == intersected.back())
-                intersected.back()->lowerRight->upperLeft = rightTrap;
-            if (intersected.back()->lowerRight->lowerLeft == intersected.back())
-                intersected.back()->lowerRight->lowerLeft = rightTrap;
+        cur = map.newTrapezoid();
+        cur->leftp = wall;
+    }
+    cur->rightp = rightTrap ? rightTrap->rightp : right;
+    aboveLast[a - 1] = belowLast[b - 1] = merged.size() - 1;
+    size_t last = merged.size() - 1;
+    
+    // Old trapezoids are the ones bounded by seg plus the two absorbed ones
+    auto replacement = [&](Trapezoid* t, size_t slab) -> Trapezoid* {
+        bool old = t && (t->top == seg || t->bottom == seg || t == leftTrap || t == rightTrap);
+        return old ? merged[slab] : t;
+    };
+    
+    // 2. Neighbours of the merged trapezoids. Across an inner wall the side
+    // the wall comes from contributes its old neighbours, the other side
+    // just continues into the next slab.
+    vector<Trapezoid*> candidates;
+    for (size_t k = 0; k <= last; k++) {
+        Trapezoid* up = above[slabAbove[k]];
+        Trapezoid* down = below[slabBelow[k]];
+        
+        candidates.clear();
+        if (k == 0 && leftTrap) {
+            candidates.push_back(leftTrap->upperLeft);
+            candidates.push_back(leftTrap->lowerLeft);
+        } else {
+            bool upWall = aboveFirst[slabAbove[k]] == k;
+            bool downWall = belowFirst[slabBelow[k]] == k;
+            candidates.push_back(replacement(upWall ? up->upperLeft : up, k - (k > 0)));
+            candidates.push_back(replacement(upWall ? up->lowerLeft : up, k - (k > 0)));
+            candidates.push_back(replacement(downWall ? down->upperLeft : down, k - (k > 0)));
+            candidates.push_back(replacement(downWall ? down->lowerLeft : down, k - (k > 0)));
         }
-    } else {
-        upper.back()->upperRight = intersected.back()->upperRight;
-        upper.back()->lowerRight = intersected.back()->upperRight;
-        lower.back()->upperRight = intersected.back()->lowerRight;
-        lower.back()->lowerRight = intersected.back()->lowerRight;
+        setNeighbors(merged[k], candidates, true);
         
-        if (intersected.back()->upperRight) {
-            if (intersected.back()->upperRight->upperLeft == intersected.back())
-                intersected.back()->upperRight->upperLeft = upper.back();
-            if (intersected.back()->upperRight->lowerLeft == intersected.back())
-                intersected.back()->upperRight->lowerLeft = upper.back();
+        candidates.clear();
+        if (k == last && rightTrap) {
+            candidates.push_back(rightTrap->upperRight);
+            candidates.push_back(rightTrap->lowerRight);
+        } else {
+            bool upWall = aboveLast[slabAbove[k]] == k;
+            bool downWall = belowLast[slabBelow[k]] == k;
+            size_t next = k + (k < last);
+            candidates.push_back(replacement(upWall ? up->upperRight : up, next));
+            candidates.push_back(replacement(upWall ? up->lowerRight : up, next));
+            candidates.push_back(replacement(downWall ? down->upperRight : down, next));
+            candidates.push_back(replacement(downWall ? down->lowerRight : down, next));
         }
-        if (intersected.back()->lowerRight) {
-            if (intersected.back()->lowerRight->upperLeft == intersected.back())
-                intersected.back()->lowerRight->upperLeft = lower.back();
-            if (intersected.back()->lowerRight->lowerLeft == intersected.back())
-                intersected.back()->lowerRight->lowerLeft = lower.back();
+        setNeighbors(merged[k], candidates, false);
+    }
+    
+    // 3. Trapezoids outside that pointed at an old one now point at the
+    // merged trapezoid on their side
+    vector<Trapezoid*> olds;
+    vector<size_t> oldFirst, oldLast;
+    for (size_t k = 0; k < a; k++) {
+        olds.push_back(above[k]);
+        oldFirst.push_back(aboveFirst[k]);
+        oldLast.push_back(aboveLast[k]);
+    }
+    for (size_t k = 0; k < b; k++) {
+        olds.push_back(below[k]);
+        oldFirst.push_back(belowFirst[k]);
+        oldLast.push_back(belowLast[k]);
+    }
+    if (leftTrap) {
+        olds.push_back(leftTrap);
+        oldFirst.push_back(0);
+        oldLast.push_back(0);
+    }
+    if (rightTrap) {
+        olds.push_back(rightTrap);
+        oldFirst.push_back(last);
+        oldLast.push_back(last);
+    }
+    for (size_t k = 0; k < olds.size(); k++) {
+        Trapezoid* t = olds[k];
+        for (Trapezoid* n : {t->upperLeft, t->lowerLeft}) {
+            if (replacement(n, 0) == n) replaceRightNeighbor(n, t, merged[oldFirst[k]]);
+        }
+        for (Trapezoid* n : {t->upperRight, t->lowerRight}) {
+            if (replacement(n, 0) == n) replaceLeftNeighbor(n, t, merged[oldLast[k]]);
         }
     }
     
-    // Update DAG
-    for (size_t i = 0; i < intersected.size(); i++) {
-        Node* oldNode = intersected[i]->node;
-        if (!oldNode) continue;
-        
-        Node* upperNode = new Node();
-        upperNode->type = LEAF_NODE;
-        upperNode->trapezoid = upper[i];
-        upper[i]->node = upperNode;
-        
-        Node* lowerNode = new Node();
-        lowerNode->type = LEAF_NODE;
-        lowerNode->trapezoid = lower[i];
-        lower[i]->node = lowerNode;
-        
-        if (i == 0 && leftTrap) {
-            Node* leftNode = new Node();
-            leftNode->type = LEAF_NODE;
-            leftNode->trapezoid = leftTrap;
-            leftTrap->node = leftNode;
-            
-            Node* yNode = new Node();
-            yNode->type = Y_NODE;
-            yNode->segment = seg;
-            yNode->above = upperNode;
-            yNode->below = lowerNode;
-            
-            oldNode->type = X_NODE;
-            oldNode->point = left;
-            oldNode->left = leftNode;
-            oldNode->right = yNode;
-            oldNode->trapezoid = NULL;
-            oldNode->segment = NULL;
-            oldNode->above = NULL;
-            oldNode->below = NULL;
-            
-            map.addTrapezoid(leftTrap);
-            
-        } else if (i == intersected.size() - 1 && rightTrap) {
-            Node* yNode = new Node();
-            yNode->type = Y_NODE;
-            yNode->segment = seg;
-            yNode->above = upperNode;
-            yNode->below = lowerNode;
-            
-            Node* rightNode = new Node();
-            rightNode->type = LEAF_NODE;
-            rightNode->trapezoid = rightTrap;
-            rightTrap->node = rightNode;
-            
-            oldNode->type = X_NODE;
-            oldNode->point = right;
-            oldNode->left = yNode;
-            oldNode->right = rightNode;
-            oldNode->trapezoid = NULL;
-            oldNode->segment = NULL;
-            oldNode->above = NULL;
-            oldNode->below = NULL;
-            
-            map.addTrapezoid(rightTrap);
-            
-        } else {
-            oldNode->type = Y_NODE;
-            oldNode->segment = seg;
-            oldNode->above = upperNode;
-            oldNode->below = lowerNode;
-            oldNode->trapezoid = NULL;
-            oldNode->point = Point(0, 0);
-            oldNode->left = NULL;
-            oldNode->right = NULL;
+    // 4. Search structure. An old leaf covering a single merged trapezoid
+    // becomes that trapezoid's leaf if it has none yet, so queries there get
+    // no deeper; the rest turn into x-node trees over the merged ones.
+    vector<bool> adopted(olds.size(), false);
+    for (size_t k = 0; k < olds.size(); k++) {
+        Node* node = olds[k]->node;
+        Trapezoid* only = merged[oldFirst[k]];
+        if (node && oldFirst[k] == oldLast[k] && !only->node) {
+            node->trapezoid = only;
+            only->node = node;
+            adopted[k] = true;
         }
-        
-        map.removeTrapezoid(intersected[i]);
-        map.addTrapezoid(upper[i]);
-        map.addTrapezoid(lower[i]);
-        
-        delete intersected[i];
+    }
+    for (Trapezoid* t : merged) {
+        if (!t->node) makeLeafNode(map, t);
+    }
+    for (size_t k = 0; k < olds.size(); k++) {
+        Node* node = olds[k]->node;
+        if (!node || adopted[k]) continue;
+        makeXTree(map, node, merged, oldFirst[k], oldLast[k]);
+        updateDepths(map, node);
+    }
+    
+    // 5. Trapezoid list
+    for (Trapezoid* t : olds) {
+        if (map.contains(t)) map.removeTrapezoid(t);
+        removed.push_back(t);
+    }
+    for (Trapezoid* t : merged) {
+        map.addTrapezoid(t);
     }
     
-    cout << "Finished multiple trapezoid insertion" << endl;
+    TRACE_DEBUG("Replaced " << olds.size() << " trapezoids by " << merged.size());
+    return true;
 }
 
-TrapezoidalMap BuildTrapezoidalMap(vector<Segment>& S) {
-    TrapezoidalMap map;
-    
-    if (S.empty()) return map;
-    
+// Insert S in the given order into an empty map. Stops early and returns
+// false as soon as the DAG gets deeper than depthLimit.
+static bool insertSegments(TrapezoidalMap& map, const vector<Segment>& S,
+                           const vector<size_t>& order, int depthLimit) {
     double minX = 1e9, maxX = -1e9;
     double minY = 1e9, maxY = -1e9;
     
@@ -611,46 +949,31 @@ TrapezoidalMap BuildTrapezoidalMap(vector<Segment>& S) {
     minX -= margin; maxX += margin;
     minY -= margin; maxY += margin;
     
-    Segment* topBound = new Segment(Point(minX, maxY), Point(maxX, maxY));
-    Segment* bottomBound = new Segment(Point(minX, minY), Point(maxX, minY));
+    Segment* topBound = map.newSegment(Segment(Point(minX, maxY), Point(maxX, maxY)));
+    Segment* bottomBound = map.newSegment(Segment(Point(minX, minY), Point(maxX, minY)));
     
-    Trapezoid* initialTrap = new Trapezoid();
+    Trapezoid* initialTrap = map.newTrapezoid();
     initialTrap->leftp = Point(minX, (minY + maxY) / 2.0);
     initialTrap->rightp = Point(maxX, (minY + maxY) / 2.0);
     initialTrap->top = topBound;
     initialTrap->bottom = bottomBound;
     
-    Node* root = new Node();
-    root->type = LEAF_NODE;
-    root->trapezoid = initialTrap;
-    initialTrap->node = root;
-    
-    map.root = root;
+    map.root = makeLeafNode(map, initialTrap);
     map.addTrapezoid(initialTrap);
-    map.segments.push_back(topBound);
-    map.segments.push_back(bottomBound);
-    
-    srand(static_cast<unsigned>(time(0)));
-    // for (size_t i = 0; i < S.size(); i++) {
-    //     size_t j = i + rand() % (S.size() - i);
-    //     swap(S[i], S[j]);
-    // }
     
-    for (size_t i = 0; i < S.size(); i++) {
-        Segment* seg = new Segment(S[i]);
-        map.segments.push_back(seg);
+    for (size_t i = 0; i < order.size(); i++) {
+        Segment* seg = map.newSegment(S[order[i]]);
         
-        cout << "\n========================================" << endl;
-        cout << "Inserting segment " << i << ": (" << seg->p1.x << "," << seg->p1.y 
-             << ") -> (" << seg->p2.x << "," << seg->p2.y << ")" << endl;
+        TRACE_DEBUG("Inserting segment " << order[i] << ": (" << seg->p1.x << "," << seg->p1.y 
+                    << ") -> (" << seg->p2.x << "," << seg->p2.y << ")");
         
         vector<Trapezoid*> intersected;
         findIntersectedTrapezoids(map.root, *seg, intersected);
         
-        cout << "Segment " << i << " intersects " << intersected.size() << " trapezoids" << endl;
+        TRACE_DEBUG("Segment " << order[i] << " intersects " << intersected.size() << " trapezoids");
         
         if (intersected.empty()) {
-            cout << "WARNING: Segment doesn't intersect any trapezoids" << endl;
+            TRACE_WARN("Segment doesn't intersect any trapezoids");
             continue;
         }
         
@@ -659,73 +982,85 @@ TrapezoidalMap BuildTrapezoidalMap(vector<Segment>& S) {
         } else {
             insertAcrossMultipleTrapezoids(map, intersected, seg);
         }
+
         
-        cout << "========================================\n" << endl;
+        if (map.stats.maxDepth > depthLimit) {
+            return false;
+        }
     }
     
-    return map;
+    return true;
 }
 
-void deleteSearchStructure(Node* node) {
-    if (node == NULL) return;
+TrapezoidalMap BuildTrapezoidalMap(vector<Segment>& S, unsigned seed, double depthFactor) {
+    TrapezoidalMap map;
     
-    set<Node*> visited;
-    vector<Node*> toDelete;
-    vector<Node*> stack;
-    stack.push_back(node);
+    if (S.empty()) return map;
     
-    while (!stack.empty()) {
-        Node* current = stack.back();
-        stack.pop_back();
-        
-        if (current == NULL || visited.count(current) > 0) {
-            continue;
-        }
+    // Expected depth is O(log n) over random orders; a DAG much deeper than
+    // that means an unlucky shuffle, so throw it away and draw another one
+    int depthLimit = static_cast<int>(ceil(depthFactor * log(static_cast<double>(S.size()) + 1.0)));
+    
+    mt19937 rng(seed);
+    vector<size_t> order(S.size());
+    iota(order.begin(), order.end(), 0);
+    
+    for (int attempt = 1; ; attempt++) {
+        shuffle(order.begin(), order.end(), rng);
         
-        visited.insert(current);
-        toDelete.push_back(current);
+        // The last attempt is kept whatever its depth
+        bool lastAttempt = attempt == MAX_BUILD_ATTEMPTS;
+        bool ok = insertSegments(map, S, order, lastAttempt ? INT_MAX : depthLimit);
         
-        if (current->type == X_NODE) {
-            if (current->left) stack.push_back(current->left);
-            if (current->right) stack.push_back(current->right);
-        } else if (current->type == Y_NODE) {
-            if (current->above) stack.push_back(current->above);
-            if (current->below) stack.push_back(current->below);
+        if (ok) {
+            double totalDepth = 0;
+            for (Trapezoid* t : map.trapezoids) {
+                totalDepth += t->node->depth;
+            }
+            map.stats.seed = seed;
+            map.stats.attempts = attempt;
+            map.stats.avgDepth = totalDepth / map.trapezoids.size();
+            map.stats.depthLimit = depthLimit;
+            
+            TRACE_INFO("DAG depth: max " << map.stats.maxDepth << ", average "
+                       << map.stats.avgDepth << " (limit " << depthLimit << ", "
+                       << attempt << " attempt(s))");
+            return map;
         }
-    }
-    
-    for (size_t i = 0; i < toDelete.size(); i++) {
-        delete toDelete[i];
+        
+        TRACE_INFO("DAG depth passed " << depthLimit << " on attempt " << attempt
+                   << ", rebuilding with a new insertion order");
+        map.cleanup();
     }
 }
 
 void validateTrapezoid(Trapezoid* t) {
     if (t == NULL) {
-        cout << "ERROR: NULL trapezoid" << endl;
+        TRACE_ERROR("NULL trapezoid");
         return;
     }
     
     if (t->leftp.x > t->rightp.x + 1e-9) {
-        cout << "ERROR: Trapezoid has invalid x-range: left=" << t->leftp.x 
-             << " right=" << t->rightp.x << endl;
+        TRACE_ERROR("Trapezoid has invalid x-range: left=" << t->leftp.x 
+                    << " right=" << t->rightp.x);
     }
     
     if (t->top == NULL) {
-        cout << "ERROR: Trapezoid has NULL top segment" << endl;
+        TRACE_ERROR("Trapezoid has NULL top segment");
     }
     
     if (t->bottom == NULL) {
-        cout << "ERROR: Trapezoid has NULL bottom segment" << endl;
+        TRACE_ERROR("Trapezoid has NULL bottom segment");
     }
     
     if (t->node == NULL) {
-        cout << "WARNING: Trapezoid has NULL node" << endl;
+        TRACE_WARN("Trapezoid has NULL node");
     }
 }
 
 void validateSearchStructure(Node* node) {
     if (node == NULL) {
-        cout << "ERROR: NULL node in search structure" << endl;
+        TRACE_ERROR("NULL node in search structure");
         return;
     }
     
@@ -745,22 +1080,22 @@ void validateSearchStructure(Node* node) {
         
         if (current->type == LEAF_NODE) {
             if (current->trapezoid == NULL) {
-                cout << "ERROR: Leaf node has NULL trapezoid" << endl;
+                TRACE_ERROR("Leaf node has NULL trapezoid");
             } else {
                 validateTrapezoid(current->trapezoid);
             }
         } else if (current->type == X_NODE) {
             if (current->left == NULL || current->right == NULL) {
-                cout << "ERROR: X_NODE has NULL children" << endl;
+                TRACE_ERROR("X_NODE has NULL children");
             }
             if (current->left) stack.push_back(current->left);
             if (current->right) stack.push_back(current->right);
         } else if (current->type == Y_NODE) {
             if (current->segment == NULL) {
-                cout << "ERROR: Y_NODE has NULL segment" << endl;
+                TRACE_ERROR("Y_NODE has NULL segment");
             }
             if (current->above == NULL || current->below == NULL) {
-                cout << "ERROR: Y_NODE has NULL children" << endl;
+                TRACE_ERROR("Y_NODE has NULL children");
             }
             if (current->above) stack.push_back(current->above);
             if (current->below) stack.push_back(current->below);
@@ -768,25 +1103,19 @@ void validateSearchStructure(Node* node) {
     }
 }
 
-void printTrapezoid(Trapezoid* t) {
-    if (t == NULL) {
-        cout << "NULL trapezoid" << endl;
-        return;
-    }
-    
-    cout << "Trap " << t << ": left=(" << t->leftp.x << "," << t->leftp.y 
-         << ") right=(" << t->rightp.x << "," << t->rightp.y << ")" 
-         << " top=" << t->top << " bottom=" << t->bottom << endl;
+// Parameters go unused when TRACE_DEBUG is compiled out
+void printTrapezoid([[maybe_unused]] Trapezoid* t) {
+    TRACE_DEBUG(t);
 }
 
-void debugIntersection(const vector<Trapezoid*>& traps, const Segment& seg) {
-    cout << "=== DEBUG: Segment intersection ===" << endl;
-    cout << "Segment from (" << seg.p1.x << "," << seg.p1.y 
-         << ") to (" << seg.p2.x << "," << seg.p2.y << ")" << endl;
-    cout << "Intersects " << traps.size() << " trapezoids:" << endl;
+void debugIntersection([[maybe_unused]] const vector<Trapezoid*>& traps,
+                       [[maybe_unused]] const Segment& seg) {
+    TRACE_DEBUG("=== DEBUG: Segment intersection ===");
+    TRACE_DEBUG("Segment from (" << seg.p1.x << "," << seg.p1.y 
+                << ") to (" << seg.p2.x << "," << seg.p2.y << ")");
+    TRACE_DEBUG("Intersects " << traps.size() << " trapezoids:");
     for (size_t i = 0; i < traps.size(); i++) {
-        cout << "  " << i << ": ";
-        printTrapezoid(traps[i]);
+        TRACE_DEBUG("  " << i << ": " << traps[i]);
     }
-    cout << "===================================" << endl;
+    TRACE_DEBUG("===================================");
 }
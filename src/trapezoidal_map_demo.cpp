@@ -10,6 +10,9 @@
 #include "data_structure.hpp"
 #include "trapezoidal_map.hpp"
 #include "sdl_layer.hpp"
+#include "trace.hpp"
+
+static const char TRACE_MODULE[] = "trapezoidal_map_demo";
 
 void trapezoidal_map_demo() {
     // Application start
@@ -62,15 +65,15 @@ void trapezoidal_map_demo() {
     Segment(Point(92, 25), Point(68, 20))
 };
 
-    std::cout << "Building trapezoidal map..." << std::endl;
+    TRACE_INFO("Building trapezoidal map...");
     TrapezoidalMap map = BuildTrapezoidalMap(segments);
-    std::cout << "Map built. Found " << map.trapezoids.size() << " trapezoids." << std::endl;
+    TRACE_INFO("Map built. Found " << map.trapezoids.size() << " trapezoids.");
 
     std::map<Node*, NodePosition> dagPositions;
     std::map<int, int> levelCounters;
     int nodeCounter = 0;
     calculateDAGLayout(map.root, dagPositions, 0, nodeCounter, levelCounters);
-    std::cout << "DAG has " << dagPositions.size() << " nodes." << std::endl;
+    TRACE_INFO("DAG has " << dagPositions.size() << " nodes.");
 
     bool running = true;
     SDL_Event event;
@@ -91,13 +94,13 @@ void trapezoidal_map_demo() {
                         SDL_Point mousePos = {mouseX, mouseY};
                         Point worldPos = screenToWorld(mousePos);
                         
-                        std::cout << "Querying map at (" << worldPos.x << ", " << worldPos.y << ")" << std::endl;
+                        TRACE_INFO("Querying map at (" << worldPos.x << ", " << worldPos.y << ")");
 
                         Node* leaf = queryTrapezoidMap(map.root, worldPos);
                         if (leaf && leaf->type == LEAF_NODE) {
                             highlightedTrap = leaf->trapezoid;
                             highlightedNode = leaf;
-                            std::cout << "Found trapezoid at leaf node." << std::endl;
+                            TRACE_INFO("Found trapezoid at leaf node.");
                         } else {
                             highlightedTrap = NULL;
                             highlightedNode = NULL;
@@ -117,11 +120,8 @@ void trapezoidal_map_demo() {
                                 if (node->type == LEAF_NODE) {
                                     highlightedTrap = node->trapezoid;
                                 }
-                                std::cout << "Clicked on ";
-                                if (node->type == X_NODE) std::cout << "X-Node";
-                                else if (node->type == Y_NODE) std::cout << "Y-Node";
-                                else std::cout << "Leaf Node";
-                                std::cout << std::endl;
+                                TRACE_INFO("Clicked on " << (node->type == X_NODE ? "X-Node" :
+                                                             node->type == Y_NODE ? "Y-Node" : "Leaf Node"));
                                 break;
                             }
                         }
@@ -172,9 +172,10 @@ void trapezoidal_map_demo() {
         }
 
         SDL_RenderPresent(renderer);
+        trace::flush();
     }
 
-    std::cout << "Cleaning up..." << std::endl;
+    TRACE_INFO("Cleaning up...");
     if (font) TTF_CloseFont(font);
     map.cleanup();
     SDL_DestroyRenderer(renderer);
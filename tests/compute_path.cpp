@@ -0,0 +1,192 @@
+// Roadmap construction and path queries.
+//
+//   make test_compute_path && ./test_compute_path
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+
+#include "data_structure.hpp"
+#include "compute_free_space.hpp"
+#include "compute_path.hpp"
+#include "trace.hpp"
+#include "test_common.hpp"
+
+using namespace std;
+
+static bool finite(const Point& p) {
+    return isfinite(p.x) && isfinite(p.y);
+}
+
+// Every live node sits at a finite position and every edge has a finite length
+static void checkFinite(const RoadMap& roadMap) {
+    for (size_t v = 0; v < roadMap.nodeCount(); v++) {
+        if (roadMap.component[v] == ROADMAP_NONE) continue;
+        CHECK(finite(roadMap.positions[v]));
+        for (uint32_t e = roadMap.rowBegin[v]; e < roadMap.rowEnd[v]; e++) {
+            CHECK(isfinite(roadMap.lengths[e]));
+        }
+    }
+}
+
+static bool blocked(const vector<Polygon>& obstacles, const Point& p) {
+    for (const Polygon& obstacle : obstacles) {
+        if (insidePolygon(obstacle, p)) return true;
+    }
+    return false;
+}
+
+// Axis-aligned obstacles leave zero-width trapezoids along their vertical
+// edges. Their roadmap nodes must be finite and keep the free space around
+// the obstacles connected, and every search has to return a valid path.
+static void checkVerticalEdges(const char* name, const vector<Polygon>& obstacles,
+                               double x1, double y1, double x2, double y2) {
+    int before = testFailures;
+    for (unsigned seed = 1; seed <= 10; seed++) {
+        TrapezoidalMap map = FreeSpaceComputer::COMPUTEFREESPACE(obstacles, seed);
+        RoadMap roadMap = PathComputer::buildRoadMap(map);
+        checkFinite(roadMap);
+
+        mt19937 rng(seed);
+        uniform_real_distribution<double> ux(x1, x2), uy(y1, y2);
+        vector<Point> points;
+        while (points.size() < 20) {
+            Point p(ux(rng), uy(rng));
+            if (!blocked(obstacles, p)) points.push_back(p);
+        }
+
+        SearchScratch scratch;
+        vector<Point> path;
+        for (size_t i = 0; i + 1 < points.size(); i++) {
+            for (SearchAlgorithm algorithm : {SEARCH_BFS, SEARCH_ASTAR}) {
+                PathStatus status = PathComputer::queryPath(map, roadMap, points[i], points[i + 1],
+                                                            scratch, path, algorithm);
+                CHECK(status == PATH_FOUND);
+                for (const Point& p : path) CHECK(finite(p));
+                CHECK(PathComputer::isValidPath(map, path));
+            }
+            PathStatus status = PathComputer::queryTautPath(map, roadMap, points[i], points[i + 1],
+                                                            scratch, path);
+            CHECK(status == PATH_FOUND);
+            CHECK(PathComputer::isValidPath(map, path));
+        }
+        map.cleanup();
+    }
+    if (testFailures != before) cerr << "  in scene " << name << endl;
+}
+
+// updateRoadMap places the nodes of the trapezoids an insertion creates the
+// same way
+static void checkInsertedVerticalEdges() {
+    vector<Polygon> obstacles = {rectangle(1, 1, 3, 3), rectangle(5, 1, 7, 3)};
+    TrapezoidalMap map = FreeSpaceComputer::COMPUTEFREESPACE(obstacles);
+    RoadMap roadMap = PathComputer::buildRoadMap(map);
+    MapUpdate update;
+    CHECK(FreeSpaceComputer::insertObstacle(map, rectangle(3.5, 1.5, 4.5, 2.5), 2, update));
+    PathComputer::updateRoadMap(roadMap, map, update);
+    checkFinite(roadMap);
+
+    SearchScratch scratch;
+    vector<Point> path;
+    CHECK(PathComputer::queryPath(map, roadMap, Point(0.5, 2), Point(7.5, 2), scratch, path,
+                                  SEARCH_ASTAR) == PATH_FOUND);
+    CHECK(PathComputer::isValidPath(map, path));
+    map.cleanup();
+}
+
+// Free points are mutually reachable in the roadmap iff they are in the same
+// region
+static void checkComponents(const TrapezoidalMap& map, const RoadMap& roadMap,
+                            const vector<Point>& points, const vector<int>& regions) {
+    vector<uint32_t> labels;
+    for (const Point& p : points) {
+        uint32_t v = roadMap.getNodeForTrapezoid(PathComputer::findTrapezoidContainingPoint(map, p));
+        CHECK(v != ROADMAP_NONE);
+        labels.push_back(v == ROADMAP_NONE ? ROADMAP_NONE : roadMap.component[v]);
+    }
+    for (size_t i = 0; i < points.size(); i++) {
+        for (size_t j = i + 1; j < points.size(); j++) {
+            CHECK((labels[i] == labels[j]) == (regions[i] == regions[j]));
+        }
+    }
+}
+
+// An obstacle touching two others can close a pocket off: the roadmap
+// update has to split the region's label, and join it again when the lid
+// is taken out
+static void checkSplittingInsertion() {
+    vector<Polygon> obstacles = {rectangle(0, 0, 1, 4), rectangle(3, 0, 4, 4), rectangle(1, 0, 3, 1),
+                                 rectangle(6, 6, 7, 7)};
+    Polygon lid = rectangle(1, 4, 3, 5);
+    vector<Point> points = {Point(2, 2), Point(1.5, 3.5), Point(5, 2), Point(2, 6), Point(-0.5, 2)};
+    for (unsigned seed = 1; seed <= 10; seed++) {
+        TrapezoidalMap map = FreeSpaceComputer::COMPUTEFREESPACE(obstacles, seed);
+        RoadMap roadMap = PathComputer::buildRoadMap(map);
+        SearchScratch scratch;
+        vector<Point> path;
+        CHECK(PathComputer::queryPath(map, roadMap, Point(2, 2), Point(5, 2), scratch, path,
+                                      SEARCH_ASTAR) == PATH_FOUND);
+
+        MapUpdate update;
+        CHECK(FreeSpaceComputer::insertObstacle(map, lid, 4, update));
+        PathComputer::updateRoadMap(roadMap, map, update);
+        checkComponents(map, roadMap, points, {0, 0, 1, 1, 1});
+        CHECK(PathComputer::queryPath(map, roadMap, Point(2, 2), Point(5, 2), scratch, path,
+                                      SEARCH_ASTAR) == PATH_DISCONNECTED);
+        CHECK(PathComputer::queryPath(map, roadMap, Point(2, 2), Point(1.5, 3.5), scratch, path,
+                                      SEARCH_ASTAR) == PATH_FOUND);
+
+        CHECK(FreeSpaceComputer::removeObstacle(map, lid, update));
+        PathComputer::updateRoadMap(roadMap, map, update);
+        checkComponents(map, roadMap, points, {0, 0, 0, 0, 0});
+        CHECK(PathComputer::queryPath(map, roadMap, Point(2, 2), Point(5, 2), scratch, path,
+                                      SEARCH_ASTAR) == PATH_FOUND);
+        map.cleanup();
+    }
+}
+
+// isValidPath has to reject paths through obstacles and out of the map, not
+// only accept the ones the searches return
+static void checkInvalidPaths() {
+    vector<Polygon> obstacles = {rectangle(1, 1, 3, 3), rectangle(5, 1, 7, 3)};
+    for (unsigned seed = 1; seed <= 10; seed++) {
+        TrapezoidalMap map = FreeSpaceComputer::COMPUTEFREESPACE(obstacles, seed);
+
+        // Clear of both obstacles, and touching a boundary
+        CHECK(PathComputer::isValidPath(map, {Point(0.5, 0.5), Point(7.5, 0.5)}));
+        CHECK(PathComputer::isValidPath(map, {Point(0.5, 2), Point(1, 2)}));
+        CHECK(PathComputer::isValidPath(map, {Point(0.5, 0.5), Point(1, 1), Point(4, 1)}));
+        CHECK(PathComputer::isValidPath(map, {Point(4, 2), Point(4, 2)}));
+
+        // Crossing an obstacle, lying inside one, and leaving the map
+        CHECK(!PathComputer::isValidPath(map, {Point(0.5, 2), Point(4, 2)}));
+        CHECK(!PathComputer::isValidPath(map, {Point(0.5, 2), Point(1.1, 2)}));
+        CHECK(!PathComputer::isValidPath(map, {Point(4, 0.5), Point(6, 2.5)}));
+        CHECK(!PathComputer::isValidPath(map, {Point(1.5, 1.5), Point(2.5, 2.5)}));
+        CHECK(!PathComputer::isValidPath(map, {Point(6, 2), Point(6, 2)}));
+        CHECK(!PathComputer::isValidPath(map, {Point(0.5, 2), Point(-100, 2)}));
+        CHECK(!PathComputer::isValidPath(map, {Point(4, 2), Point(4, 100)}));
+
+        // One bad leg spoils the whole path
+        CHECK(!PathComputer::isValidPath(map, {Point(0.5, 0.5), Point(4, 0.5), Point(4, 4),
+                                               Point(6, 2)}));
+        CHECK(!PathComputer::isValidPath(map, {}));
+        map.cleanup();
+    }
+}
+
+int main() {
+    trace::setLevel(TRACE_LEVEL_ERROR);
+
+    checkVerticalEdges("two rectangles", {rectangle(1, 1, 3, 3), rectangle(5, 1, 7, 3)},
+                       0.5, 0.5, 7.5, 3.5);
+    checkVerticalEdges("rectangle column", {rectangle(1, 0, 2, 1), rectangle(1, 2, 2, 3),
+                                            rectangle(1, 4, 2, 5), rectangle(3, 1, 4, 4)},
+                       0.5, -0.4, 4.4, 5.4);
+    checkInsertedVerticalEdges();
+    checkSplittingInsertion();
+    checkInvalidPaths();
+
+    return testResult("compute_path");
+}
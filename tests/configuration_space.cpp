@@ -0,0 +1,94 @@
+// Configuration spaces of concave and overlapping obstacles: the free
+// notches of the grown and merged outlines have to stay reachable.
+//
+//   make test_configuration_space && ./test_configuration_space
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "data_structure.hpp"
+#include "compute_path.hpp"
+#include "configuration_space.hpp"
+#include "trace.hpp"
+#include "test_common.hpp"
+
+using namespace std;
+
+static Point rotated(const Point& p, double angle) {
+    double c = cos(angle), s = sin(angle);
+    return Point(c * p.x - s * p.y, s * p.x + c * p.y);
+}
+
+static Polygon rotated(const Polygon& polygon, double angle) {
+    Polygon out;
+    for (const Point& v : polygon.vertices) out.vertices.push_back(rotated(v, angle));
+    return out;
+}
+
+// Plan from outside the dock to a point deep in its notch and back, with
+// every search
+static void checkReachable(const char* name, const Polygon& robot, const vector<Polygon>& obstacles,
+                           const Point& outside, const Point& notch) {
+    int before = testFailures;
+    for (unsigned seed = 1; seed <= 5; seed++) {
+        ConfigurationSpace space;
+        buildConfigurationSpace(space, robot, obstacles, 1, seed);
+        SearchScratch scratch;
+        vector<Point> path;
+        for (SearchAlgorithm algorithm : {SEARCH_BFS, SEARCH_ASTAR}) {
+            CHECK(PathComputer::queryPath(space.freeSpace, space.roadMap, outside, notch, scratch, path,
+                                          algorithm) == PATH_FOUND);
+            CHECK(PathComputer::isValidPath(space.freeSpace, path));
+            CHECK(PathComputer::queryPath(space.freeSpace, space.roadMap, notch, outside, scratch, path,
+                                          algorithm) == PATH_FOUND);
+        }
+        CHECK(PathComputer::queryTautPath(space.freeSpace, space.roadMap, outside, notch, scratch,
+                                          path) == PATH_FOUND);
+        CHECK(PathComputer::isValidPath(space.freeSpace, path));
+        space.freeSpace.cleanup();
+    }
+    if (testFailures != before) cerr << "  in scene " << name << endl;
+}
+
+// A U-shaped dock made of three overlapping rectangles, merged into one
+// concave outline, plus a far obstacle to leave room around it
+static void checkMergedDock(const char* name, double angle) {
+    Polygon robot = rectangle(-0.1, -0.1, 0.1, 0.1);
+    vector<Polygon> dock = {rectangle(0, 0, 1, 4), rectangle(3, 0, 4, 4), rectangle(0.5, 0, 3.5, 1),
+                            rectangle(8, 8, 9, 9)};
+    for (Polygon& p : dock) p = rotated(p, angle);
+    checkReachable(name, robot, dock, rotated(Point(-0.6, 2), angle), rotated(Point(2, 1.5), angle));
+}
+
+// One concave U or C dock grown by a square and by a concave L-shaped
+// robot: the decomposition's pieces overlap after growing and the pocket
+// between the arms has to survive the union
+static void checkGrownDock(const char* name, const Polygon& dock, double angle,
+                           const Point& outside, const Point& pocket) {
+    Polygon square = rectangle(-0.25, -0.25, 0.25, 0.25);
+    Polygon ell = polygon({Point(-0.2, -0.2), Point(0.3, -0.2), Point(0.3, 0), Point(0, 0),
+                           Point(0, 0.3), Point(-0.2, 0.3)});
+    vector<Polygon> obstacles = {rotated(dock, angle), rectangle(8, 8, 9, 9)};
+    for (const Polygon& robot : {square, ell}) {
+        checkReachable(name, robot, obstacles, rotated(outside, angle), rotated(pocket, angle));
+    }
+}
+
+int main() {
+    trace::setLevel(TRACE_LEVEL_ERROR);
+
+    checkMergedDock("merged U dock", 0);
+    checkMergedDock("merged U dock, skewed", 0.4);
+
+    Polygon u = polygon({Point(0, 0), Point(4, 0), Point(4, 4), Point(3, 4), Point(3, 1),
+                         Point(1, 1), Point(1, 4), Point(0, 4)});
+    Polygon c = polygon({Point(0, 0), Point(4, 0), Point(4, 1), Point(1, 1), Point(1, 3),
+                         Point(4, 3), Point(4, 4), Point(0, 4)});
+    checkGrownDock("grown U dock", u, 0, Point(-0.6, 2), Point(2, 1.8));
+    checkGrownDock("grown U dock, skewed", u, 0.4, Point(-0.6, 2), Point(2, 1.8));
+    checkGrownDock("grown C dock", c, 0, Point(-0.6, 2), Point(1.8, 2));
+    checkGrownDock("grown C dock, skewed", c, -0.3, Point(-0.6, 2), Point(1.8, 2));
+
+    return testResult("configuration_space");
+}
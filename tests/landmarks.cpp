@@ -0,0 +1,159 @@
+// Landmark tables and ALT search.
+//
+//   make test_landmarks && ./test_landmarks
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+
+#include "data_structure.hpp"
+#include "compute_free_space.hpp"
+#include "compute_path.hpp"
+#include "landmarks.hpp"
+#include "trace.hpp"
+#include "test_common.hpp"
+
+using namespace std;
+
+static double pathLength(const vector<Point>& path) {
+    double length = 0;
+    for (size_t i = 1; i < path.size(); i++) {
+        length += hypot(path[i].x - path[i - 1].x, path[i].y - path[i - 1].y);
+    }
+    return length;
+}
+
+// ALT has to find paths exactly as short as plain A* on a scene with
+// vertical edges, whose zero-width trapezoids used to carry infinite lengths
+static void checkAltMatchesAStar() {
+    vector<Polygon> obstacles = {rectangle(1, 1, 3, 3), rectangle(5, 1, 7, 3), rectangle(3, 4, 5, 6)};
+    TrapezoidalMap map = FreeSpaceComputer::COMPUTEFREESPACE(obstacles);
+    RoadMap roadMap = PathComputer::buildRoadMap(map);
+    LandmarkTable landmarks = buildLandmarkTable(roadMap, 4);
+    CHECK(landmarks.count() == 4);
+    CHECK(landmarks.matches(roadMap));
+
+    mt19937 rng(1);
+    uniform_real_distribution<double> ux(0.5, 7.5), uy(0.5, 6.5);
+    SearchScratch scratch;
+    vector<Point> aStar, alt;
+    int found = 0;
+    for (int q = 0; q < 200; q++) {
+        Point start(ux(rng), uy(rng)), goal(ux(rng), uy(rng));
+        PathStatus a = PathComputer::queryPath(map, roadMap, start, goal, scratch, aStar, SEARCH_ASTAR);
+        PathStatus b = PathComputer::queryPath(map, roadMap, start, goal, scratch, alt, SEARCH_ALT,
+                                               &landmarks);
+        CHECK(a == b);
+        if (a != PATH_FOUND) continue;
+        found++;
+        CHECK(fabs(pathLength(aStar) - pathLength(alt)) < 1e-9);
+    }
+    CHECK(found > 100);
+    map.cleanup();
+}
+
+// A hand-made roadmap with an edge of infinite length: the table has to be
+// built without taking it, leaving the node behind it unreached
+static void checkNonFiniteLength() {
+    RoadMap roadMap;
+    roadMap.positions = {Point(0, 0), Point(1, 0), Point(2, 0)};
+    roadMap.rowBegin = {0, 1, 3};
+    roadMap.rowEnd = {1, 3, 4};
+    roadMap.neighbors = {1, 0, 2, 1};
+    roadMap.lengths = {1, 1, INFINITY, INFINITY};
+    roadMap.nodeTrapezoid.assign(3, NULL);
+    roadMap.component.assign(3, 0);
+    roadMap.componentCount = 1;
+
+    LandmarkTable landmarks = buildLandmarkTable(roadMap, 2);
+    CHECK(landmarks.count() >= 1);
+    for (size_t j = 0; j < landmarks.count(); j++) {
+        CHECK(landmarks.landmarks[j] != 2);
+        CHECK(isfinite(landmarks.row(0)[j]) && isfinite(landmarks.row(1)[j]));
+        CHECK(landmarks.row(2)[j] == INFINITY);
+    }
+}
+
+static const char* const TABLE_FILE = "test_landmarks.tmp";
+
+static void writeFile(const string& contents) {
+    FILE* f = fopen(TABLE_FILE, "wb");
+    fwrite(contents.data(), 1, contents.size(), f);
+    fclose(f);
+}
+
+static string readFile() {
+    string contents;
+    FILE* f = fopen(TABLE_FILE, "rb");
+    for (int c; f && (c = fgetc(f)) != EOF;) contents.push_back(static_cast<char>(c));
+    if (f) fclose(f);
+    return contents;
+}
+
+template <typename T>
+static void append(string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// A failed load leaves the table as it was
+static void checkRejected(const char* what, const string& contents, const LandmarkTable& good) {
+    writeFile(contents);
+    LandmarkTable table = good;
+    trace::setLevel(TRACE_LEVEL_OFF);
+    bool loaded = loadLandmarkTable(table, TABLE_FILE);
+    trace::setLevel(TRACE_LEVEL_ERROR);
+    CHECK(!loaded);
+    CHECK(table.count() == good.count() && table.distances == good.distances);
+    if (loaded) cerr << "  accepted " << what << endl;
+}
+
+// Tables round trip through a file; truncated files and headers whose counts
+// do not match the file size are refused without allocating for the counts
+static void checkTableFiles() {
+    vector<Polygon> obstacles = {rectangle(1, 1, 3, 3), rectangle(5, 1, 7, 3)};
+    TrapezoidalMap map = FreeSpaceComputer::COMPUTEFREESPACE(obstacles);
+    RoadMap roadMap = PathComputer::buildRoadMap(map);
+    LandmarkTable landmarks = buildLandmarkTable(roadMap, 3);
+    CHECK(saveLandmarkTable(landmarks, TABLE_FILE));
+    LandmarkTable loaded;
+    CHECK(loadLandmarkTable(loaded, TABLE_FILE));
+    CHECK(loaded.matches(roadMap) && loaded.landmarks == landmarks.landmarks);
+    CHECK(loaded.distances == landmarks.distances);
+
+    string file = readFile();
+    CHECK(file.size() == 24 + 3 * 4 + landmarks.nodeCount * 3 * 8);
+    checkRejected("truncated", file.substr(0, file.size() - 1), landmarks);
+    checkRejected("header only", file.substr(0, 24), landmarks);
+    checkRejected("trailing byte", file + '\0', landmarks);
+
+    string huge("TMLT");
+    append<uint32_t>(huge, 1);
+    append<uint64_t>(huge, 0);
+    append<uint32_t>(huge, 0xF0000000u);
+    append<uint32_t>(huge, 0xE0000000u);
+    checkRejected("huge counts", huge, landmarks);
+
+    // Counts whose product is as large as the file, but not their sum
+    string skewed = file.substr(0, 16);
+    append<uint32_t>(skewed, landmarks.nodeCount * 3);
+    append<uint32_t>(skewed, 1);
+    skewed += file.substr(24);
+    checkRejected("skewed counts", skewed, landmarks);
+
+    remove(TABLE_FILE);
+    map.cleanup();
+}
+
+int main() {
+    trace::setLevel(TRACE_LEVEL_ERROR);
+
+    checkAltMatchesAStar();
+    checkNonFiniteLength();
+    checkTableFiles();
+
+    return testResult("landmarks");
+}
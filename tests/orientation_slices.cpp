@@ -0,0 +1,113 @@
+// Orientation slices: planning for a robot that has to turn to get through.
+//
+//   make test_orientation_slices && ./test_orientation_slices
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "data_structure.hpp"
+#include "orientation_slices.hpp"
+#include "trace.hpp"
+#include "test_common.hpp"
+
+using namespace std;
+
+static const size_t SLICES = 8;
+
+static bool isFree(const OrientationSlices& space, double angle, const Point& p) {
+    const TrapezoidalMap& map = space.slices[space.sliceFor(angle)].freeSpace;
+    return map.contains(PathComputer::findTrapezoidContainingPoint(map, p));
+}
+
+// Angle between two headings, the short way round
+static double turnAngle(double a, double b) {
+    double d = fmod(fabs(a - b), 2 * M_PI);
+    return min(d, 2 * M_PI - d);
+}
+
+// Every step is a straight move inside the free space of one slice, or a
+// turn on the spot of at most one slice width between free poses
+static void checkPosePath(const OrientationSlices& space, const vector<Pose>& path) {
+    double width = 2 * M_PI / space.sliceCount();
+    for (size_t i = 0; i + 1 < path.size(); i++) {
+        const Pose& a = path[i];
+        const Pose& b = path[i + 1];
+        if (a.angle == b.angle) {
+            vector<Point> move = {a.position, b.position};
+            CHECK(PathComputer::isValidPath(space.slices[space.sliceFor(a.angle)].freeSpace, move));
+        } else {
+            CHECK(a.position.equals(b.position));
+            CHECK(turnAngle(a.angle, b.angle) <= width + 1e-9);
+            CHECK(isFree(space, a.angle, a.position) && isFree(space, b.angle, b.position));
+        }
+    }
+}
+
+// A bar too long to stand across either of two corridors at right angles:
+// it has to drive out of the horizontal one lying along it, turn a quarter
+// in the open, and go up the vertical one. Both are open at the ends, since
+// the union keeps outer boundaries only and a closed pocket would be lost.
+static void checkCorridor() {
+    vector<Polygon> obstacles = {rectangle(0, 0, 4, 1), rectangle(0, 1.8, 4, 2.8),
+                                 rectangle(6, 3, 7, 7), rectangle(7.8, 3, 8.8, 7)};
+    Polygon bar = rectangle(-0.6, -0.05, 0.6, 0.05);
+    OrientationSlices space;
+    buildOrientationSlices(space, bar, obstacles, SLICES);
+    CHECK(space.sliceCount() == SLICES);
+
+    SearchScratch scratch;
+    vector<Pose> path;
+    Pose start(Point(2, 1.4), 0), goal(Point(7.4, 5), M_PI / 2);
+    CHECK(queryOrientationPath(space, start, goal, scratch, path) == PATH_FOUND);
+    CHECK(path.size() >= 2);
+    if (path.size() >= 2) {
+        CHECK(path.front().position.equals(start.position) && path.back().position.equals(goal.position));
+        CHECK(space.sliceFor(path.front().angle) == 0 && space.sliceFor(path.back().angle) == 2);
+    }
+    checkPosePath(space, path);
+    double turned = 0;
+    for (size_t i = 0; i + 1 < path.size(); i++) turned += turnAngle(path[i].angle, path[i + 1].angle);
+    CHECK(turned >= M_PI / 2 - 1e-9);
+
+    // Across a corridor the bar does not fit, and inside a wall nothing does
+    CHECK(queryOrientationPath(space, Pose(Point(2, 1.4), M_PI / 2), goal, scratch, path)
+          == PATH_START_BLOCKED);
+    CHECK(queryOrientationPath(space, Pose(Point(2, 0.5), 0), goal, scratch, path) == PATH_START_BLOCKED);
+    CHECK(queryOrientationPath(space, start, Pose(Point(7.4, 5), 0), scratch, path) == PATH_GOAL_BLOCKED);
+    CHECK(queryOrientationPath(space, start, Pose(Point(6.5, 5), M_PI / 2), scratch, path)
+          == PATH_GOAL_BLOCKED);
+    CHECK(path.empty());
+
+    for (ConfigurationSpace& slice : space.slices) slice.freeSpace.cleanup();
+}
+
+// Headings wrap: negative angles and angles past 2 pi land in the slice of
+// the same heading
+static void checkSliceFor() {
+    OrientationSlices space;
+    buildOrientationSlices(space, rectangle(-0.1, -0.1, 0.1, 0.1), {rectangle(0, 0, 1, 1)}, SLICES);
+    double width = 2 * M_PI / SLICES;
+    for (size_t k = 0; k < SLICES; k++) {
+        double angle = k * width + 0.3 * width;
+        CHECK(space.sliceFor(angle) == k);
+        CHECK(space.sliceFor(angle - 2 * M_PI) == k);
+        CHECK(space.sliceFor(angle - 6 * M_PI) == k);
+        CHECK(space.sliceFor(angle + 2 * M_PI) == k);
+        CHECK(space.sliceFor(angle + 10 * M_PI) == k);
+    }
+    CHECK(space.sliceFor(-0.1) == 0);
+    CHECK(space.sliceFor(2 * M_PI - 0.1) == 0);
+    CHECK(space.sliceFor(-M_PI / 2) == 6);
+    CHECK(space.sliceFor(2 * M_PI + M_PI / 4) == 1);
+    for (ConfigurationSpace& slice : space.slices) slice.freeSpace.cleanup();
+}
+
+int main() {
+    trace::setLevel(TRACE_LEVEL_ERROR);
+
+    checkCorridor();
+    checkSliceFor();
+
+    return testResult("orientation_slices");
+}
@@ -0,0 +1,110 @@
+// Scene files: round trips and malformed input.
+//
+//   make test_scene_io && ./test_scene_io
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+
+#include "data_structure.hpp"
+#include "scene_io.hpp"
+#include "trace.hpp"
+#include "test_common.hpp"
+
+using namespace std;
+
+static const char* const SCENE_FILE = "test_scene_io.tmp";
+
+static void writeFile(const string& contents) {
+    FILE* f = fopen(SCENE_FILE, "wb");
+    fwrite(contents.data(), 1, contents.size(), f);
+    fclose(f);
+}
+
+template <typename T>
+static void append(string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static string binaryHeader(uint32_t polygonCount, uint32_t queryCount) {
+    string out("TMSC");
+    append<uint32_t>(out, 1);
+    append<uint32_t>(out, polygonCount);
+    append<uint32_t>(out, queryCount);
+    return out;
+}
+
+static string binaryTriangle(double x) {
+    string out;
+    append<uint32_t>(out, 3);
+    for (double v : {x, 0.0, x + 1, 0.0, x, 1.0}) append(out, v);
+    return out;
+}
+
+// A failed load leaves the scene as it was
+static void checkRejected(const char* what, const string& contents) {
+    writeFile(contents);
+    Scene scene;
+    scene.obstacles.push_back(rectangle(0, 0, 1, 1));
+    bool loaded = loadScene(scene, SCENE_FILE);
+    CHECK(!loaded);
+    CHECK(scene.obstacles.size() == 1 && scene.starts.empty());
+    if (loaded) cerr << "  accepted " << what << endl;
+}
+
+static void checkRoundTrip() {
+    writeFile("# two obstacles\n"
+              "polygon 0 0 1 0 0.5 1\n"
+              "polygon +2 0 3 0 2.5 1e0  # trailing comment\n"
+              "query 0.5 -1 2.5 2\n");
+    Scene text;
+    CHECK(loadScene(text, SCENE_FILE));
+    CHECK(text.obstacles.size() == 2 && text.starts.size() == 1);
+
+    CHECK(saveSceneBinary(text, SCENE_FILE));
+    Scene binary;
+    CHECK(loadScene(binary, SCENE_FILE));
+    CHECK(binary.obstacles.size() == 2 && binary.starts.size() == 1);
+    for (size_t i = 0; i < text.obstacles.size() && i < binary.obstacles.size(); i++) {
+        CHECK(text.obstacles[i].vertices.size() == binary.obstacles[i].vertices.size());
+        for (size_t j = 0; j < text.obstacles[i].vertices.size(); j++) {
+            CHECK(text.obstacles[i].vertices[j].equals(binary.obstacles[i].vertices[j]));
+        }
+    }
+}
+
+int main() {
+    trace::setLevel(TRACE_LEVEL_OFF);
+
+    checkRoundTrip();
+
+    // Text coordinates from_chars reads but no scene can use
+    checkRejected("nan", "polygon 0 0 1 0 nan 1\n");
+    checkRejected("inf", "polygon 0 0 inf 0 0.5 1\n");
+    checkRejected("-inf query", "polygon 0 0 1 0 0.5 1\nquery 0 0 -inf 1\n");
+    checkRejected("overflow", "polygon 0 0 1e400 0 0.5 1\n");
+    checkRejected("short polygon", "polygon 0 0 1 0\n");
+    checkRejected("odd coordinates", "polygon 0 0 1 0 0.5\n");
+
+    // Binary counts larger than the file can hold must fail before any
+    // allocation of that size
+    checkRejected("huge polygon count", binaryHeader(0xFFFFFFFFu, 0));
+    checkRejected("polygon count one too many", binaryHeader(2, 0) + binaryTriangle(0));
+    checkRejected("huge query count", binaryHeader(1, 0x10000000u) + binaryTriangle(0));
+    checkRejected("truncated", (binaryHeader(2, 0) + binaryTriangle(0) + binaryTriangle(2)).substr(0, 100));
+
+    string nanVertex = binaryHeader(1, 0);
+    append<uint32_t>(nanVertex, 3);
+    for (double v : {0.0, 0.0, 1.0, 0.0, nan(""), 1.0}) append(nanVertex, v);
+    checkRejected("binary nan", nanVertex);
+
+    string infQuery = binaryHeader(1, 1) + binaryTriangle(0);
+    for (double v : {0.0, 0.0, HUGE_VAL, 1.0}) append(infQuery, v);
+    checkRejected("binary inf query", infQuery);
+
+    remove(SCENE_FILE);
+    return testResult("scene_io");
+}
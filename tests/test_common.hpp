@@ -0,0 +1,139 @@
+// Helpers shared by the test drivers.
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <set>
+#include <cmath>
+
+#include "data_structure.hpp"
+#include "trapezoidal_map.hpp"
+
+// A failed check is reported and counted; the driver carries on so one run
+// shows every failure
+static int testFailures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: "  \
+                      << #cond << std::endl;                                \
+            testFailures++;                                                 \
+        }                                                                   \
+    } while (0)
+
+// Exit code for main
+inline int testResult(const char* name) {
+    if (testFailures) {
+        std::cerr << name << ": " << testFailures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << name << ": ok" << std::endl;
+    return 0;
+}
+
+inline Polygon rectangle(double x1, double y1, double x2, double y2) {
+    Polygon p;
+    p.addVertex(x1, y1);
+    p.addVertex(x2, y1);
+    p.addVertex(x2, y2);
+    p.addVertex(x1, y2);
+    return p;
+}
+
+inline Polygon polygon(std::initializer_list<Point> vertices) {
+    Polygon p;
+    p.vertices.assign(vertices.begin(), vertices.end());
+    return p;
+}
+
+// Even-odd rule; p must not lie on the boundary
+inline bool insidePolygon(const Polygon& polygon, const Point& p) {
+    bool inside = false;
+    size_t n = polygon.vertices.size();
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        const Point& a = polygon.vertices[i];
+        const Point& b = polygon.vertices[j];
+        if ((a.y > p.y) != (b.y > p.y) &&
+            p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// Does t cover p? x-ranges are compared lexicographically, as the x-nodes
+// of the search structure do, and the sides with a little slack.
+inline bool covers(const Trapezoid* t, const Point& p) {
+    if (p < t->leftp || t->rightp < p) return false;
+    auto side = [&p](const Segment* s) {
+        Point a = s->getLeftEndpoint();
+        Point b = s->getRightEndpoint();
+        return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+    };
+    return side(t->top) <= 1e-9 && side(t->bottom) >= -1e-9;
+}
+
+// Structural invariants of a map: every listed trapezoid hangs off its own
+// leaf, neighbour links are symmetric and meet at the same wall point, and
+// every leaf of the search structure holds a live trapezoid. With
+// allListed, every leaf must also be listed (a map straight from
+// BuildTrapezoidalMap; free-space maps keep interior trapezoids in the DAG).
+inline void checkMap(const TrapezoidalMap& map, bool allListed) {
+    std::set<const Trapezoid*> listed(map.trapezoids.begin(), map.trapezoids.end());
+    CHECK(listed.size() == map.trapezoids.size());
+    for (size_t i = 0; i < map.trapezoids.size(); i++) {
+        const Trapezoid* t = map.trapezoids[i];
+        CHECK(t->slot == static_cast<int>(i));
+        CHECK(t->top && t->bottom);
+        CHECK(!(t->rightp < t->leftp));
+        CHECK(t->node && t->node->type == LEAF_NODE && t->node->trapezoid == t);
+        for (const Trapezoid* n : {t->upperRight, t->lowerRight}) {
+            if (!n) continue;
+            CHECK(n->upperLeft == t || n->lowerLeft == t);
+            CHECK(n->leftp.equals(t->rightp));
+        }
+        for (const Trapezoid* n : {t->upperLeft, t->lowerLeft}) {
+            if (!n) continue;
+            CHECK(n->upperRight == t || n->lowerRight == t);
+            CHECK(n->rightp.equals(t->leftp));
+        }
+    }
+
+    std::set<const Node*> seen;
+    std::vector<const Node*> stack(1, map.root);
+    size_t leaves = 0;
+    while (!stack.empty()) {
+        const Node* n = stack.back();
+        stack.pop_back();
+        CHECK(n != NULL);
+        if (!n || !seen.insert(n).second) continue;
+        if (n->type == LEAF_NODE) {
+            CHECK(n->trapezoid && n->trapezoid->node == n);
+            if (allListed) CHECK(listed.count(n->trapezoid) == 1);
+            leaves++;
+        } else if (n->type == X_NODE) {
+            stack.push_back(n->left);
+            stack.push_back(n->right);
+        } else {
+            CHECK(n->segment != NULL);
+            stack.push_back(n->above);
+            stack.push_back(n->below);
+        }
+    }
+    if (allListed) CHECK(leaves == map.trapezoids.size());
+}
+
+// Locate random points and check that the trapezoid found covers them
+inline void checkLocation(const TrapezoidalMap& map, double x1, double y1, double x2, double y2,
+                          int samples, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> ux(x1, x2), uy(y1, y2);
+    for (int i = 0; i < samples; i++) {
+        Point p(ux(rng), uy(rng));
+        Node* leaf = queryTrapezoidMap(map.root, p);
+        CHECK(leaf && leaf->type == LEAF_NODE && covers(leaf->trapezoid, p));
+    }
+}
@@ -0,0 +1,200 @@
+// Trapezoidal map construction on input that breaks general position:
+// vertical edges, vertices sharing an x-coordinate and obstacles touching
+// each other, and deletion of segments sharing endpoints. Every scene is
+// built in many insertion orders.
+//
+//   make test_trapezoidal_map && ./test_trapezoidal_map
+
+#include <iostream>
+#include <vector>
+#include <random>
+
+#include "data_structure.hpp"
+#include "trapezoidal_map.hpp"
+#include "compute_free_space.hpp"
+#include "frozen_map.hpp"
+#include "trace.hpp"
+#include "test_common.hpp"
+
+using namespace std;
+
+static const unsigned SEEDS = 40;
+
+// The frozen copy of the search structure, walked one point at a time and in
+// batches, has to locate points exactly as the DAG does
+static void checkFrozen(const TrapezoidalMap& map, double x1, double y1, double x2, double y2,
+                        unsigned seed) {
+    FrozenSearchStructure fs = freezeSearchStructure(map);
+    CHECK(fs.nodeCount() > 0 && fs.trapezoids.size() == map.trapezoids.size());
+    mt19937 rng(seed);
+    uniform_real_distribution<double> ux(x1, x2), uy(y1, y2);
+    vector<double> xs(101), ys(101);
+    for (size_t i = 0; i < xs.size(); i++) {
+        xs[i] = ux(rng);
+        ys[i] = uy(rng);
+    }
+    vector<Trapezoid*> batch(xs.size());
+    queryFrozenBatch(fs, xs.data(), ys.data(), xs.size(), batch.data());
+    for (size_t i = 0; i < xs.size(); i++) {
+        Point p(xs[i], ys[i]);
+        Trapezoid* t = queryTrapezoidMap(map.root, p)->trapezoid;
+        CHECK(queryFrozenStructure(fs, p) == t);
+        CHECK(batch[i] == t);
+    }
+}
+
+// Build the map and the free space in every order and check both: points
+// strictly inside an obstacle have to land on a removed trapezoid, points
+// clear of every obstacle on a listed one
+static void checkScene(const char* name, const vector<Polygon>& obstacles) {
+    int before = testFailures;
+    vector<Segment> edges = FreeSpaceComputer::extractEdges(obstacles);
+    double x1 = 1e9, y1 = 1e9, x2 = -1e9, y2 = -1e9;
+    for (const Segment& s : edges) {
+        x1 = min(x1, min(s.p1.x, s.p2.x));
+        x2 = max(x2, max(s.p1.x, s.p2.x));
+        y1 = min(y1, min(s.p1.y, s.p2.y));
+        y2 = max(y2, max(s.p1.y, s.p2.y));
+    }
+
+    for (unsigned seed = 1; seed <= SEEDS; seed++) {
+        vector<Segment> order(edges);
+        TrapezoidalMap map = BuildTrapezoidalMap(order, seed);
+        checkMap(map, true);
+        CHECK(map.trapezoids.size() <= 3 * edges.size() + 1);
+        checkLocation(map, x1, y1, x2, y2, 200, seed);
+        checkFrozen(map, x1, y1, x2, y2, seed);
+        map.cleanup();
+
+        TrapezoidalMap freeSpace = FreeSpaceComputer::COMPUTEFREESPACE(obstacles, seed);
+        checkMap(freeSpace, false);
+        mt19937 rng(seed);
+        uniform_real_distribution<double> ux(x1, x2), uy(y1, y2);
+        for (int i = 0; i < 200; i++) {
+            Point p(ux(rng), uy(rng));
+            bool blocked = false;
+            for (const Polygon& obstacle : obstacles) blocked = blocked || insidePolygon(obstacle, p);
+            Node* leaf = queryTrapezoidMap(freeSpace.root, p);
+            CHECK(leaf && freeSpace.contains(leaf->trapezoid) == !blocked);
+        }
+        freeSpace.cleanup();
+    }
+    if (testFailures != before) cerr << "  in scene " << name << endl;
+}
+
+// The bounding box depends on the segments, so its top and bottom only have
+// to match each other
+static bool sameSegment(const TrapezoidalMap& mapA, const Segment* a,
+                        const TrapezoidalMap& mapB, const Segment* b) {
+    for (int i = 0; i < 2; i++) {
+        if (a == mapA.segments[i] || b == mapB.segments[i]) {
+            return a == mapA.segments[i] && b == mapB.segments[i];
+        }
+    }
+    return a->getLeftEndpoint().equals(b->getLeftEndpoint()) &&
+           a->getRightEndpoint().equals(b->getRightEndpoint());
+}
+
+// Delete one segment from a map built over all of them and compare the
+// result with a map built without it: same number of trapezoids, intact
+// links and DAG, and every sample point bounded by the same segments
+static void checkDeletion(const char* name, const vector<Segment>& segments, size_t gone) {
+    int before = testFailures;
+    vector<Segment> rest(segments);
+    rest.erase(rest.begin() + gone);
+    double x1 = 1e9, y1 = 1e9, x2 = -1e9, y2 = -1e9;
+    for (const Segment& s : segments) {
+        x1 = min(x1, min(s.p1.x, s.p2.x));
+        x2 = max(x2, max(s.p1.x, s.p2.x));
+        y1 = min(y1, min(s.p1.y, s.p2.y));
+        y2 = max(y2, max(s.p1.y, s.p2.y));
+    }
+
+    for (unsigned seed = 1; seed <= SEEDS; seed++) {
+        vector<Segment> order(segments);
+        TrapezoidalMap map = BuildTrapezoidalMap(order, seed);
+        Segment* seg = findSegment(map.root, segments[gone]);
+        CHECK(seg != NULL);
+        if (!seg) {
+            map.cleanup();
+            continue;
+        }
+        vector<Trapezoid*> removed;
+        CHECK(deleteSegment(map, seg, removed));
+        CHECK(!removed.empty());
+        for (const Trapezoid* t : removed) CHECK(!map.contains(t));
+        checkMap(map, true);
+        checkLocation(map, x1, y1, x2, y2, 200, seed);
+        CHECK(findSegment(map.root, segments[gone]) == NULL);
+
+        vector<Segment> freshOrder(rest);
+        TrapezoidalMap fresh = BuildTrapezoidalMap(freshOrder, seed);
+        CHECK(map.trapezoids.size() == fresh.trapezoids.size());
+        mt19937 rng(seed);
+        uniform_real_distribution<double> ux(x1, x2), uy(y1, y2);
+        for (int i = 0; i < 200; i++) {
+            Point p(ux(rng), uy(rng));
+            const Trapezoid* a = queryTrapezoidMap(map.root, p)->trapezoid;
+            const Trapezoid* b = queryTrapezoidMap(fresh.root, p)->trapezoid;
+            CHECK(sameSegment(map, a->top, fresh, b->top));
+            CHECK(sameSegment(map, a->bottom, fresh, b->bottom));
+        }
+        fresh.cleanup();
+        map.cleanup();
+    }
+    if (testFailures != before) cerr << "  in deletion " << name << endl;
+}
+
+int main() {
+    trace::setLevel(TRACE_LEVEL_ERROR);
+
+    // Vertical edges, and rectangles stacked on the same x-coordinates
+    checkScene("rectangles", {rectangle(1, 1, 3, 3), rectangle(5, 0, 7, 4), rectangle(1, 5, 3, 7)});
+    checkScene("vertical edges in a column", {rectangle(0, 0, 1, 1), rectangle(0, 2, 1, 3),
+                                              rectangle(0, 4, 1, 5), rectangle(2, 1, 3, 4)});
+
+    // Non-vertical edges whose vertices share x-coordinates
+    checkScene("shared x", {polygon({Point(0, 0), Point(2, 0.5), Point(1, 1.5)}),
+                            polygon({Point(0, 3), Point(2, 3.5), Point(1, 4.5)}),
+                            polygon({Point(1, 2), Point(3, 2.2), Point(2, 2.8)})});
+
+    // A vertex of one obstacle on a vertex or an edge of another
+    checkScene("corners touching", {rectangle(0, 0, 1, 1), rectangle(1, 1, 2, 2)});
+    checkScene("vertex on edge", {rectangle(0, 0, 2, 1),
+                                  polygon({Point(1, 1), Point(2, 2), Point(0, 2)})});
+    checkScene("vertices on both sides", {rectangle(0, 0, 2, 1),
+                                          polygon({Point(1, 1), Point(1.5, 2), Point(0.5, 2)}),
+                                          polygon({Point(1, 1), Point(2.5, 2), Point(2, 2.2)}),
+                                          polygon({Point(1, 0), Point(1.5, -1), Point(0.5, -1)})});
+    checkScene("vertex on vertical edge", {rectangle(0, 0, 1, 2),
+                                           polygon({Point(1, 1), Point(2, 0.5), Point(2, 1.5)})});
+
+    // Concave obstacles, listed in either orientation: their notches are
+    // free although both sides belong to one polygon
+    checkScene("U", {polygon({Point(0, 0), Point(4, 0), Point(4, 4), Point(3, 4), Point(3, 1),
+                              Point(1, 1), Point(1, 4), Point(0, 4)})});
+    checkScene("U clockwise", {polygon({Point(0, 4), Point(1, 4), Point(1, 1), Point(3, 1), Point(3, 4),
+                                        Point(4, 4), Point(4, 0), Point(0, 0)})});
+    checkScene("skewed C", {polygon({Point(0, 0), Point(4, 0.8), Point(3.8, 1.8), Point(1.1, 1.3),
+                                     Point(0.7, 3.1), Point(3.4, 3.6), Point(3.2, 4.6), Point(-0.6, 3.9)})});
+
+    // Deleting a segment that shares an endpoint with others keeps the walls
+    // through it; the endpoint it alone used loses them
+    vector<Segment> v = {Segment(Point(0, 0), Point(2, 1)), Segment(Point(2, 1), Point(4, 0)),
+                         Segment(Point(0, 3), Point(4, 3))};
+    checkDeletion("one shared end", v, 0);
+    checkDeletion("one shared end, right", v, 1);
+    vector<Segment> triangles = FreeSpaceComputer::extractEdges(
+        {polygon({Point(0, 0), Point(2, 0.5), Point(1, 1.5)}),
+         polygon({Point(3, 0), Point(5, 1), Point(4, 2)})});
+    for (size_t i = 0; i < triangles.size(); i++) checkDeletion("triangle edge", triangles, i);
+    vector<Segment> star = {Segment(Point(2, 2), Point(0, 0)), Segment(Point(2, 2), Point(4, 0.5)),
+                            Segment(Point(2, 2), Point(0.5, 4)), Segment(Point(2, 2), Point(4, 3.5)),
+                            Segment(Point(2, 2), Point(2.5, 4))};
+    for (size_t i = 0; i < star.size(); i++) checkDeletion("star", star, i);
+    vector<Segment> rectangles = FreeSpaceComputer::extractEdges({rectangle(0, 0, 2, 2),
+                                                                   rectangle(3, 1, 4, 3)});
+    for (size_t i = 0; i < rectangles.size(); i++) checkDeletion("rectangle edge", rectangles, i);
+
+    return testResult("trapezoidal_map");
+}